@@ -0,0 +1,68 @@
+#pragma once
+#include <map>
+#include <string>
+#include <random>
+#include <types.h>
+
+namespace microgbt
+{
+namespace bench
+{
+
+/**
+     * Synthetic design matrix of independent standard normal features, reproducible for a given seed
+     */
+inline MatrixType syntheticMatrix(long rows, long cols, unsigned seed = 42)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> normal;
+    MatrixType X(rows, cols);
+    for (long j = 0; j < cols; j++)
+    {
+        for (long i = 0; i < rows; i++)
+        {
+            X(i, j) = normal(rng);
+        }
+    }
+    return X;
+}
+
+/**
+     * Binary targets of a synthetic matrix, i.e., a noisy linear function of its first features thresholded at 0
+     */
+inline Vector syntheticTargets(const MatrixType &X, unsigned seed = 7)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> noise(0.0, 0.5);
+    Vector y(static_cast<size_t>(X.rows()));
+    for (long i = 0; i < X.rows(); i++)
+    {
+        double margin = noise(rng);
+        for (long j = 0; j < std::min(X.cols(), 4L); j++)
+        {
+            margin += X(i, j) / static_cast<double>(j + 1);
+        }
+        y[i] = (margin > 0.0) ? 1.0 : 0.0;
+    }
+    return y;
+}
+
+/**
+     * Training parameters of the benchmarks: log loss, silent training
+     */
+inline std::map<std::string, double> params(int maxDepth, int numThreads, int treeMethod = 0)
+{
+    return {{"lambda", 1.0},
+            {"gamma", 0.0},
+            {"shrinkage_rate", 1.0},
+            {"min_split_gain", 0.0},
+            {"min_tree_size", 2.0},
+            {"learning_rate", 0.9},
+            {"max_depth", static_cast<double>(maxDepth)},
+            {"metric", 0.0},
+            {"tree_method", static_cast<double>(treeMethod)},
+            {"num_threads", static_cast<double>(numThreads)},
+            {"verbosity", 0.0}};
+}
+} // namespace bench
+} // namespace microgbt
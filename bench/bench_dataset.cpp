@@ -0,0 +1,47 @@
+#include <numeric>
+#include <dataset.h>
+#include "bench_data.h"
+#include "benchmark/benchmark.h"
+
+using namespace microgbt;
+
+// Construction of a root dataset: copy of the design matrix and sorting of every column
+static void BM_DatasetConstruction(benchmark::State &state)
+{
+    long rows = state.range(0), cols = state.range(1);
+    MatrixType X = bench::syntheticMatrix(rows, cols);
+    Vector y = bench::syntheticTargets(X);
+
+    for (auto _ : state)
+    {
+        Dataset dataset(X, y);
+        benchmark::DoNotOptimize(dataset.nRows());
+    }
+    state.SetItemsProcessed(state.iterations() * rows * cols);
+}
+BENCHMARK(BM_DatasetConstruction)
+    ->ArgNames({"rows", "features"})
+    ->ArgsProduct({{10000, 100000}, {8, 32}})
+    ->Unit(benchmark::kMillisecond);
+
+// Construction of a child dataset, i.e., stable partition of the sorted column indices of its parent
+static void BM_DatasetPartition(benchmark::State &state)
+{
+    long rows = state.range(0), cols = state.range(1);
+    MatrixType X = bench::syntheticMatrix(rows, cols);
+    Vector y = bench::syntheticTargets(X);
+    Dataset dataset(X, y);
+
+    VectorT half(static_cast<size_t>(rows / 2));
+    std::iota(half.begin(), half.end(), 0);
+    for (auto _ : state)
+    {
+        Dataset child(dataset, half);
+        benchmark::DoNotOptimize(child.nRows());
+    }
+    state.SetItemsProcessed(state.iterations() * rows * cols);
+}
+BENCHMARK(BM_DatasetPartition)
+    ->ArgNames({"rows", "features"})
+    ->ArgsProduct({{10000, 100000}, {8, 32}})
+    ->Unit(benchmark::kMillisecond);
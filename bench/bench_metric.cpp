@@ -0,0 +1,79 @@
+#include <memory>
+#include <metrics/logloss.h>
+#include <metrics/rmse.h>
+#include <utils/thread_pool.h>
+#include "bench_data.h"
+#include "benchmark/benchmark.h"
+
+using namespace microgbt;
+
+namespace
+{
+// Raw scores and targets of n samples
+void syntheticScores(size_t n, Vector &scores, Vector &targets)
+{
+    std::mt19937 rng(3);
+    std::normal_distribution<double> normal;
+    scores.resize(n);
+    targets.resize(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        scores[i] = normal(rng);
+        targets[i] = (normal(rng) > 0.0) ? 1.0 : 0.0;
+    }
+}
+
+void gradientsAndHessians(benchmark::State &state, const Metric &metric)
+{
+    size_t n = static_cast<size_t>(state.range(0));
+    int numThreads = static_cast<int>(state.range(1));
+    Vector scores, targets, gradient(n), hessian(n);
+    syntheticScores(n, scores, targets);
+    std::unique_ptr<ThreadPool> threadPool(numThreads > 1 ? new ThreadPool(numThreads) : nullptr);
+
+    for (auto _ : state)
+    {
+        metric.gradientsAndHessians(scores.data(), targets.data(), n, gradient.data(), hessian.data(),
+                                    threadPool.get());
+        benchmark::DoNotOptimize(gradient.data());
+        benchmark::DoNotOptimize(hessian.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(n * 4 * sizeof(double)));
+}
+
+void loss(benchmark::State &state, const Metric &metric)
+{
+    size_t n = static_cast<size_t>(state.range(0));
+    Vector predictions, targets;
+    syntheticScores(n, predictions, targets);
+    for (double &p : predictions)
+    {
+        p = metric.scoreToPrediction(p);
+    }
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(metric.lossAt(predictions, targets));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n));
+}
+} // namespace
+
+static void BM_LogLossGradientsAndHessians(benchmark::State &state) { gradientsAndHessians(state, LogLoss()); }
+BENCHMARK(BM_LogLossGradientsAndHessians)
+    ->ArgNames({"rows", "threads"})
+    ->ArgsProduct({{100000, 1000000}, {1, 4}})
+    ->UseRealTime();
+
+static void BM_RMSEGradientsAndHessians(benchmark::State &state) { gradientsAndHessians(state, RMSE()); }
+BENCHMARK(BM_RMSEGradientsAndHessians)
+    ->ArgNames({"rows", "threads"})
+    ->ArgsProduct({{100000, 1000000}, {1, 4}})
+    ->UseRealTime();
+
+static void BM_LogLossLoss(benchmark::State &state) { loss(state, LogLoss()); }
+BENCHMARK(BM_LogLossLoss)->ArgName("rows")->Arg(100000)->Arg(1000000);
+
+static void BM_RMSELoss(benchmark::State &state) { loss(state, RMSE()); }
+BENCHMARK(BM_RMSELoss)->ArgName("rows")->Arg(100000)->Arg(1000000);
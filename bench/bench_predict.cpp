@@ -0,0 +1,81 @@
+#include <GBT.h>
+#include "bench_data.h"
+#include "benchmark/benchmark.h"
+
+using namespace microgbt;
+
+namespace
+{
+// A model of 20 trees of the given depth, trained on a synthetic training set
+GBT trainedModel(const MatrixType &X, const Vector &y, int maxDepth)
+{
+    GBT gbt(bench::params(maxDepth, 1, 1));
+    gbt.trainPython(X, y, X, y, 20, 20);
+    return gbt;
+}
+} // namespace
+
+// Single-sample prediction of every row
+static void BM_GBTPredict(benchmark::State &state)
+{
+    long rows = state.range(0), cols = state.range(1);
+    MatrixType X = bench::syntheticMatrix(rows, cols);
+    GBT gbt = trainedModel(X, bench::syntheticTargets(X), static_cast<int>(state.range(2)));
+
+    for (auto _ : state)
+    {
+        double sum = 0.0;
+        for (long i = 0; i < rows; i++)
+        {
+            sum += gbt.predict(X.row(i), 0);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_GBTPredict)
+    ->ArgNames({"rows", "features", "depth"})
+    ->ArgsProduct({{10000, 100000}, {8, 32}, {4, 8}})
+    ->Unit(benchmark::kMillisecond);
+
+// Prediction of every sample of a dataset
+static void BM_GBTPredictDataset(benchmark::State &state)
+{
+    long rows = state.range(0), cols = state.range(1);
+    MatrixType X = bench::syntheticMatrix(rows, cols);
+    Vector y = bench::syntheticTargets(X);
+    GBT gbt = trainedModel(X, y, static_cast<int>(state.range(2)));
+    Dataset dataset(X, y);
+
+    for (auto _ : state)
+    {
+        Vector predictions = gbt.predictDataset(dataset);
+        benchmark::DoNotOptimize(predictions.data());
+    }
+    state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_GBTPredictDataset)
+    ->ArgNames({"rows", "features", "depth"})
+    ->ArgsProduct({{10000, 100000}, {8, 32}, {4, 8}})
+    ->Unit(benchmark::kMillisecond);
+
+// Batch prediction of a matrix, in parallel over blocks of rows
+static void BM_GBTPredictBatch(benchmark::State &state)
+{
+    long rows = state.range(0), cols = state.range(1);
+    MatrixType X = bench::syntheticMatrix(rows, cols);
+    GBT gbt = trainedModel(X, bench::syntheticTargets(X), static_cast<int>(state.range(2)));
+    PredictionEngine engine = (state.range(4) == 1) ? PredictionEngine::QuickScorer : PredictionEngine::TreeTraversal;
+
+    for (auto _ : state)
+    {
+        Eigen::VectorXd predictions = gbt.predictBatch(X, 0, static_cast<int>(state.range(3)), false, engine);
+        benchmark::DoNotOptimize(predictions.data());
+    }
+    state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_GBTPredictBatch)
+    ->ArgNames({"rows", "features", "depth", "threads", "quickscorer"})
+    ->ArgsProduct({{100000}, {32}, {4, 5}, {1, 4}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
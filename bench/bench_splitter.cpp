@@ -0,0 +1,74 @@
+#include <memory>
+#include <dataset.h>
+#include <binned_matrix.h>
+#include <utils/thread_pool.h>
+#include <trees/numerical_splliter.h>
+#include <trees/histogram_splitter.h>
+#include <metrics/logloss.h>
+#include "bench_data.h"
+#include "benchmark/benchmark.h"
+
+using namespace microgbt;
+
+namespace
+{
+// Gradients and Hessians of the log loss at zero raw scores
+void initialGradients(const Vector &y, Vector &gradient, Vector &hessian)
+{
+    Vector scores(y.size(), 0.0);
+    gradient.resize(y.size());
+    hessian.resize(y.size());
+    LogLoss().gradientsAndHessians(scores.data(), y.data(), y.size(), gradient.data(), hessian.data());
+}
+
+std::shared_ptr<ThreadPool> threadPool(long numThreads)
+{
+    return (numThreads > 1) ? std::make_shared<ThreadPool>(static_cast<int>(numThreads)) : nullptr;
+}
+} // namespace
+
+// Exact greedy split finding of a root node
+static void BM_NumericalSplitterFindBestSplit(benchmark::State &state)
+{
+    long rows = state.range(0), cols = state.range(1);
+    MatrixType X = bench::syntheticMatrix(rows, cols);
+    Vector y = bench::syntheticTargets(X), gradient, hessian;
+    initialGradients(y, gradient, hessian);
+    Dataset dataset(X, y);
+    NumericalSplitter splitter(1.0, threadPool(state.range(2)));
+
+    for (auto _ : state)
+    {
+        SplitInfo split = splitter.findBestSplit(dataset, gradient, hessian);
+        benchmark::DoNotOptimize(split.bestGain());
+    }
+    state.SetItemsProcessed(state.iterations() * rows * cols);
+}
+BENCHMARK(BM_NumericalSplitterFindBestSplit)
+    ->ArgNames({"rows", "features", "threads"})
+    ->ArgsProduct({{10000, 100000}, {8, 32}, {1, 4}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Histogram-based split finding of a root node, including the accumulation of its histograms
+static void BM_HistogramSplitterFindBestSplit(benchmark::State &state)
+{
+    long rows = state.range(0), cols = state.range(1);
+    MatrixType X = bench::syntheticMatrix(rows, cols);
+    Vector y = bench::syntheticTargets(X), gradient, hessian;
+    initialGradients(y, gradient, hessian);
+    Dataset dataset(X, y);
+    HistogramSplitter splitter(1.0, std::make_shared<BinnedMatrix>(dataset, 255), threadPool(state.range(2)));
+
+    for (auto _ : state)
+    {
+        SplitInfo split = splitter.findBestSplit(dataset, gradient, hessian);
+        benchmark::DoNotOptimize(split.bestGain());
+    }
+    state.SetItemsProcessed(state.iterations() * rows * cols);
+}
+BENCHMARK(BM_HistogramSplitterFindBestSplit)
+    ->ArgNames({"rows", "features", "threads"})
+    ->ArgsProduct({{10000, 100000}, {8, 32}, {1, 4}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
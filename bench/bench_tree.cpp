@@ -0,0 +1,51 @@
+#include <memory>
+#include <dataset.h>
+#include <binned_matrix.h>
+#include <utils/thread_pool.h>
+#include <trees/tree.h>
+#include <trees/histogram_splitter.h>
+#include <metrics/logloss.h>
+#include "bench_data.h"
+#include "benchmark/benchmark.h"
+
+using namespace microgbt;
+
+// Construction of a single tree on the root dataset, by exact greedy (tree_method 0) or histogram-based
+// (tree_method 1) split finding
+static void BM_TreeBuild(benchmark::State &state)
+{
+    long rows = state.range(0), cols = state.range(1);
+    int maxDepth = static_cast<int>(state.range(2)), numThreads = static_cast<int>(state.range(3));
+    bool histogram = state.range(4) == 1;
+
+    MatrixType X = bench::syntheticMatrix(rows, cols);
+    Vector y = bench::syntheticTargets(X);
+    Dataset dataset(X, y);
+
+    Vector scores(y.size(), 0.0), preds(y.size(), 0.5), gradient(y.size()), hessian(y.size());
+    LogLoss().gradientsAndHessians(scores.data(), y.data(), y.size(), gradient.data(), hessian.data());
+
+    std::shared_ptr<ThreadPool> threadPool = (numThreads > 1) ? std::make_shared<ThreadPool>(numThreads) : nullptr;
+    std::shared_ptr<const Splitter> splitter;
+    if (histogram)
+    {
+        splitter = std::make_shared<HistogramSplitter>(1.0, std::make_shared<BinnedMatrix>(dataset, 255), threadPool);
+    }
+    else
+    {
+        splitter = std::make_shared<NumericalSplitter>(1.0, threadPool);
+    }
+
+    for (auto _ : state)
+    {
+        Tree tree(1.0, 0.0, 2.0, maxDepth, splitter);
+        tree.build(dataset, preds, gradient, hessian, 1.0, scores);
+        benchmark::DoNotOptimize(scores.data());
+    }
+    state.SetItemsProcessed(state.iterations() * rows * cols);
+}
+BENCHMARK(BM_TreeBuild)
+    ->ArgNames({"rows", "features", "depth", "threads", "tree_method"})
+    ->ArgsProduct({{10000, 100000}, {8, 32}, {4, 8}, {1, 4}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
@@ -0,0 +1,34 @@
+# fetch Google Benchmark at configure time, as googletest.cmake does for googletest
+
+macro(fetch_googlebenchmark _download_module_path _download_root)
+    set(GOOGLEBENCHMARK_DOWNLOAD_ROOT ${_download_root})
+    configure_file(
+        ${_download_module_path}/googlebenchmark-download.cmake
+        ${_download_root}/CMakeLists.txt
+        @ONLY
+        )
+    unset(GOOGLEBENCHMARK_DOWNLOAD_ROOT)
+
+    execute_process(
+        COMMAND
+            "${CMAKE_COMMAND}" -G "${CMAKE_GENERATOR}" .
+        WORKING_DIRECTORY
+            ${_download_root}
+        )
+    execute_process(
+        COMMAND
+            "${CMAKE_COMMAND}" --build .
+        WORKING_DIRECTORY
+            ${_download_root}
+        )
+
+    # the tests of Google Benchmark itself are not built
+    set(BENCHMARK_ENABLE_TESTING OFF CACHE BOOL "" FORCE)
+    set(BENCHMARK_ENABLE_INSTALL OFF CACHE BOOL "" FORCE)
+
+    # adds the targets: benchmark::benchmark, benchmark::benchmark_main
+    add_subdirectory(
+        ${_download_root}/googlebenchmark-src
+        ${_download_root}/googlebenchmark-build
+        )
+endmacro()
@@ -13,9 +13,7 @@ logger = logging.getLogger(__name__)
 
 
 def binclass_metrics(gbt, X, y_true, label, show_report = False):
-    y_preds = []
-    for x in X:
-        y_preds.append(gbt.predict(x, gbt.best_iteration()))
+    y_preds = gbt.predict_batch(X, gbt.best_iteration())
 
     # logger.info("Residuals:")
     # logger.info(y_preds - y_true)
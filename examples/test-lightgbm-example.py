@@ -1,6 +1,5 @@
 #!/usr/bin/env python3
 import microgbtpy
-import pandas as pd
 from math import sqrt
 import logging.config
 from sklearn.model_selection import train_test_split
@@ -23,13 +22,9 @@ def regression_metrics(gbt, X_, y_, label):
 
 
 
-df_train = pd.read_csv('../data/lightgbm-regression.train', header=None, sep='\t')
-df_test = pd.read_csv('../data/lightgbm-regression.test', header=None, sep='\t')
-
-y = df_train[0].values
-y_test = df_test[0].values
-X = df_train.drop(0, axis=1).values
-X_test= df_test.drop(0, axis=1).values
+# Native loader, the label is the first column
+X, y = microgbtpy.load_csv('../data/lightgbm-regression.train', label_column=0, delimiter='\t')
+X_test, y_test = microgbtpy.load_csv('../data/lightgbm-regression.test', label_column=0, delimiter='\t')
 
 
 X_train, X_valid, y_train, y_valid = train_test_split(
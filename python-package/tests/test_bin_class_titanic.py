@@ -1,5 +1,6 @@
 import microgbtpy
 import os
+import pickle
 import numpy as np
 import pandas as pd
 from sklearn.impute import SimpleImputer
@@ -87,3 +88,44 @@ def test_microgbt_titanic_roc():
     roc = roc_auc_score(y_valid, y_valid_preds)
 
     assert roc > 0.7, "Area under the curve must be greater than 0.7"
+
+
+def test_microgbt_predict_batch():
+    num_iters = 20
+    early_stopping_rounds = 10
+
+    X_train, X_valid, y_train, y_valid = load_titanic()
+
+    # Train
+    gbt = microgbtpy.GBT(params)
+    gbt.train(X_train, y_train, X_valid, y_valid, num_iters, early_stopping_rounds)
+
+    # Batch predictions agree with per-row predictions
+    y_valid_preds = gbt.predict_batch(X_valid, gbt.best_iteration(), num_threads=2)
+    assert y_valid_preds.shape == (X_valid.shape[0],)
+    for x, pred in zip(X_valid, y_valid_preds):
+        assert pred == gbt.predict(x, gbt.best_iteration())
+
+    # Raw scores are margins, i.e., predictions before the logistic transformation
+    raw_scores = gbt.predict_batch(X_valid, gbt.best_iteration(), raw_score=True)
+    assert np.allclose(1.0 / (1.0 + np.exp(-raw_scores)), y_valid_preds, atol=1e-6)
+
+
+def test_microgbt_save_load_pickle(tmp_path):
+    num_iters = 10
+    early_stopping_rounds = 10
+
+    X_train, X_valid, y_train, y_valid = load_titanic()
+
+    gbt = microgbtpy.GBT(params)
+    gbt.train(X_train, y_train, X_valid, y_valid, num_iters, early_stopping_rounds)
+    expected = gbt.predict_batch(X_valid)
+
+    path = str(tmp_path / "titanic.model")
+    gbt.save_model(path)
+    loaded = microgbtpy.GBT.load_model(path)
+    assert loaded.best_iteration() == gbt.best_iteration()
+    assert np.array_equal(loaded.predict_batch(X_valid), expected)
+
+    unpickled = pickle.loads(pickle.dumps(gbt))
+    assert np.array_equal(unpickled.predict_batch(X_valid), expected)
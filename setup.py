@@ -47,6 +47,7 @@ class CMakeBuild(build_ext):
         cmake_args = [
             "-DCMAKE_LIBRARY_OUTPUT_DIRECTORY=" + extdir,
             "-DPYTHON_EXECUTABLE=" + sys.executable,
+            "-DMICROGBT_BUILD_BENCHMARKS=OFF",
         ]
 
         cfg = "Debug" if self.debug else "Release"
@@ -3,28 +3,173 @@
 #include <iostream>
 #include <memory>
 #include <chrono>
+#include <stdexcept>
+#include <mutex>
+#include <fstream>
+#include <cstring>
+#include <type_traits>
+#include <random>
 
 #include "dataset.h"
+#include "sparse_matrix.h"
+#include "binned_matrix.h"
+#include "utils/thread_pool.h"
+#include "utils/training_log.h"
 #include "trees/tree.h"
+#include "trees/flat_forest.h"
+#include "trees/quick_scorer.h"
+#include "trees/histogram_splitter.h"
 #include "metrics/metric.h"
 #include "metrics/logloss.h"
 #include "metrics/rmse.h"
+#include "sampling/goss.h"
+#include "sampling/random_subset.h"
+#include "io/model_format.h"
+#include "io/mapped_file.h"
+#include "io/binned_file.h"
 
 namespace microgbt
 {
 
+/**
+     * Inference engines of GBT
+     *
+     * TreeTraversal: walk each tree of the flat node table
+     * QuickScorer: bitvector-based evaluation, see QuickScorer (requires trees with at most 64 leaves)
+     */
+enum class PredictionEngine
+{
+    TreeTraversal,
+    QuickScorer
+};
+
 /**
      * Gradient Boosting Trees
+     *
+     * Training features are stored with element type Feature: double, float, or an integer type (e.g., int16_t or
+     * uint8_t) for quantized storage (see FeatureScale). Trained trees do not depend on the storage type, i.e., their
+     * thresholds are feature values.
      */
-class GBT
+template <typename Feature>
+class BasicGBT
 {
+public:
+    // Element type of input matrices: the storage type for floating point storage, double for quantized storage
+    using InputFeature = typename std::conditional<std::is_integral<Feature>::value, double, Feature>::type;
+
+    // Read-only view of a column-major input matrix with contiguous columns
+    using InputMatrixRef = Eigen::Ref<const FeatureMatrix<InputFeature>>;
+
+    // Read-only view of an input matrix of any memory layout
+    using InputBatchRef = Eigen::Ref<const FeatureMatrix<InputFeature>, 0, Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>>;
+
+private:
 
     int _maxDepth, _metricName;
     double _lambda, _gamma, _minSplitGain, _learningRate, _minTreeSize, _shrinkageRate;
+
+    // Split finding method: 0 for exact greedy, 1 for histogram based; maximum number of bins per feature
+    int _treeMethod = 0, _maxBin = BinnedMatrix::MaxBins;
+
+    // Exclusive feature bundling of histogram-based split finding (see FeatureBundles), if enabled, and the
+    // maximum fraction of rows on which bundled features may conflict
+    bool _enableBundle = false;
+    double _maxConflictRate = 0.0;
+
+    // Maximum number of leaves per tree; if positive, trees are grown leaf-wise (best-first) instead of depth-wise
+    int _maxLeaves = 0;
+
+    // Indices of the categorical features, see setCategoricalFeatures
+    VectorT _categoricalFeatures;
+
+    // Gradient-based one-side sampling of the training samples of every tree (see GOSS), if enabled
+    bool _goss = false;
+    double _topRate = 0.2, _otherRate = 0.1;
+
+    // Fraction of training rows sampled (without replacement) per tree, if GOSS is disabled
+    double _subsample = 1.0;
+
+    // Fraction of features sampled per tree, and fraction of these features sampled per tree level
+    double _colsampleByTree = 1.0, _colsampleByLevel = 1.0;
+
+    // Seed of the random number generator of sampling
+    unsigned long _seed = 0;
+
+    // Number of threads used by split finding, and the pool of these threads (if more than one)
+    int _numThreads = 1;
+    std::shared_ptr<ThreadPool> _threadPool;
     long _bestIteration = 0;
-    std::vector<Tree> _trees;
+
+    // Metrics of the iterations of the last training run, and the log level of training
+    TrainingLog _log;
+
+    // Trained trees, compiled into a flat node table for inference
+    FlatForest _forest;
+
+    // QuickScorer encoding of the trained trees, built on first use (if supported by the trees)
+    mutable std::shared_ptr<const QuickScorer> _quickScorer;
+    std::shared_ptr<std::mutex> _quickScorerMutex = std::make_shared<std::mutex>();
+
     std::unique_ptr<Metric> _metric;
 
+    static std::unique_ptr<Metric> createMetric(int metricName)
+    {
+        if (metricName == 0)
+        {
+            return std::unique_ptr<Metric>(new LogLoss());
+        }
+        else
+        {
+            return std::unique_ptr<Metric>(new RMSE());
+        }
+    }
+
+    /**
+         * Return a model whose trees are a view of serialized model bytes
+         *
+         * @param data Model bytes, aligned to at least 8 bytes
+         * @param size Number of bytes
+         * @param buffer Owner of the bytes, kept alive by the model
+         * @throws std::runtime_error if the bytes are not a valid model
+         */
+    static BasicGBT fromBytes(const uint8_t *data, size_t size, std::shared_ptr<const void> buffer)
+    {
+        ModelFormat::Header header = ModelFormat::readHeader(data, size);
+        ModelFormat::validateNodes(data, header);
+
+        std::map<std::string, double> params{
+            {"lambda", header.lambda},
+            {"gamma", header.gamma},
+            {"shrinkage_rate", header.shrinkageRate},
+            {"min_split_gain", header.minSplitGain},
+            {"min_tree_size", header.minTreeSize},
+            {"learning_rate", header.learningRate},
+            {"max_depth", static_cast<double>(header.maxDepth)},
+            {"metric", static_cast<double>(header.metric)},
+            {"tree_method", static_cast<double>(header.treeMethod)},
+            {"max_bin", static_cast<double>(header.maxBin)}};
+
+        // Models before version 4 were trained without sampling and grown depth-wise, i.e., with the default
+        // parameters
+        if (header.version >= 4)
+        {
+            params["subsample"] = header.subsample;
+            params["colsample_bytree"] = header.colsampleByTree;
+            params["colsample_bylevel"] = header.colsampleByLevel;
+            params["max_leaves"] = static_cast<double>(header.maxLeaves);
+            params["goss"] = static_cast<double>(header.goss);
+            params["top_rate"] = header.topRate;
+            params["other_rate"] = header.otherRate;
+        }
+
+        BasicGBT gbt(params);
+        gbt._seed = (header.version >= 4) ? static_cast<unsigned long>(header.seed) : 0;
+        gbt._bestIteration = header.bestIteration;
+        gbt._categoricalFeatures = ModelFormat::categoricalFeatures(data, header);
+        gbt._forest = ModelFormat::forestView(data, header, std::move(buffer));
+        return gbt;
+    }
+
     /**
          * Return a single decision/regression tree given training data, gradient, hessian vectors and shrinkage rate
          *
@@ -32,19 +177,258 @@ class GBT
          * @param gradient Gradient vector: each coordinate corresponds to sample (row index)
          * @param hessian Hessian vector: each coordinate corresponds to sample (row index)
          * @param shrinkageRate Shrinkage rate
+         * @param splitter Split finding strategy
+         * @param trainScores Raw scores of the training samples, updated with the scores of the new tree
+         * @param levelFeatures Candidate split features per tree level, or empty for all features
+         * @param stats Construction counters of the tree, if any
+         * @param arena Arena of tree construction, kept across boosting rounds; a new one if nullptr
          */
-    Tree buildTree(const Dataset &trainSet, const Vector &previousPreds, const Vector &gradient,
-                   const Vector &hessian, double shrinkageRate) const
+    BasicTree<Feature> buildTree(const BasicDataset<Feature> &trainSet, const Vector &previousPreds,
+                                 const Vector &gradient, const Vector &hessian, double shrinkageRate,
+                                 const std::shared_ptr<const BasicSplitter<Feature>> &splitter,
+                                 Vector &trainScores,
+                                 const std::vector<VectorT> &levelFeatures = std::vector<VectorT>(),
+                                 BuildStats *stats = nullptr,
+                                 const std::shared_ptr<BasicTreeArena<Feature>> &arena = nullptr) const
     {
-        Tree tree = Tree(_lambda, _minSplitGain, _minTreeSize, _maxDepth);
-        tree.build(trainSet, previousPreds, gradient, hessian, shrinkageRate);
+        BasicTree<Feature> tree(_lambda, _minSplitGain, _minTreeSize, _maxDepth, splitter, _maxLeaves, arena);
+        tree.build(trainSet, previousPreds, gradient, hessian, shrinkageRate, trainScores, levelFeatures, stats);
         return tree;
     }
 
+    /**
+         * Build a regression tree on a sample of the training rows and features
+         *
+         * @param trainSet Training dataset
+         * @param sampleRows Increasing list of sampled (local) row indices of trainSet
+         * @param sampleWeights Weight of every sampled row, applied to its gradient and Hessian
+         * @param sampleFeatures Increasing list of sampled features of trainSet
+         * @param levelFeatures Candidate split features per tree level (subsets of sampleFeatures), or empty
+         * @param previousPreds Predictions of the previous trees, one per row of trainSet
+         * @param gradient Gradient vector, one per row of trainSet
+         * @param hessian Hessian vector, one per row of trainSet
+         * @param shrinkageRate Shrinkage rate
+         * @param splitter Split finding strategy
+         * @param trainScores Raw scores of the training samples, updated with the scores of the new tree for the
+         *                    sampled rows only
+         * @param stats Construction counters of the tree, if any; the sample counts as a partition of the rows
+         * @param arena Arena of tree construction, kept across boosting rounds; a new one if nullptr
+         */
+    BasicTree<Feature> buildSampledTree(const BasicDataset<Feature> &trainSet, const VectorT &sampleRows,
+                                        const Vector &sampleWeights, const VectorT &sampleFeatures,
+                                        const std::vector<VectorT> &levelFeatures, const Vector &previousPreds,
+                                        const Vector &gradient, const Vector &hessian, double shrinkageRate,
+                                        const std::shared_ptr<const BasicSplitter<Feature>> &splitter,
+                                        Vector &trainScores, BuildStats *stats = nullptr,
+                                        const std::shared_ptr<BasicTreeArena<Feature>> &arena = nullptr) const
+    {
+        PhaseTimer partitionTimer(stats ? &stats->partitionMillis : nullptr);
+        BufferPool<Vector> *pool = arena ? &arena->values : nullptr;
+        BasicDataset<Feature> sampleSet(trainSet, sampleRows, sampleFeatures, arena.get());
+        PooledBuffer<Vector> predsBuffer(pool, sampleRows.size()), gradientBuffer(pool, sampleRows.size());
+        PooledBuffer<Vector> hessianBuffer(pool, sampleRows.size());
+        Vector &samplePreds = *predsBuffer, &sampleGradient = *gradientBuffer, &sampleHessian = *hessianBuffer;
+        for (size_t k = 0; k < sampleRows.size(); k++)
+        {
+            samplePreds[k] = previousPreds[sampleRows[k]];
+            sampleGradient[k] = sampleWeights[k] * gradient[sampleRows[k]];
+            sampleHessian[k] = sampleWeights[k] * hessian[sampleRows[k]];
+        }
+        partitionTimer.stop();
+        if (stats != nullptr)
+        {
+            stats->rowsTouched += static_cast<long>(sampleRows.size());
+            stats->bytesAllocated += sampleSet.indexBytes() + 3 * sizeof(double) * sampleRows.size();
+        }
+
+        return buildTree(sampleSet, samplePreds, sampleGradient, sampleHessian, shrinkageRate, splitter,
+                         trainScores, levelFeatures, stats, arena);
+    }
+
+    /**
+         * Sample the training rows of a tree, by GOSS if enabled, otherwise uniformly (subsample)
+         *
+         * @param gradient Gradient vector, one per training row
+         * @param goss GOSS sampler
+         * @param rng Random number generator
+         * @param weights Output: weight of every sampled row
+         * @return Increasing list of sampled (local) row indices; all rows if rows are not sampled
+         */
+    template <typename RandomGenerator>
+    VectorT sampleTrainRows(const Vector &gradient, const GOSS &goss, RandomGenerator &rng, Vector &weights) const
+    {
+        if (_goss)
+        {
+            return goss.sample(gradient, rng, weights);
+        }
+
+        VectorT rows(gradient.size());
+        std::iota(rows.begin(), rows.end(), 0);
+        rows = randomFraction(rows, _subsample, rng);
+        weights.assign(rows.size(), 1.0);
+        return rows;
+    }
+
+    /**
+         * Check that input samples have the features of the model, since the trees index them unchecked
+         *
+         * @param numColumns Number of features of the input samples
+         * @throws std::invalid_argument if the number of features differs from the one of the training samples, or,
+         *                               for models that do not record it, is less than the split features require
+         */
+    void checkNumFeatures(long numColumns) const
+    {
+        size_t numFeatures = static_cast<size_t>(std::max(0L, numColumns));
+        if (numFeatures < _forest.minFeatures() ||
+            (_forest.numFeatures() > 0 && numFeatures != _forest.numFeatures()))
+        {
+            throw std::invalid_argument("Number of features of the input does not match the model");
+        }
+    }
+
+    /**
+         * Returns the predictions (or raw scores) of numRows samples, in blocks of rows processed in parallel
+         *
+         * @param numRows Number of samples
+         * @param sampleAt sampleAt(i) is the i-th sample, any type supporting sample[featureIndex]
+         * @throws std::invalid_argument if the QuickScorer engine is requested but not supported by the trees
+         */
+    template <typename RowAccessor>
+    Eigen::VectorXd predictRows(size_t numRows, const RowAccessor &sampleAt, long numIterations, int numThreads,
+                                bool rawScore, PredictionEngine engine) const
+    {
+        std::shared_ptr<const QuickScorer> quickScorer;
+        if (engine == PredictionEngine::QuickScorer)
+        {
+            quickScorer = this->quickScorer();
+            if (!quickScorer)
+            {
+                throw std::invalid_argument("QuickScorer engine requires trained trees with at most 64 leaves");
+            }
+        }
+
+        const size_t blockSize = 1024;
+        size_t numBlocks = (numRows + blockSize - 1) / blockSize;
+        size_t numTrees = static_cast<size_t>(std::max(0L, numIterations));
+        Eigen::VectorXd predictions(numRows);
+
+        std::function<void(size_t)> predictBlock = [&](size_t block) {
+            size_t end = std::min(numRows, (block + 1) * blockSize);
+            std::vector<uint64_t> bitvectors;
+            for (size_t i = block * blockSize; i < end; i++)
+            {
+                double score = (engine == PredictionEngine::QuickScorer)
+                                   ? quickScorer->score(sampleAt(i), numTrees, bitvectors)
+                                   : _forest.score(sampleAt(i), numTrees);
+                predictions[i] = rawScore ? score : _metric->scoreToPrediction(score);
+            }
+        };
+
+        // Reuse the training thread pool if it has the requested size
+        if (_threadPool && numThreads == _numThreads)
+        {
+            _threadPool->parallelFor(numBlocks, predictBlock);
+        }
+        else
+        {
+            ThreadPool threadPool(numThreads);
+            threadPool.parallelFor(numBlocks, predictBlock);
+        }
+
+        return predictions;
+    }
+
+    /**
+         * Return the raw scores (sum of scores over all trees) of the samples of a dataset
+         *
+         * @param dataset Input dataset
+         * @return Raw scores indexed by global row index, i.e., row index of the underlying design matrix
+         */
+    Vector rawScoresDataset(const BasicDataset<Feature> &dataset) const
+    {
+        Vector rawScores(dataset.numGlobalRows(), 0.0);
+        const VectorT &rowIndices = dataset.rowIter();
+        for (size_t i = 0; i < rowIndices.size() && _forest.numTrees() > 0; i++)
+        {
+            rawScores[rowIndices[i]] = _forest.score(dataset.sample(i), 0);
+        }
+
+        return rawScores;
+    }
+
+    /**
+         * Return the raw scores of pre-binned samples, see BinnedMatrix::Sample
+         *
+         * @param bins Pre-binned design matrix
+         * @param rowIndices Global row indices of the samples
+         * @return Raw scores indexed by global row index
+         */
+    Vector rawScoresBinned(const BinnedMatrix &bins, const VectorT &rowIndices) const
+    {
+        Vector rawScores(bins.rows(), 0.0);
+        for (size_t i = 0; i < rowIndices.size() && _forest.numTrees() > 0; i++)
+        {
+            rawScores[rowIndices[i]] = _forest.score(bins.sample(rowIndices[i]), 0);
+        }
+
+        return rawScores;
+    }
+
+    /**
+         * Transform raw scores to predictions
+         *
+         * @param rawScores Raw scores indexed by global row index
+         * @param rowIndices Global row indices of the dataset samples
+         * @return Prediction per dataset sample
+         */
+    Vector scoresToPredictions(const Vector &rawScores, const VectorT &rowIndices) const
+    {
+        Vector predictions(rowIndices.size());
+        for (size_t i = 0; i < rowIndices.size(); i++)
+        {
+            predictions[i] = _metric->scoreToPrediction(rawScores[rowIndices[i]]);
+        }
+
+        return predictions;
+    }
+
+    /**
+         * Return a dataset of (X, y): a view of X if it has the storage type, otherwise a converted copy of X
+         *
+         * @param X Design matrix
+         * @param y Target vector of X.rows() values
+         * @param scale Scale table of quantized storage, e.g., the one of the training dataset; fitted to X if nullptr
+         */
+    template <typename Input>
+    static BasicDataset<Feature> makeDataset(const Eigen::Ref<const FeatureMatrix<Input>> &X, const double *y,
+                                             std::shared_ptr<const FeatureScale<Feature>> scale)
+    {
+        return makeDataset(X, y, std::move(scale), std::is_same<Input, Feature>());
+    }
+
+    static BasicDataset<Feature> makeDataset(const Eigen::Ref<const FeatureMatrix<Feature>> &X, const double *y,
+                                             std::shared_ptr<const FeatureScale<Feature>> scale, std::true_type)
+    {
+        return BasicDataset<Feature>(FeatureMatrixView<Feature>(X.data(), X.rows(), X.cols(),
+                                                                Eigen::OuterStride<>(X.outerStride())),
+                                     y, nullptr, std::move(scale));
+    }
+
+    template <typename Input>
+    static BasicDataset<Feature> makeDataset(const Eigen::Ref<const FeatureMatrix<Input>> &X, const double *y,
+                                             std::shared_ptr<const FeatureScale<Feature>> scale, std::false_type)
+    {
+        return BasicDataset<Feature>(X.template cast<double>(), Vector(y, y + X.rows()), std::move(scale));
+    }
+
 public:
-    GBT() = default;
+    BasicGBT() = default;
 
-    explicit GBT(const std::map<std::string, double> &params) : GBT()
+    /**
+         * @param params Training parameters, see README
+         * @throws std::invalid_argument if the GOSS rates are negative, or other_rate is zero with GOSS enabled
+         */
+    explicit BasicGBT(const std::map<std::string, double> &params) : BasicGBT()
     {
         this->_lambda = params.at("lambda");
         this->_gamma = params.at("gamma");
@@ -55,14 +439,80 @@ public:
         this->_maxDepth = static_cast<int>(params.at("max_depth"));
         this->_metricName = static_cast<int>(params.at("metric"));
 
-        if (_metricName == 0)
+        // Optional parameters
+        if (params.count("tree_method"))
         {
-            this->_metric = std::unique_ptr<Metric>(new LogLoss());
+            this->_treeMethod = static_cast<int>(params.at("tree_method"));
         }
-        else
+        if (params.count("max_bin"))
         {
-            this->_metric = std::unique_ptr<Metric>(new RMSE());
+            this->_maxBin = static_cast<int>(params.at("max_bin"));
         }
+        if (params.count("enable_bundle"))
+        {
+            this->_enableBundle = params.at("enable_bundle") != 0.0;
+        }
+        if (params.count("max_conflict_rate"))
+        {
+            this->_maxConflictRate = params.at("max_conflict_rate");
+        }
+        if (params.count("max_leaves"))
+        {
+            this->_maxLeaves = static_cast<int>(params.at("max_leaves"));
+        }
+        if (params.count("goss"))
+        {
+            this->_goss = params.at("goss") != 0.0;
+        }
+        if (params.count("top_rate"))
+        {
+            this->_topRate = params.at("top_rate");
+        }
+        if (params.count("other_rate"))
+        {
+            this->_otherRate = params.at("other_rate");
+        }
+        if (params.count("subsample"))
+        {
+            this->_subsample = params.at("subsample");
+        }
+        if (params.count("colsample_bytree"))
+        {
+            this->_colsampleByTree = params.at("colsample_bytree");
+        }
+        if (params.count("colsample_bylevel"))
+        {
+            this->_colsampleByLevel = params.at("colsample_bylevel");
+        }
+        if (params.count("seed"))
+        {
+            this->_seed = static_cast<unsigned long>(params.at("seed"));
+        }
+        if (params.count("num_threads"))
+        {
+            this->_numThreads = static_cast<int>(params.at("num_threads"));
+        }
+        if (params.count("verbosity"))
+        {
+            this->_log.setLevel(static_cast<LogLevel>(static_cast<int>(params.at("verbosity"))));
+        }
+
+        if (!(_topRate >= 0.0) || !(_otherRate >= 0.0))
+        {
+            throw std::invalid_argument("GOSS rates top_rate and other_rate must be non-negative");
+        }
+        if (_goss && _otherRate == 0.0)
+        {
+            throw std::invalid_argument("GOSS requires a positive other_rate");
+        }
+
+        if (_numThreads != 1)
+        {
+            this->_threadPool = std::make_shared<ThreadPool>(_numThreads);
+            this->_numThreads = _threadPool->numThreads();
+        }
+
+        this->_metric = createMetric(_metricName);
     }
 
     inline int maxDepth() const { return _maxDepth; }
@@ -79,9 +529,71 @@ public:
 
     inline double getLearningRate() const { return _learningRate; }
 
+    inline double minTreeSize() const { return _minTreeSize; }
+
+    inline int metricName() const { return _metricName; }
+
+    inline int treeMethod() const { return _treeMethod; }
+
+    inline int maxBin() const { return _maxBin; }
+
+    inline bool enableBundle() const { return _enableBundle; }
+
+    inline double maxConflictRate() const { return _maxConflictRate; }
+
+    inline int maxLeaves() const { return _maxLeaves; }
+
+    inline const VectorT &categoricalFeatures() const { return _categoricalFeatures; }
+
+    /**
+         * Declare the categorical features of the training data
+         *
+         * The values of a categorical feature are integer category codes in [0, CategorySet::MaxCategory]. Their
+         * splits send a set of categories to the left branch, found by sorting the categories of each node by their
+         * gradient / Hessian ratio; missing values and categories unseen in training follow the right branch.
+         * Requires exact split finding (tree_method 0) and floating point storage.
+         *
+         * @param features Indices of the categorical features
+         */
+    inline void setCategoricalFeatures(const VectorT &features) { _categoricalFeatures = features; }
+
+    inline bool goss() const { return _goss; }
+
+    inline double topRate() const { return _topRate; }
+
+    inline double otherRate() const { return _otherRate; }
+
+    inline double subsample() const { return _subsample; }
+
+    inline double colsampleByTree() const { return _colsampleByTree; }
+
+    inline double colsampleByLevel() const { return _colsampleByLevel; }
+
+    inline unsigned long seed() const { return _seed; }
+
+    inline int numThreads() const { return _numThreads; }
+
+    inline LogLevel verbosity() const { return _log.level(); }
+
+    inline void setVerbosity(LogLevel level) { _log.setLevel(level); }
+
+    /**
+         * Set the stream that training writes its log to (std::cout by default); it must outlive training
+         */
+    inline void setLogStream(std::ostream &out) { _log.setStream(out); }
+
+    /**
+         * Metrics of every iteration of the last training run, see IterationStats
+         */
+    inline const std::vector<IterationStats> &history() const { return _log.history(); }
+
     /**
          * Python entry point to train GBT
          *
+         * For floating point storage, the datasets are views of the given buffers, i.e., Fortran-ordered numpy arrays
+         * of the storage type are used in place without any copy. The buffers must not be modified during training.
+         * For quantized storage, the scale table is fitted to the training matrix and both matrices are quantized.
+         *
          * @param trainX Training feature matrix
          * @param trainY Training target vector
          * @param validX Validation feature matrix
@@ -89,15 +601,102 @@ public:
          * @param numBoostRound Number of boosting rounds (# of trees)
          * @param earlyStoppingRounds number of rounds to consider for early stopping, i.e., if there is not improvement
          */
+    void trainPython(const InputMatrixRef &trainX, const Eigen::Ref<const Eigen::VectorXd> &trainY,
+                     const InputMatrixRef &validX, const Eigen::Ref<const Eigen::VectorXd> &validY,
+                     int numBoostRound, int earlyStoppingRounds)
+    {
+        if (trainY.size() != trainX.rows() || validY.size() != validX.rows())
+        {
+            throw std::invalid_argument("Number of targets does not match number of samples");
+        }
+
+        BasicDataset<Feature> trainSet = makeDataset<InputFeature>(trainX, trainY.data(), nullptr);
+        BasicDataset<Feature> validSet = makeDataset<InputFeature>(validX, validY.data(), trainSet.scale());
+        train(trainSet, validSet, numBoostRound, earlyStoppingRounds);
+    }
+
     void trainPython(const MatrixType &trainX, const Vector &trainY,
                      const MatrixType &validX, const Vector &validY,
                      int numBoostRound, int earlyStoppingRounds)
     {
+        if (trainY.size() != static_cast<size_t>(trainX.rows()) || validY.size() != static_cast<size_t>(validX.rows()))
+        {
+            throw std::invalid_argument("Number of targets does not match number of samples");
+        }
 
-        Dataset trainSet(trainX, trainY), validSet(validX, validY);
+        BasicDataset<Feature> trainSet = makeDataset<double>(trainX, trainY.data(), nullptr);
+        BasicDataset<Feature> validSet = makeDataset<double>(validX, validY.data(), trainSet.scale());
         train(trainSet, validSet, numBoostRound, earlyStoppingRounds);
     }
 
+    /**
+         * Train a GBT model on sparse training and validation matrices, see BasicDataset
+         *
+         * Entries that are not stored are missing values: split finding only scans the stored values of each
+         * feature and learns the direction of the missing ones. Requires exact split finding (tree_method 0).
+         *
+         * @param trainX Compressed sparse column training feature matrix
+         * @param trainY Training target vector
+         * @param validX Compressed sparse column validation feature matrix
+         * @param validY Validation target vector
+         * @param numBoostRound Number of boosting rounds (# of trees)
+         * @param earlyStoppingRounds number of rounds to consider for early stopping, i.e., if there is not improvement
+         */
+    void trainPython(const SparseMatrixType &trainX, const Eigen::Ref<const Eigen::VectorXd> &trainY,
+                     const SparseMatrixType &validX, const Eigen::Ref<const Eigen::VectorXd> &validY,
+                     int numBoostRound, int earlyStoppingRounds)
+    {
+        if (trainY.size() != trainX.rows() || validY.size() != validX.rows())
+        {
+            throw std::invalid_argument("Number of targets does not match number of samples");
+        }
+
+        BasicDataset<Feature> trainSet(trainX, Vector(trainY.data(), trainY.data() + trainY.size()));
+        BasicDataset<Feature> validSet(validX, Vector(validY.data(), validY.data() + validY.size()));
+        train(trainSet, validSet, numBoostRound, earlyStoppingRounds);
+    }
+
+    /**
+         * Python entry point of out-of-core training, see trainOutOfCore
+         */
+    void trainOutOfCorePython(const std::string &trainPath,
+                              const InputMatrixRef &validX, const Eigen::Ref<const Eigen::VectorXd> &validY,
+                              int numBoostRound, int earlyStoppingRounds)
+    {
+        if (validY.size() != validX.rows())
+        {
+            throw std::invalid_argument("Number of targets does not match number of samples");
+        }
+
+        BasicDataset<Feature> validSet = makeDataset<InputFeature>(validX, validY.data(), nullptr);
+        trainOutOfCore(trainPath, validSet, numBoostRound, earlyStoppingRounds);
+    }
+
+    /**
+         * Train a GBT model out-of-core, on a file of pre-binned training data (see BinnedFile, BinnedFileWriter)
+         *
+         * The file is memory-mapped and trees are built by histogram-based split finding on its bins (regardless of
+         * tree_method), which reads the columns block by block, i.e., the training features are never entirely
+         * resident in memory. Per-row state (targets, gradients, Hessians and scores) is held in memory.
+         *
+         * @param trainPath Path of the binned training file
+         * @param validSet Input validation dataset, in memory
+         * @param numBoostRound  Number of boosting rounds
+         * @param earlyStoppingRounds number of rounds to consider for early stopping
+         */
+    void trainOutOfCore(const std::string &trainPath, const BasicDataset<Feature> &validSet, int numBoostRound,
+                        int earlyStoppingRounds)
+    {
+        BinnedFile file(trainPath);
+        if (file.numFeatures() != validSet.numFeatures())
+        {
+            throw std::invalid_argument("Number of features of the training file does not match the validation set");
+        }
+
+        BasicDataset<Feature> trainSet(file.rows(), file.numFeatures(), file.targets(), file.owner());
+        train(trainSet, validSet, numBoostRound, earlyStoppingRounds, file.bins());
+    }
+
     /**
          * Train a GBT model based on training and validation datasets
          *
@@ -105,50 +704,165 @@ public:
          * @param validSet Input validation dataset
          * @param numBoostRound  Number of boosting rounds
          * @param earlyStoppingRounds number of rounds to consider for early stopping, i.e., if there is not improvement
+         * @param trainBins Pre-binned training features (indexed by global row index of trainSet), e.g., of an
+         *                  out-of-core training file; if set, histogram-based split finding uses them and training
+         *                  samples are scored through them, i.e., trainSet need not hold its design matrix
          */
-    void train(const Dataset &trainSet, const Dataset &validSet, int numBoostRound, int earlyStoppingRounds)
+    void train(const BasicDataset<Feature> &trainSet, const BasicDataset<Feature> &validSet, int numBoostRound,
+               int earlyStoppingRounds, std::shared_ptr<const BinnedMatrix> trainBins = nullptr)
     {
 
         long bestIteration = 0;
         double learningRate = _shrinkageRate, bestValidationLoss = std::numeric_limits<double>::max();
+        _forest.setNumFeatures(static_cast<size_t>(trainSet.numFeatures()));
+
+        std::vector<bool> categorical(static_cast<size_t>(trainSet.numFeatures()), false);
+        for (size_t featureId : _categoricalFeatures)
+        {
+            if (featureId >= categorical.size())
+            {
+                throw std::invalid_argument("Categorical feature " + std::to_string(featureId) + " does not exist");
+            }
+            categorical[featureId] = true;
+        }
+        if (!_categoricalFeatures.empty() && (trainBins || _treeMethod == 1 || std::is_integral<Feature>::value))
+        {
+            throw std::invalid_argument("Categorical features require exact split finding (tree_method 0) and "
+                                        "floating point storage");
+        }
+
+        // Histogram mode quantizes the training features once, and every tree reuses the bins
+        std::shared_ptr<const BasicSplitter<Feature>> splitter;
+        if (trainBins)
+        {
+            // Memory-mapped bins are not bundled, since the bundles would be held in memory
+            std::shared_ptr<const FeatureBundles> bundles = (_enableBundle && !trainBins->isMapped())
+                                                                ? std::make_shared<FeatureBundles>(trainBins, _maxConflictRate)
+                                                                : nullptr;
+            splitter = std::make_shared<BasicHistogramSplitter<Feature>>(_lambda, trainBins, _threadPool, bundles);
+        }
+        else if (_treeMethod == 1)
+        {
+            if (trainSet.isSparse())
+            {
+                throw std::invalid_argument("Sparse training data requires exact split finding (tree_method 0)");
+            }
+            std::shared_ptr<const BinnedMatrix> bins = std::make_shared<BinnedMatrix>(trainSet, _maxBin);
+            std::shared_ptr<const FeatureBundles> bundles =
+                _enableBundle ? std::make_shared<FeatureBundles>(bins, _maxConflictRate) : nullptr;
+            splitter = std::make_shared<BasicHistogramSplitter<Feature>>(_lambda, bins, _threadPool, bundles);
+        }
+        else
+        {
+            splitter = std::make_shared<BasicNumericalSplitter<Feature>>(_lambda, _threadPool, categorical);
+        }
+
+        // Raw scores of the training and validation samples are cached across iterations, so that
+        // each iteration only adds the scores of the newly built tree
+        VectorT trainRows = trainSet.rowIter(), validRows = validSet.rowIter();
+        Vector trainY = trainSet.y(), validY = validSet.y();
+        Vector trainScores = trainBins ? rawScoresBinned(*trainBins, trainRows) : rawScoresDataset(trainSet);
+        Vector validScores = rawScoresDataset(validSet);
+        Vector trainPreds = scoresToPredictions(trainScores, trainRows);
+
+        // Gradient and Hessian buffers (and the raw scores of the training samples), reused across iterations
+        size_t numTrainRows = trainRows.size();
+        Vector localTrainScores(numTrainRows), gradient(numTrainRows), hessian(numTrainRows);
+
+        // Nodes and node buffers of tree construction, reused across iterations
+        std::shared_ptr<BasicTreeArena<Feature>> arena = std::make_shared<BasicTreeArena<Feature>>();
+
+        // Row and column sampling is reproducible for a given seed
+        std::mt19937_64 rng(_seed);
+        GOSS goss(_topRate, _otherRate);
 
         // For each iteration, grow an additional tree
+        _log.clear();
         for (long iterCount = 0; iterCount < numBoostRound; iterCount++)
         {
+            IterationStats stats;
+            stats.iteration = iterCount;
+            PhaseTimer iterationTimer(&stats.totalMillis);
 
-            std::cout << "[Iteration: " << iterCount << "]" << std::endl;
-            auto startTimestamp = std::chrono::high_resolution_clock::now();
-
-            // Current predictions
-            Vector scores = predictDataset(trainSet);
+            // Compute gradient and Hessian with respect to prior predictions, in a single pass over the raw scores
+            PhaseTimer gradientTimer(&stats.gradientMillis);
+            for (size_t i = 0; i < numTrainRows; i++)
+            {
+                localTrainScores[i] = trainScores[trainRows[i]];
+            }
+            _metric->gradientsAndHessians(localTrainScores.data(), trainY.data(), numTrainRows,
+                                          gradient.data(), hessian.data(), _threadPool.get());
 
-            // Compute gradient and Hessian with respect to prior predictions
-            std::cout << "[Computing gradients/Hessians vectors]" << std::endl;
-            Vector gradient = _metric->gradients(scores, trainSet.y());
-            Vector hessian = _metric->hessian(scores);
+            // Sample the training rows and features of the tree (and the features of each of its levels); the
+            // sample is an index view of the training dataset
+            Vector sampleWeights;
+            VectorT sampleRows = sampleTrainRows(gradient, goss, rng, sampleWeights);
+            VectorT sampleFeatures = randomFraction(trainSet.features(), _colsampleByTree, rng);
+            std::vector<VectorT> levelFeatures;
+            for (int depth = 0; _colsampleByLevel < 1.0 && depth <= _maxDepth; depth++)
+            {
+                levelFeatures.push_back(randomFraction(sampleFeatures, _colsampleByLevel, rng));
+            }
+            bool sampled = sampleRows.size() < numTrainRows;
+            bool sampledFeatures = sampleFeatures.size() < trainSet.features().size();
+            gradientTimer.stop();
 
-            // Grow a new tree learner
-            std::cout << "[Building next tree...]" << std::endl;
-            Tree tree = buildTree(trainSet, scores, gradient, hessian, learningRate);
-            std::cout << "[Tree is built successfully]" << std::endl;
+            // Grow a new tree learner; the training samples' leaf assignments update their raw scores
+            BasicTree<Feature> tree = (sampled || sampledFeatures)
+                                          ? buildSampledTree(trainSet, sampleRows, sampleWeights, sampleFeatures,
+                                                             levelFeatures, trainPreds, gradient, hessian,
+                                                             learningRate, splitter, trainScores, &stats.tree, arena)
+                                          : buildTree(trainSet, trainPreds, gradient, hessian, learningRate,
+                                                      splitter, trainScores, levelFeatures, &stats.tree, arena);
 
             // Update the learning rate
             learningRate *= _learningRate;
 
-            // Append the additional tree
-            _trees.push_back(tree);
+            // Append the additional tree to the flat node table
+            PhaseTimer predictionTimer(&stats.predictionMillis);
+            _forest.addTree(tree);
+            size_t treeIndex = _forest.numTrees() - 1;
+
+            // Training samples outside the sample of the tree are scored by the tree
+            if (sampled)
+            {
+                std::vector<bool> inSample(numTrainRows, false);
+                for (size_t row : sampleRows)
+                {
+                    inSample[row] = true;
+                }
+                for (size_t i = 0; i < numTrainRows; i++)
+                {
+                    if (!inSample[i])
+                    {
+                        trainScores[trainRows[i]] += trainBins
+                                                         ? _forest.scoreTree(treeIndex, trainBins->sample(trainRows[i]))
+                                                         : _forest.scoreTree(treeIndex, trainSet.sample(i));
+                    }
+                }
+            }
+
+            // Update validation scores with the additional tree only
+            for (size_t i = 0; i < validRows.size(); i++)
+            {
+                validScores[validRows[i]] += _forest.scoreTree(treeIndex, validSet.sample(i));
+            }
+            predictionTimer.stop();
 
             // Update train and validation loss
-            std::cout << "[Evaluating training / validation losses]" << std::endl;
-            Vector trainPreds = predictDataset(trainSet);
-            double trainLoss = _metric->lossAt(trainPreds, trainSet.y());
-            Vector validPreds = predictDataset(validSet);
-            double currentValidationLoss = _metric->lossAt(validPreds, validSet.y());
+            PhaseTimer evaluationTimer(&stats.evaluationMillis);
+            trainPreds = scoresToPredictions(trainScores, trainRows);
+            double trainLoss = _metric->lossAt(trainPreds, trainY);
+            Vector validPreds = scoresToPredictions(validScores, validRows);
+            double currentValidationLoss = _metric->lossAt(validPreds, validY);
+            evaluationTimer.stop();
 
-            auto endTimestamp = std::chrono::high_resolution_clock::now();
-            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTimestamp - startTimestamp).count();
-            std::cout << "[Duration: " << duration << " millis] | [Train Loss]: " << trainLoss
-                      << " | [Valid Loss]: " << bestValidationLoss << std::endl;
+            // Leaf weights are added to the training scores while the tree is built
+            iterationTimer.stop();
+            stats.predictionMillis += stats.tree.leafMillis;
+            stats.trainLoss = trainLoss;
+            stats.validLoss = currentValidationLoss;
+            _log.record(stats);
 
             // Update best iteration / best validation error
             if (currentValidationLoss < bestValidationLoss)
@@ -161,13 +875,109 @@ public:
             // Namely, if there is no improvement in the last early_stopping_rounds, then stop
             if (iterCount - bestIteration >= earlyStoppingRounds)
             {
-                std::cout << "Early stopping, best iteration is:" << bestIteration;
-                std::cout << "Train Loss: " << trainLoss << "| Valid Loss: " << bestValidationLoss << std::endl;
+                _log.message(LogLevel::Info, "Early stopping, best iteration is " + std::to_string(bestIteration) +
+                                                 " | Valid Loss: " + std::to_string(bestValidationLoss));
                 break;
             }
         }
 
         _bestIteration = bestIteration;
+
+        std::lock_guard<std::mutex> lock(*_quickScorerMutex);
+        _quickScorer.reset();
+    }
+
+    /**
+         * Serialize the model (trees, parameters, metric and best iteration) in the binary model format
+         *
+         * @return Model bytes, see ModelFormat
+         */
+    std::string serialize() const
+    {
+        // Value-initialized, i.e., padding bytes are zero and the model bytes are deterministic
+        ModelFormat::Header header = ModelFormat::Header();
+        header.metric = _metricName;
+        header.maxDepth = _maxDepth;
+        header.treeMethod = _treeMethod;
+        header.maxBin = _maxBin;
+        header.lambda = _lambda;
+        header.gamma = _gamma;
+        header.minSplitGain = _minSplitGain;
+        header.learningRate = _learningRate;
+        header.minTreeSize = _minTreeSize;
+        header.shrinkageRate = _shrinkageRate;
+        header.bestIteration = _bestIteration;
+        header.subsample = _subsample;
+        header.colsampleByTree = _colsampleByTree;
+        header.colsampleByLevel = _colsampleByLevel;
+        header.seed = _seed;
+        header.maxLeaves = _maxLeaves;
+        header.goss = _goss ? 1 : 0;
+        header.topRate = _topRate;
+        header.otherRate = _otherRate;
+
+        return ModelFormat::serialize(header, _forest, _categoricalFeatures);
+    }
+
+    /**
+         * Save the model to a file in the binary model format
+         *
+         * @param path File path
+         */
+    void saveModel(const std::string &path) const
+    {
+        std::string bytes = serialize();
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!out)
+        {
+            throw std::runtime_error("Cannot write model file " + path);
+        }
+    }
+
+    /**
+         * Load a model saved by saveModel.
+         *
+         * The file is memory-mapped and its trees are used in place: loading neither parses nor copies the trees,
+         * and all processes that load the same file share a single physical copy of it.
+         *
+         * @param path File path
+         * @return Loaded model
+         */
+    static BasicGBT loadModel(const std::string &path)
+    {
+        std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(path);
+        return fromBytes(file->data(), file->size(), file);
+    }
+
+    /**
+         * Deserialize a model returned by serialize
+         *
+         * @param bytes Model bytes
+         * @return Deserialized model
+         */
+    static BasicGBT deserialize(const std::string &bytes)
+    {
+        // Copy into an 8-byte aligned buffer, since the node table is used in place
+        std::shared_ptr<std::vector<uint64_t>> buffer =
+            std::make_shared<std::vector<uint64_t>>((bytes.size() + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+        std::memcpy(buffer->data(), bytes.data(), bytes.size());
+        return fromBytes(reinterpret_cast<const uint8_t *>(buffer->data()), bytes.size(), buffer);
+    }
+
+    /**
+         * Return the QuickScorer encoding of the trained trees, built on first use
+         *
+         * @return QuickScorer, or nullptr if some tree has more than QuickScorer::MaxLeaves leaves
+         */
+    std::shared_ptr<const QuickScorer> quickScorer() const
+    {
+        std::lock_guard<std::mutex> lock(*_quickScorerMutex);
+        if (!_quickScorer && QuickScorer::supports(_forest))
+        {
+            _quickScorer = std::make_shared<QuickScorer>(_forest);
+        }
+        return _quickScorer;
     }
 
     /**
@@ -176,6 +986,7 @@ public:
          * @param x Input sample vector (i-th coordinate corresponds to i-th feature)
          * @param numIterations Number of iterations to use for prediction. This is used in case that early stopping took place
          * @return Prediction of input sample
+         * @throws std::invalid_argument if the sample does not have the features of the model
          */
     double predict(const Eigen::RowVectorXd &x, long numIterations) const
     {
@@ -186,33 +997,74 @@ public:
     /**
          * Return sum of scores up to numIterations
          *
-         * @param x
-         * @param trees
-         * @param numIterations
+         * @param x Input sample vector
+         * @param numIterations Number of trees to use; all trees if zero
          * @return
+         * @throws std::invalid_argument if the sample does not have the features of the model
          */
     double sumScore(const Eigen::RowVectorXd &x, long numIterations) const
     {
-        long double score = 0.0;
-        numIterations = (numIterations == 0) ? (long)_trees.size() : numIterations;
-        int limit = 0;
-        for (auto &tree : _trees)
+        checkNumFeatures(x.size());
+        return _forest.score(x, static_cast<size_t>(std::max(0L, numIterations)));
+    }
+
+    inline size_t numTrees() const { return _forest.numTrees(); }
+
+    inline const FlatForest &forest() const { return _forest; }
+
+    inline const Metric &metric() const { return *_metric; }
+
+    /**
+         * Returns the predictions (or raw scores) of all samples (rows) of a matrix.
+         *
+         * Rows are processed in blocks, in parallel over numThreads threads.
+         *
+         * @param X Input matrix, each row corresponds to a sample
+         * @param numIterations Number of iterations to use for prediction; all if zero
+         * @param numThreads Number of threads; if non-positive, the number of hardware threads is used
+         * @param rawScore If true, return raw scores (margins) instead of predictions
+         * @param engine Inference engine; both engines return identical results
+         * @return Prediction (or raw score) per row of X
+         * @throws std::invalid_argument if the QuickScorer engine is requested but not supported by the trees, or
+         *                               X does not have the features of the model
+         */
+    Eigen::VectorXd predictBatch(const InputBatchRef &X, long numIterations, int numThreads, bool rawScore,
+                                 PredictionEngine engine = PredictionEngine::TreeTraversal) const
+    {
+        checkNumFeatures(X.cols());
+        return predictRows(static_cast<size_t>(X.rows()), [&X](size_t i) { return X.row(i); }, numIterations,
+                           numThreads, rawScore, engine);
+    }
+
+    /**
+         * Returns the predictions (or raw scores) of all samples (rows) of a sparse matrix, see predictBatch
+         *
+         * Entries that are not stored are missing values, as for training on sparse matrices.
+         *
+         * @param X Compressed sparse row input matrix, each row corresponds to a sample
+         * @param numIterations Number of iterations to use for prediction; all if zero
+         * @param numThreads Number of threads; if non-positive, the number of hardware threads is used
+         * @param rawScore If true, return raw scores (margins) instead of predictions
+         * @param engine Inference engine; both engines return identical results
+         * @return Prediction (or raw score) per row of X
+         * @throws std::invalid_argument if X does not have the features of the model
+         */
+    Eigen::VectorXd predictSparse(const SparseRowMatrixType &X, long numIterations, int numThreads, bool rawScore,
+                                  PredictionEngine engine = PredictionEngine::TreeTraversal) const
+    {
+        if (!isCanonical(X))
         {
-            if (limit < numIterations)
-            {
-                score += tree.score(x);
-                limit++;
-            }
-            else
-                break;
+            return predictSparse(canonicalCopy(X), numIterations, numThreads, rawScore, engine);
         }
-
-        return (double)score;
+        checkNumFeatures(X.cols());
+        return predictRows(static_cast<size_t>(X.rows()),
+                           [&X](size_t i) { return SparseRowSample(X, static_cast<long>(i)); },
+                           numIterations, numThreads, rawScore, engine);
     }
 
-    Vector predictDataset(const Dataset &trainSet) const
+    Vector predictDataset(const BasicDataset<Feature> &trainSet) const
     {
-        size_t numSamples = trainSet.nRows(), numTrees = _trees.size();
+        size_t numSamples = trainSet.nRows(), numTrees = _forest.numTrees();
         Vector scores(numSamples);
         for (size_t i = 0; i < numSamples; i++)
         {
@@ -222,4 +1074,9 @@ public:
         return scores;
     }
 };
+
+using GBT = BasicGBT<double>;
+using GBTFloat32 = BasicGBT<float>;
+using GBTInt16 = BasicGBT<int16_t>;
+using GBTUInt8 = BasicGBT<uint8_t>;
 } // namespace microgbt
\ No newline at end of file
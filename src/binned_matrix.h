@@ -0,0 +1,321 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <Eigen/Dense>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "types.h"
+#include "dataset.h"
+
+namespace microgbt
+{
+
+/**
+    * BinnedMatrix is a quantized copy of a design matrix used by histogram-based split finding.
+    *
+    * Each feature is quantized once into at most 255 bins and every value is replaced by its uint8 bin code.
+    * The bins of a feature are defined by an increasing list of thresholds t_1 < t_2 < ... < t_k; a value x
+    * falls into bin b, where b is the number of thresholds that are less or equal to x. Hence, bin(x) <= b
+    * holds if and only if x < t_{b+1}, which is exactly the "go left" test of a tree node with threshold t_{b+1}.
+    *
+    * Missing values (NaN) always fall into the last bin, i.e., they follow the right branch as in TreeNode::score.
+    *
+    * The codes are either owned by the matrix, or a view of a memory-mapped file of pre-binned columns (see
+    * BinnedFile) for out-of-core training: then, the pages of a column are read ahead and released block by block
+    * (see prefetch and release), so that only a few blocks per column are resident at any time.
+    */
+class BinnedMatrix
+{
+
+    // Number of rows (samples) and columns (features)
+    long _rows = 0, _cols = 0;
+
+    // Bin codes in column-major order, i.e., codes of feature j are stored at [j * stride, j * stride + rows)
+    const uint8_t *_codes = nullptr;
+    size_t _columnStride = 0;
+
+    // Owner of the codes: a vector, or a memory-mapped file
+    std::shared_ptr<const void> _owner;
+
+    // Whether the codes are memory-mapped, i.e., their pages are read ahead and released explicitly
+    bool _mapped = false;
+
+    // Bin thresholds per feature
+    std::vector<Vector> _thresholds;
+
+    /**
+         * Apply a memory advice to the pages of the codes of rows [firstRow, lastRow] of a feature
+         *
+         * @param featureId Feature index
+         * @param firstRow First row
+         * @param lastRow Last row
+         * @param advice madvise advice
+         * @param partialPages Whether pages that also hold codes outside the rows are included
+         */
+    void advise(long featureId, size_t firstRow, size_t lastRow, int advice, bool partialPages) const
+    {
+        static const uintptr_t pageSize = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+        uintptr_t begin = reinterpret_cast<uintptr_t>(column(featureId) + firstRow);
+        uintptr_t end = reinterpret_cast<uintptr_t>(column(featureId) + lastRow + 1);
+        begin = partialPages ? (begin & ~(pageSize - 1)) : ((begin + pageSize - 1) & ~(pageSize - 1));
+        end = partialPages ? ((end + pageSize - 1) & ~(pageSize - 1)) : (end & ~(pageSize - 1));
+        if (begin < end)
+        {
+            ::madvise(reinterpret_cast<void *>(begin), end - begin, advice);
+        }
+    }
+
+    /**
+         * Allocate owned codes for all rows and columns
+         */
+    uint8_t *allocateCodes()
+    {
+        std::shared_ptr<std::vector<uint8_t>> codes =
+            std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(_rows * _cols));
+        _codes = codes->data();
+        _columnStride = static_cast<size_t>(_rows);
+        _owner = codes;
+        return codes->data();
+    }
+
+    /**
+         * Compute at most maxBin - 1 thresholds of a feature based on the quantiles of its non-missing values
+         *
+         * @param values Feature values
+         * @param maxBin Maximum number of bins
+         * @return Increasing list of bin thresholds
+         */
+    static Vector computeThresholds(Vector values, int maxBin)
+    {
+        values.erase(std::remove_if(values.begin(), values.end(),
+                                    [](double v) { return std::isnan(v); }),
+                     values.end());
+        std::sort(values.begin(), values.end());
+
+        Vector distinct(values);
+        distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+
+        Vector thresholds;
+        if (distinct.size() <= static_cast<size_t>(maxBin))
+        {
+            // One bin per distinct value
+            if (!distinct.empty())
+            {
+                thresholds.assign(distinct.begin() + 1, distinct.end());
+            }
+            return thresholds;
+        }
+
+        // Quantile bins: every threshold is a feature value, so that equal values never span two bins
+        size_t n = values.size();
+        for (int k = 1; k < maxBin; k++)
+        {
+            double candidate = values[(k * n) / maxBin];
+            if (candidate > values.front() && (thresholds.empty() || candidate > thresholds.back()))
+            {
+                thresholds.push_back(candidate);
+            }
+        }
+
+        return thresholds;
+    }
+
+    /**
+         * Compute the thresholds and bin codes of every feature
+         *
+         * @param valueAt Feature value at (global row index, feature index)
+         * @param maxBin Maximum number of bins per feature
+         */
+    template <typename ValueAt>
+    void binColumns(const ValueAt &valueAt, int maxBin)
+    {
+        maxBin = std::max(2, std::min(maxBin, static_cast<int>(MaxBins)));
+
+        uint8_t *allCodes = allocateCodes();
+        Vector column(static_cast<size_t>(_rows));
+        for (long j = 0; j < _cols; j++)
+        {
+            for (long i = 0; i < _rows; i++)
+            {
+                column[i] = valueAt(i, j);
+            }
+            _thresholds[j] = computeThresholds(column, maxBin);
+
+            uint8_t *codes = allCodes + j * _rows;
+            for (long i = 0; i < _rows; i++)
+            {
+                codes[i] = code(_thresholds[j], column[i]);
+            }
+        }
+    }
+
+public:
+    // Largest number of bins per feature supported by uint8 bin codes
+    static constexpr int MaxBins = 255;
+
+    /**
+         * View of a row, i.e., sample[featureId] is a representative feature value of its bin: the lower threshold
+         * of the bin (minus infinity for the first bin). The value follows the same branch as any value of the bin
+         * at every split on a bin threshold, e.g., at every split of a tree trained on these bins.
+         */
+    class Sample
+    {
+        const BinnedMatrix *_bins;
+        size_t _rowIndex;
+
+    public:
+        Sample(const BinnedMatrix *bins, size_t rowIndex) : _bins(bins), _rowIndex(rowIndex) {}
+
+        inline double operator[](long featureId) const
+        {
+            uint8_t bin = _bins->column(featureId)[_rowIndex];
+            return (bin == 0) ? -std::numeric_limits<double>::infinity() : _bins->threshold(featureId, bin - 1);
+        }
+    };
+
+    // Number of rows per block of out-of-core processing
+    static constexpr size_t BlockRows = 1 << 16;
+
+    BinnedMatrix() = default;
+
+    /**
+         * Bin code of a value, i.e., the number of thresholds that are less or equal to it
+         *
+         * @param thresholds Increasing list of bin thresholds
+         * @param value Feature value
+         */
+    static inline uint8_t code(const Vector &thresholds, double value)
+    {
+        return static_cast<uint8_t>(std::upper_bound(thresholds.begin(), thresholds.end(), value) - thresholds.begin());
+    }
+
+    /**
+         * Construct a matrix that is a view of memory-mapped codes, e.g., of a BinnedFile
+         *
+         * @param codes Codes of feature j at [j * columnStride, j * columnStride + rows)
+         * @param rows Number of rows
+         * @param columnStride Distance between the first codes of consecutive features
+         * @param thresholds Bin thresholds per feature
+         * @param owner Owner of the mapping, kept alive by the matrix
+         */
+    static BinnedMatrix mappedView(const uint8_t *codes, long rows, size_t columnStride,
+                                   std::vector<Vector> thresholds, std::shared_ptr<const void> owner)
+    {
+        BinnedMatrix bins;
+        bins._rows = rows;
+        bins._cols = static_cast<long>(thresholds.size());
+        bins._codes = codes;
+        bins._columnStride = columnStride;
+        bins._owner = std::move(owner);
+        bins._mapped = true;
+        bins._thresholds = std::move(thresholds);
+        return bins;
+    }
+
+    /**
+         * Quantize every feature (column) of a design matrix
+         *
+         * @param X Design matrix, each row corresponds to a sample; each column corresponds to a feature
+         * @param maxBin Maximum number of bins per feature, capped to MaxBins
+         */
+    BinnedMatrix(const ColMajorMatrixRef &X, int maxBin) : _rows(X.rows()), _cols(X.cols()),
+                                                            _thresholds(static_cast<size_t>(X.cols()))
+    {
+        binColumns([&X](long i, long j) { return X(i, j); }, maxBin);
+    }
+
+    /**
+         * Quantize every feature of the design matrix of a dataset, i.e., all rows of its root dataset
+         *
+         * Quantized features are binned on the lower bounds of their codes (see FeatureScale), so that bin
+         * thresholds agree with the split values of exact split finding: every raw value of a code follows the
+         * branch of the code at prediction time.
+         *
+         * @param dataset Dataset of any storage type
+         * @param maxBin Maximum number of bins per feature, capped to MaxBins
+         */
+    template <typename Feature>
+    BinnedMatrix(const BasicDataset<Feature> &dataset, int maxBin)
+        : _rows(dataset.X().rows()), _cols(dataset.X().cols()),
+          _thresholds(static_cast<size_t>(dataset.X().cols()))
+    {
+        const FeatureMatrixView<Feature> &X = dataset.X();
+        const FeatureScale<Feature> &scale = *dataset.scale();
+
+        // The lower bound of the missing code is NaN, i.e., missing values stay missing
+        binColumns([&X, &scale](long i, long j) { return scale.lowerBound(j, X(i, j)); }, maxBin);
+    }
+
+    inline long rows() const { return _rows; }
+
+    inline long numFeatures() const { return _cols; }
+
+    /**
+         * Number of bins of a feature
+         *
+         * @param featureId Feature index
+         */
+    inline int numBins(long featureId) const { return static_cast<int>(_thresholds[featureId].size()) + 1; }
+
+    /**
+         * Bin codes of a feature, indexed by (global) row index
+         *
+         * @param featureId Feature index
+         */
+    inline const uint8_t *column(long featureId) const { return _codes + featureId * _columnStride; }
+
+    inline bool isMapped() const { return _mapped; }
+
+    /**
+         * Return a view of a row
+         *
+         * @param rowIndex Row index
+         */
+    inline Sample sample(size_t rowIndex) const { return Sample(this, rowIndex); }
+
+    /**
+         * Read ahead the codes of rows [firstRow, lastRow] of a feature, i.e., start their I/O asynchronously;
+         * no-op unless the codes are memory-mapped
+         */
+    inline void prefetch(long featureId, size_t firstRow, size_t lastRow) const
+    {
+        if (_mapped)
+        {
+            advise(featureId, firstRow, lastRow, MADV_WILLNEED, true);
+        }
+    }
+
+    /**
+         * Release the resident pages of the codes of rows [firstRow, lastRow] of a feature, which are read again
+         * from the file on their next access; no-op unless the codes are memory-mapped
+         */
+    inline void release(long featureId, size_t firstRow, size_t lastRow) const
+    {
+        if (_mapped)
+        {
+            advise(featureId, firstRow, lastRow, MADV_DONTNEED, false);
+        }
+    }
+
+    /**
+         * Bin thresholds of a feature
+         *
+         * @param featureId Feature index
+         */
+    inline const Vector &thresholds(long featureId) const { return _thresholds[featureId]; }
+
+    /**
+         * Numeric split value that separates bins [0, bin] from bins (bin, numBins)
+         *
+         * @param featureId Feature index
+         * @param bin Last bin of the left side
+         */
+    inline double threshold(long featureId, int bin) const { return _thresholds[featureId][bin]; }
+};
+} // namespace microgbt
@@ -0,0 +1,169 @@
+#pragma once
+#include <string>
+#include <sstream>
+#include <cstdio>
+#include <algorithm>
+
+#include "../GBT.h"
+
+namespace microgbt
+{
+
+/**
+     * CodeGenerator emits a trained GBT as a standalone C++ header without any dependency on microgbt.
+     *
+     * Every tree becomes a function of nested if/else branches whose feature indices, thresholds and leaf weights
+     * are compile-time constants, and the metric's score-to-prediction transformation is inlined. The generated
+     * functions return exactly the same values as GBT::sumScore and GBT::predict.
+     *
+     * Generated API (inside the given namespace), where x points to the features of a sample:
+     *      double raw_score(const double *x);
+     *      double predict(const double *x);
+     */
+class CodeGenerator
+{
+
+    /**
+         * Format a double so that it is parsed back to exactly the same value
+         */
+    static std::string literal(double value)
+    {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.17g", value);
+
+        std::string text(buffer);
+        if (text.find_first_of(".en") == std::string::npos)
+        {
+            text += ".0";
+        }
+        return text;
+    }
+
+    static void indentLines(std::ostringstream &out, const std::string &source, int indent)
+    {
+        std::istringstream lines(source);
+        std::string line;
+        while (std::getline(lines, line))
+        {
+            out << std::string(indent, ' ') << line << "\n";
+        }
+    }
+
+    /**
+         * Source of the membership test of categorical splits, see CategorySet::contains
+         */
+    static std::string categorySetSource()
+    {
+        std::ostringstream out;
+        out << "inline bool in_category_set(const unsigned int *words, unsigned long num_words, double value)\n{\n";
+        out << "    if (!(value >= 0.0 && value <= " << literal(static_cast<double>(CategorySet::MaxCategory)) << "))\n";
+        out << "    {\n";
+        out << "        return false;\n";
+        out << "    }\n";
+        out << "    unsigned long c = (unsigned long)value;\n";
+        out << "    return c / 32 < num_words && ((words[c / 32] >> (c % 32)) & 1u) != 0;\n";
+        out << "}\n\n";
+        return out.str();
+    }
+
+    static void emitNode(std::ostringstream &out, const FlatForest &forest, size_t node, int indent)
+    {
+        std::string pad(indent, ' ');
+        if (forest.isLeaf(node))
+        {
+            out << pad << "return " << literal(forest.leafValue(node)) << ";\n";
+            return;
+        }
+
+        if (forest.isCategorical(node))
+        {
+            // The set of categories of the left branch is a static array of bitset words
+            size_t numWords = forest.numCategoryWords(node);
+            out << pad << "static const unsigned int categories_" << node << "[] = {";
+            for (size_t w = 0; w < numWords; w++)
+            {
+                out << (w > 0 ? ", " : "") << forest.categories(node)[w] << "u";
+            }
+            out << "};\n";
+            out << pad << "if (in_category_set(categories_" << node << ", " << numWords << ", x["
+                << forest.featureIndex(node) << "]))\n";
+        }
+        else
+        {
+            out << pad << "if (x[" << forest.featureIndex(node) << "] < " << literal(forest.threshold(node));
+            if (forest.defaultLeft(node))
+            {
+                out << " || std::isnan(x[" << forest.featureIndex(node) << "])";
+            }
+            out << ")\n";
+        }
+        out << pad << "{\n";
+        emitNode(out, forest, forest.leftChild(node), indent + 4);
+        out << pad << "}\n";
+        out << pad << "else\n";
+        out << pad << "{\n";
+        emitNode(out, forest, forest.rightChild(node), indent + 4);
+        out << pad << "}\n";
+    }
+
+public:
+    /**
+         * Generate the C++ header of a trained model
+         *
+         * @param gbt Trained model
+         * @param numIterations Number of trees to export; all trees if zero
+         * @param namespaceName Namespace of the generated functions
+         * @return Source code of the header
+         */
+    template <typename Feature>
+    static std::string generate(const BasicGBT<Feature> &gbt, long numIterations, const std::string &namespaceName)
+    {
+        const FlatForest &forest = gbt.forest();
+        size_t numTrees = (numIterations <= 0) ? forest.numTrees()
+                                               : std::min(forest.numTrees(), static_cast<size_t>(numIterations));
+
+        std::ostringstream out;
+        out << "// Generated by microgbt: " << numTrees << " trees. Do not edit.\n";
+        out << "#pragma once\n";
+        out << "#include <cmath>\n\n";
+        out << "namespace " << namespaceName << "\n{\n\n";
+
+        size_t numNodes = (numTrees < forest.numTrees()) ? forest.treeOffset(numTrees) : forest.numNodes();
+        for (size_t node = 0; node < numNodes; node++)
+        {
+            if (forest.isCategorical(node))
+            {
+                out << categorySetSource();
+                break;
+            }
+        }
+
+        for (size_t t = 0; t < numTrees; t++)
+        {
+            out << "inline double tree_" << t << "(const double *x)\n{\n";
+            emitNode(out, forest, forest.treeOffset(t), 4);
+            out << "}\n\n";
+        }
+
+        out << "inline double raw_score(const double *x)\n{\n";
+        out << "    long double score = 0.0;\n";
+        for (size_t t = 0; t < numTrees; t++)
+        {
+            out << "    score += tree_" << t << "(x);\n";
+        }
+        out << "    return (double)score;\n";
+        out << "}\n\n";
+
+        out << "inline double score_to_prediction(double score)\n{\n";
+        indentLines(out, gbt.metric().scoreToPredictionSource(), 4);
+        out << "}\n\n";
+
+        out << "inline double predict(const double *x)\n{\n";
+        out << "    return score_to_prediction(raw_score(x));\n";
+        out << "}\n\n";
+
+        out << "} // namespace " << namespaceName << "\n";
+        return out.str();
+    }
+};
+} // namespace microgbt
@@ -3,32 +3,275 @@
 #include <iostream>
 #include <Eigen/Dense>
 #include <numeric>
+#include <algorithm>
 #include <memory>
+#include <utility>
+#include <cmath>
 
 #include "trees/split_info.h"
 #include "types.h"
+#include "feature_scale.h"
+#include "sparse_matrix.h"
+#include "utils/arena.h"
 
 namespace microgbt
 {
 
+// Sorted local row indices of a feature of a dataset, a view of its sorted column indices
+using SortedIndices = Eigen::Map<const Eigen::RowVectorXi>;
+
 /**
     * Dataset represents a machine learning "design matrix" and target vector, (X, y)
     * where the rows and columns of matrix X represent the samples and features, respectively. y is the target vector
     * to be predicted
+    *
+    * The design matrix is stored with element type Feature: double, float, or an integer type (e.g., int16_t or
+    * uint8_t) for quantized storage, whose codes are mapped to feature values by a per-feature scale table
+    * (see FeatureScale). All accessors return feature values as double.
+    *
+    * Alternatively, the design matrix is a compressed sparse column matrix of doubles, whose entries that are not
+    * stored are missing values (as NaN values of a dense matrix). Sorted column indices are then only maintained
+    * for the stored values, i.e., memory and split finding cost scale with the number of stored values.
     */
-class Dataset
+template <typename Feature>
+class BasicDataset
 {
 
-    // Design matrix, each row corresponds to a sample; each column corresponds to a feature
-    std::shared_ptr<MatrixType> _X;
+    // Design matrix, each row corresponds to a sample; each column corresponds to a feature.
+    // It is a view of either a copy owned by the dataset or a caller-owned buffer, shared by all derived datasets
+    std::shared_ptr<const FeatureMatrixView<Feature>> _X;
+
+    // Mapping of stored values to feature values, shared by all derived datasets
+    std::shared_ptr<const FeatureScale<Feature>> _scale;
+
+    // Target vector, indexed by global row index
+    const double *_y = nullptr;
+
+    // Owner of the buffers viewed by _X and _y; nullptr if they are owned by the caller
+    std::shared_ptr<const void> _owner;
 
-    // Target vector
-    std::shared_ptr<Vector> _y;
+    // Sparse design matrix, shared by all derived datasets; nullptr unless the dataset is sparse, in which case _X
+    // has no rows
+    std::shared_ptr<const SparseMatrixType> _sparseX;
 
-    SortedMatrixType _sortedMatrixIdx;
+    // Sorted column indices of a sparse dataset: the stored (non-NaN) values of feature j are the entries
+    // [_sparseOffsets[j], _sparseOffsets[j + 1]), in increasing order of value, with local row index _sparseRows[k]
+    // and value _sparseX->valuePtr()[_sparseEntries[k]]
+    std::vector<int> _sparseRows, _sparseEntries;
+    std::vector<size_t> _sparseOffsets;
+
+    /**
+         * Sort the column indices of the root dataset, i.e., all rows of the design matrix
+         */
+    void sortColumns()
+    {
+        _rowIndices = VectorT(static_cast<size_t>(_X->rows()));
+        // By default, all rows are included in the dataset
+        std::iota(_rowIndices.begin(), _rowIndices.end(), 0);
+
+        // By default, all features are included in the dataset
+        _features = allFeatures(_X->cols());
+        _featureSlots = featureSlots(*_features, _X->cols());
+
+        _sortedIndices.resize(static_cast<size_t>(_X->rows() * _X->cols()));
+        for (long j = 0; j < _X->cols(); j++)
+        {
+            Eigen::VectorXi sorted = sortIndices(j);
+            std::copy(sorted.data(), sorted.data() + sorted.size(), _sortedIndices.data() + j * _X->rows());
+        }
+    }
+
+    static std::shared_ptr<const VectorT> allFeatures(long numFeatures)
+    {
+        std::shared_ptr<VectorT> features = std::make_shared<VectorT>(static_cast<size_t>(numFeatures));
+        std::iota(features->begin(), features->end(), 0);
+        return features;
+    }
+
+    /**
+         * Return the slot of each feature among an increasing list of features, i.e., its position; -1 for the
+         * features that are not listed
+         */
+    static std::shared_ptr<const std::vector<int>> featureSlots(const VectorT &features, long numFeatures)
+    {
+        std::shared_ptr<std::vector<int>> slots = std::make_shared<std::vector<int>>(static_cast<size_t>(numFeatures), -1);
+        for (size_t f = 0; f < features.size(); f++)
+        {
+            (*slots)[features[f]] = static_cast<int>(f);
+        }
+        return slots;
+    }
+
+    /**
+         * Sort the stored values of each column of the root sparse dataset
+         */
+    void sortSparseColumns()
+    {
+        _rowIndices = VectorT(static_cast<size_t>(_sparseX->rows()));
+        std::iota(_rowIndices.begin(), _rowIndices.end(), 0);
+        _features = allFeatures(_sparseX->cols());
+        _hasSortedColumns = false;
+
+        const int *outer = _sparseX->outerIndexPtr(), *inner = _sparseX->innerIndexPtr();
+        const double *values = _sparseX->valuePtr();
+        _sparseOffsets.assign(1, 0);
+        for (long j = 0; j < _sparseX->cols(); j++)
+        {
+            size_t begin = _sparseEntries.size();
+            for (int k = outer[j]; k < outer[j + 1]; k++)
+            {
+                if (!std::isnan(values[k]))
+                {
+                    _sparseEntries.push_back(k);
+                }
+            }
+            std::stable_sort(_sparseEntries.begin() + begin, _sparseEntries.end(),
+                             [values](int k1, int k2) { return values[k1] < values[k2]; });
+            _sparseOffsets.push_back(_sparseEntries.size());
+        }
+
+        // Rows of the root dataset are the rows of the matrix
+        _sparseRows.resize(_sparseEntries.size());
+        for (size_t k = 0; k < _sparseEntries.size(); k++)
+        {
+            _sparseRows[k] = inner[_sparseEntries[k]];
+        }
+    }
+
+    /**
+         * Return a feature value of a sample, NaN if it is missing
+         *
+         * @param globalRow Global row index of the sample
+         * @param colIndex Feature / column index
+         */
+    inline double globalValue(size_t globalRow, long colIndex) const
+    {
+        if (_sparseX)
+        {
+            return sparseValue(*_sparseX, colIndex, static_cast<long>(globalRow));
+        }
+        return _scale->value(colIndex, _X->coeff(globalRow, colIndex));
+    }
+
+    // Sorted column indices of the features of the dataset: the sorted local row indices of feature j are
+    // [s * nRows(), (s + 1) * nRows()), where s is the slot of j (see _featureSlots)
+    std::vector<int> _sortedIndices;
 
     VectorT _rowIndices;
 
+    // Increasing list of the feature indices of the dataset, i.e., the ones considered by split finding, shared
+    // with the datasets derived from it. Sorted column indices are maintained for these features only
+    std::shared_ptr<const VectorT> _features;
+
+    // Slot of each feature in the sorted column indices, i.e., its position in _features (-1 for the other
+    // features), shared with the datasets derived from it; nullptr without sorted column indices
+    std::shared_ptr<const std::vector<int>> _featureSlots;
+
+    // Arena that the buffers of the dataset come from and are released to, if any; it must outlive the dataset
+    ScratchArena *_arena = nullptr;
+
+    /**
+         * Initialize the dataset to a subset of the samples and features of another dataset
+         *
+         * @param dataset Parent dataset
+         * @param localIds Distinct local row indices of the parent dataset; they become local rows 0, 1, ...
+         * @param numIds Number of local row indices
+         * @param features Increasing list of feature indices, a subset of the features of the parent dataset
+         */
+    template <typename Index>
+    void assignSubset(BasicDataset const &dataset, const Index *localIds, size_t numIds,
+                      std::shared_ptr<const VectorT> features)
+    {
+
+        _X = dataset._X;
+        _scale = dataset._scale;
+        _y = dataset._y;
+        _owner = dataset._owner;
+        _sparseX = dataset._sparseX;
+
+        // Map each local row index of the parent dataset to its local row index in this dataset (or -1)
+        std::vector<int> parentToLocal = acquire(_arena ? &_arena->ints : nullptr, dataset._rowIndices.size());
+        std::fill(parentToLocal.begin(), parentToLocal.end(), -1);
+        _rowIndices = acquire(_arena ? &_arena->indices : nullptr, numIds);
+        for (size_t i = 0; i < numIds; i++)
+        {
+            _rowIndices[i] = dataset._rowIndices[localIds[i]];
+            parentToLocal[localIds[i]] = static_cast<int>(i);
+        }
+
+        long rows = static_cast<long>(_rowIndices.size()), parentRows = dataset.nRows();
+        long cols = dataset.numFeatures();
+
+        _features = std::move(features);
+        _hasSortedColumns = dataset._hasSortedColumns;
+        if (_sparseX)
+        {
+            // Linear time in the number of stored values of the parent dataset; features that are not selected
+            // have no stored values
+            _sparseRows = acquire(_arena ? &_arena->ints : nullptr, dataset._sparseRows.size());
+            _sparseEntries = acquire(_arena ? &_arena->ints : nullptr, dataset._sparseEntries.size());
+            _sparseOffsets = acquire(_arena ? &_arena->indices : nullptr, static_cast<size_t>(cols) + 1);
+            size_t numStored = 0;
+            _sparseOffsets[0] = 0;
+            for (size_t j = 0, f = 0; j < static_cast<size_t>(cols); j++)
+            {
+                if (f < _features->size() && (*_features)[f] == j)
+                {
+                    for (size_t k = dataset._sparseOffsets[j]; k < dataset._sparseOffsets[j + 1]; k++)
+                    {
+                        int localId = parentToLocal[dataset._sparseRows[k]];
+                        if (localId >= 0)
+                        {
+                            _sparseRows[numStored] = localId;
+                            _sparseEntries[numStored++] = dataset._sparseEntries[k];
+                        }
+                    }
+                    f++;
+                }
+                _sparseOffsets[j + 1] = numStored;
+            }
+            _sparseRows.resize(numStored);
+            _sparseEntries.resize(numStored);
+        }
+        else if (_hasSortedColumns)
+        {
+            // Only the features of the dataset have sorted column indices, in their slots
+            _featureSlots = (_features == dataset._features) ? dataset._featureSlots : featureSlots(*_features, cols);
+            _sortedIndices = acquire(_arena ? &_arena->ints : nullptr, static_cast<size_t>(rows) * _features->size());
+            for (size_t f = 0; f < _features->size(); f++)
+            {
+                size_t parentSlot = static_cast<size_t>((*dataset._featureSlots)[(*_features)[f]]);
+                const int *parentSorted = dataset._sortedIndices.data() + parentSlot * static_cast<size_t>(parentRows);
+                int *sorted = _sortedIndices.data() + f * static_cast<size_t>(rows);
+                for (long i = 0, k = 0; i < parentRows; i++)
+                {
+                    int localId = parentToLocal[parentSorted[i]];
+                    if (localId >= 0)
+                    {
+                        sorted[k++] = localId;
+                    }
+                }
+            }
+        }
+
+        if (_arena)
+        {
+            _arena->ints.release(std::move(parentToLocal));
+        }
+    }
+
+    /**
+         * Return a buffer of a given size from a pool, or a new one if there is no pool
+         */
+    template <typename Buffer>
+    static Buffer acquire(BufferPool<Buffer> *pool, size_t size)
+    {
+        return pool ? pool->acquire(size) : Buffer(size);
+    }
+
+    // Whether sorted column indices are maintained, i.e., unless the design matrix is not held in memory
+    bool _hasSortedColumns = true;
+
     /**
          * Return sorted indices from an Eigen vector
          * @param v
@@ -45,9 +288,10 @@ class Dataset
         // idx contains now 0,1,...,v.size() - 1
         std::iota(idx.data(), idx.data() + idx.size(), 0);
 
-        // sort indexes based on comparing values in v
-        std::sort(idx.data(), idx.data() + idx.size(),
-                  [&v](long i1, long i2) { return v[i1] < v[i2]; });
+        // sort indexes based on comparing values in v; stable, so that ties keep their row order. Missing (NaN)
+        // values come last
+        std::stable_sort(idx.data(), idx.data() + idx.size(),
+                  [&v](long i1, long i2) { return v[i1] < v[i2] || (std::isnan(v[i2]) && !std::isnan(v[i1])); });
 
         return idx;
     }
@@ -57,101 +301,318 @@ class Dataset
         Eigen::RowVectorXd column(_rowIndices.size());
         for (size_t i = 0; i < _rowIndices.size(); i++)
         {
-            column[i] = _X->coeffRef(_rowIndices[i], colIndex);
+            column[i] = _scale->value(colIndex, _X->coeff(_rowIndices[i], colIndex));
         }
         return column;
     }
 
 public:
-    Dataset() = default;
+    /**
+         * Lightweight view of a sample (row), i.e., sample[colIndex] is a feature value
+         */
+    class Sample
+    {
+        const BasicDataset *_dataset;
+        size_t _rowIndex;
+
+    public:
+        Sample(const BasicDataset *dataset, size_t rowIndex) : _dataset(dataset), _rowIndex(rowIndex) {}
+
+        inline double operator[](long colIndex) const { return _dataset->globalValue(_rowIndex, colIndex); }
+    };
 
-    Dataset(const MatrixType &X, const Vector &y) : _sortedMatrixIdx(X.rows(), X.cols()),
-                                                    _rowIndices(y.size())
+    BasicDataset() = default;
+
+    /**
+         * Construct a Dataset that owns a copy of (X, y), converted to the storage type
+         *
+         * @param X Design matrix
+         * @param y Target vector
+         * @param scale Scale table of the storage type, e.g., the one of a training dataset; if nullptr, it is
+         *              fitted to X
+         */
+    BasicDataset(const ColMajorMatrixRef &X, const Vector &y,
+                 std::shared_ptr<const FeatureScale<Feature>> scale = nullptr)
+    {
+        _scale = scale ? std::move(scale) : std::make_shared<const FeatureScale<Feature>>(X);
+        std::shared_ptr<std::pair<FeatureMatrix<Feature>, Vector>> copy =
+            std::make_shared<std::pair<FeatureMatrix<Feature>, Vector>>(_scale->quantize(X), y);
+        _X = std::make_shared<const FeatureMatrixView<Feature>>(copy->first.data(), X.rows(), X.cols(),
+                                                                Eigen::OuterStride<>(X.rows()));
+        _y = copy->second.data();
+        _owner = copy;
+        sortColumns();
+    }
+
+    /**
+         * Construct a Dataset that wraps caller-owned buffers, i.e., without copying X or y
+         *
+         * The buffers must remain valid and unmodified as long as the dataset, or any dataset derived from it,
+         * exists. A non-null owner (e.g., a numpy array held by the Python binding) is kept alive for that long.
+         *
+         * @param X Column-major design matrix of stored values
+         * @param y Target vector of X.rows() values
+         * @param owner Owner of the buffers, if any
+         * @param scale Scale table of the stored values; if nullptr, stored values are feature values
+         */
+    BasicDataset(const FeatureMatrixView<Feature> &X, const double *y, std::shared_ptr<const void> owner = nullptr,
+                 std::shared_ptr<const FeatureScale<Feature>> scale = nullptr)
+        : _X(std::make_shared<const FeatureMatrixView<Feature>>(X)), _y(y), _owner(std::move(owner))
+    {
+        _scale = scale ? std::move(scale) : std::make_shared<const FeatureScale<Feature>>(X.cols());
+        sortColumns();
+    }
+
+    /**
+         * Construct a Dataset of the rows of a design matrix that is not held in memory, e.g., of a file of
+         * pre-binned columns (see BinnedFile) for out-of-core training
+         *
+         * The dataset only tracks row indices, features and targets: it supports split finding on pre-binned
+         * features (see HistogramSplitter), but neither X(), row(), sample(), value() nor sortedColumnIndices().
+         *
+         * @param numRows Number of rows
+         * @param numFeatures Number of features
+         * @param y Target vector of numRows values
+         * @param owner Owner of the target buffer, if any
+         */
+    BasicDataset(long numRows, long numFeatures, const double *y, std::shared_ptr<const void> owner = nullptr)
+        : _X(std::make_shared<const FeatureMatrixView<Feature>>(nullptr, 0, numFeatures, Eigen::OuterStride<>(0))),
+          _scale(std::make_shared<const FeatureScale<Feature>>(numFeatures)), _y(y), _owner(std::move(owner)),
+          _rowIndices(static_cast<size_t>(numRows)), _features(allFeatures(numFeatures)), _hasSortedColumns(false)
     {
-        _X = std::make_shared<MatrixType>(X);
-        _y = std::make_shared<Vector>(y);
-        // By default, all rows are included in the dataset
         std::iota(_rowIndices.begin(), _rowIndices.end(), 0);
+    }
+
+    /**
+         * Construct a sparse Dataset that owns a copy of (X, y)
+         *
+         * Entries of X that are not stored, as well as stored NaN values, are missing values. Split finding (see
+         * NumericalSplitter) only scans the stored values of each feature and learns the direction of the missing
+         * ones.
+         *
+         * @param X Compressed sparse column design matrix
+         * @param y Target vector
+         */
+    BasicDataset(const SparseMatrixType &X, const Vector &y)
+    {
+        std::shared_ptr<std::pair<SparseMatrixType, Vector>> copy =
+            std::make_shared<std::pair<SparseMatrixType, Vector>>(canonicalCopy(X), y);
+        _sparseX = std::shared_ptr<const SparseMatrixType>(copy, &copy->first);
+        _X = std::make_shared<const FeatureMatrixView<Feature>>(nullptr, 0, X.cols(), Eigen::OuterStride<>(0));
+        _scale = std::make_shared<const FeatureScale<Feature>>(X.cols());
+        _y = copy->second.data();
+        _owner = copy;
+        sortSparseColumns();
+    }
+
+    /**
+         * Copy a dataset; the buffers of the copy are its own, i.e., they are not released to the arena of dataset
+         */
+    BasicDataset(BasicDataset const &dataset)
+        : _X(dataset._X), _scale(dataset._scale), _y(dataset._y), _owner(dataset._owner),
+          _sparseX(dataset._sparseX), _sparseRows(dataset._sparseRows), _sparseEntries(dataset._sparseEntries),
+          _sparseOffsets(dataset._sparseOffsets), _sortedIndices(dataset._sortedIndices),
+          _rowIndices(dataset._rowIndices), _features(dataset._features), _featureSlots(dataset._featureSlots),
+          _hasSortedColumns(dataset._hasSortedColumns) {}
 
-        for (long j = 0; j < X.cols(); j++)
+    BasicDataset(BasicDataset &&dataset) = default;
+
+    BasicDataset &operator=(BasicDataset const &dataset)
+    {
+        return *this = BasicDataset(dataset);
+    }
+
+    BasicDataset &operator=(BasicDataset &&dataset) = default;
+
+    ~BasicDataset()
+    {
+        if (_arena)
         {
-            _sortedMatrixIdx.col(j) = sortIndices(j);
+            _arena->ints.release(std::move(_sortedIndices));
+            _arena->ints.release(std::move(_sparseRows));
+            _arena->ints.release(std::move(_sparseEntries));
+            _arena->indices.release(std::move(_rowIndices));
+            _arena->indices.release(std::move(_sparseOffsets));
         }
     }
 
-    Dataset(Dataset const &dataset) = default;
-
     /**
          * Construct a Dataset, given a binary split gain and lef/right side parameter
+         *
+         * The sorted column indices of the parent dataset are stably partitioned, so that no sorting takes place
+         * after the root dataset is built, i.e., the construction takes linear time per feature.
+         *
          * @param dataset
          * @param bestGain
          * @param side
+         * @param arena Arena of the buffers of the dataset, if any; it must outlive the dataset
          */
-    Dataset(Dataset const &dataset, const SplitInfo &bestGain, SplitInfo::Side side)
+    BasicDataset(BasicDataset const &dataset, const SplitInfo &bestGain, SplitInfo::Side side,
+                 ScratchArena *arena = nullptr)
+        : _arena(arena)
     {
+        assignSubset(dataset, bestGain.localIds(side), bestGain.numLocalIds(side), dataset._features);
+    }
 
-        _X = dataset.X();
-        _y = dataset.yptr();
+    /**
+         * Construct a Dataset of a subset of the samples of another dataset, e.g., a row sample, without copying
+         * the design matrix
+         *
+         * As for the datasets of a split, the sorted column indices of the parent dataset are stably partitioned.
+         *
+         * @param dataset Parent dataset
+         * @param localIds Distinct local row indices of the parent dataset; they become local rows 0, 1, ...
+         */
+    BasicDataset(BasicDataset const &dataset, const VectorT &localIds)
+    {
+        assignSubset(dataset, localIds.data(), localIds.size(), dataset._features);
+    }
 
-        VectorT localIds;
-        if (side == SplitInfo::Side::Left)
-        {
-            localIds = bestGain.getLeftLocalIds();
-        }
-        else
-        {
-            localIds = bestGain.getRightLocalIds();
-        }
+    /**
+         * Construct a Dataset of a subset of the samples and features of another dataset, e.g., a row and column
+         * sample, without copying the design matrix
+         *
+         * @param dataset Parent dataset
+         * @param localIds Distinct local row indices of the parent dataset; they become local rows 0, 1, ...
+         * @param features Increasing list of feature indices, a subset of the features of the parent dataset
+         * @param arena Arena of the buffers of the dataset, if any; it must outlive the dataset
+         */
+    BasicDataset(BasicDataset const &dataset, const VectorT &localIds, const VectorT &features,
+                 ScratchArena *arena = nullptr)
+        : _arena(arena)
+    {
+        assignSubset(dataset, localIds.data(), localIds.size(),
+                     (features == *dataset._features) ? dataset._features : std::make_shared<const VectorT>(features));
+    }
 
-        _rowIndices = VectorT(localIds.size());
-        VectorT otherRowIndices = dataset.rowIter();
-        for (size_t i = 0; i < localIds.size(); i++)
-        {
-            _rowIndices[i] = otherRowIndices[localIds[i]];
-        }
+    inline long nRows() const { return static_cast<long>(this->_rowIndices.size()); }
 
-        size_t rows = _rowIndices.size();
-        long cols = dataset.numFeatures();
+    inline const VectorT &rowIter() const { return _rowIndices; }
 
-        _sortedMatrixIdx = SortedMatrixType(rows, cols);
+    inline long numFeatures() const { return this->_X->cols(); }
 
-        for (long j = 0; j < cols; j++)
-        {
-            _sortedMatrixIdx.col(j) = sortIndices(j);
-        }
-    }
+    /**
+         * Increasing list of the feature indices considered by split finding, i.e., all features unless the
+         * dataset is a column sample
+         */
+    inline const VectorT &features() const { return *_features; }
 
-    inline long nRows() const { return static_cast<long>(this->_rowIndices.size()); }
+    /**
+         * Stored design matrix of the root dataset, i.e., indexed by global row index
+         */
+    inline const FeatureMatrixView<Feature> &X() const { return *_X; }
 
-    inline VectorT rowIter() const { return _rowIndices; }
+    /**
+         * Number of rows of the root dataset, i.e., the range of global row indices
+         */
+    inline long numGlobalRows() const { return _sparseX ? _sparseX->rows() : _X->rows(); }
 
-    inline long numFeatures() const { return this->_X->cols(); }
+    /**
+         * Whether the design matrix is sparse, i.e., sorted column indices are only maintained for stored values,
+         * see numStoredValues
+         */
+    inline bool isSparse() const { return _sparseX != nullptr; }
 
-    inline std::shared_ptr<MatrixType> X() const { return _X; }
+    inline const std::shared_ptr<const FeatureScale<Feature>> &scale() const { return _scale; }
 
-    inline std::shared_ptr<Vector> yptr() const { return _y; }
+    /**
+         * Number of bytes of the row indices and sorted column indices of the dataset, i.e., the memory that a
+         * derived dataset allocates (the design matrix is shared)
+         */
+    inline size_t indexBytes() const
+    {
+        return _rowIndices.size() * sizeof(size_t) + _sortedIndices.size() * sizeof(int) +
+               (_sparseRows.size() + _sparseEntries.size()) * sizeof(int) + _sparseOffsets.size() * sizeof(size_t);
+    }
 
     inline Vector y() const
     {
         Vector proj(_rowIndices.size());
         for (size_t i = 0; i < proj.size(); i++)
         {
-            proj[i] = (*_y)[_rowIndices[i]];
+            proj[i] = _y[_rowIndices[i]];
         }
         return proj;
     }
 
-    inline Eigen::RowVectorXd row(long rowIndex) const { return _X->row(_rowIndices[rowIndex]); }
+    inline Eigen::RowVectorXd row(long rowIndex) const
+    {
+        Eigen::RowVectorXd features(_X->cols());
+        for (long j = 0; j < _X->cols(); j++)
+        {
+            features[j] = value(rowIndex, j);
+        }
+        return features;
+    }
+
+    /**
+         * Return a view of a sample, without copying its features
+         *
+         * @param rowIndex Local row index of the sample
+         */
+    inline Sample sample(long rowIndex) const { return Sample(this, _rowIndices[rowIndex]); }
+
+    /**
+         * Return a single feature value of a sample
+         *
+         * @param rowIndex Local row index of the sample
+         * @param colIndex Feature / column index
+         */
+    inline double value(long rowIndex, long colIndex) const { return globalValue(_rowIndices[rowIndex], colIndex); }
+
+    /**
+         * Return the split value that separates a sample from all samples with smaller feature value, i.e., the
+         * smallest feature value represented by its stored value
+         *
+         * @param rowIndex Local row index of the sample
+         * @param colIndex Feature / column index
+         */
+    inline double splitValue(long rowIndex, long colIndex) const
+    {
+        if (_sparseX)
+        {
+            return value(rowIndex, colIndex);
+        }
+        return _scale->lowerBound(colIndex, _X->coeff(_rowIndices[rowIndex], colIndex));
+    }
 
     /**
          * Sort the sample indices for a given feature index 'feature_id'.
          *
-         * It returns sorted indices depending on type of feature (categorical or numeric):
-         * Categorical feature: performs mean target encoding (see feature/categorical branch)
-         * Numerical feature: natural sort on numeric value
+         * It returns the indices in natural order of the feature values (missing values last); for categorical
+         * features, the samples of every category are thus contiguous (see NumericalSplitter)
+         *
+         * @param colIndex Feature / column of above matrix, one of features()
+         */
+    inline SortedIndices sortedColumnIndices(long colIndex) const
+    {
+        return SortedIndices(_sortedIndices.data() + (*_featureSlots)[colIndex] * nRows(), nRows());
+    }
+
+    /**
+         * Sparse datasets: number of stored (non-missing) values of a feature, among the samples of the dataset
          *
-         * @param colIndex Feature / column of above matrix
+         * @param colIndex Feature / column index, one of features()
+         */
+    inline size_t numStoredValues(long colIndex) const
+    {
+        return _sparseOffsets[colIndex + 1] - _sparseOffsets[colIndex];
+    }
+
+    /**
+         * Sparse datasets: local row indices of the samples with a stored value of a feature, in increasing order
+         * of value, see numStoredValues
          */
-    inline Eigen::RowVectorXi sortedColumnIndices(long colIndex) const { return _sortedMatrixIdx.col(colIndex); }
+    inline const int *storedRows(long colIndex) const { return _sparseRows.data() + _sparseOffsets[colIndex]; }
+
+    /**
+         * Sparse datasets: k-th smallest stored value of a feature, i.e., the value of sample storedRows(colIndex)[k]
+         */
+    inline double storedValue(long colIndex, size_t k) const
+    {
+        return _sparseX->valuePtr()[_sparseEntries[_sparseOffsets[colIndex] + k]];
+    }
 };
+
+using Dataset = BasicDataset<double>;
 } // namespace microgbt
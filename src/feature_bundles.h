@@ -0,0 +1,248 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <memory>
+#include <stdexcept>
+
+#include "types.h"
+#include "binned_matrix.h"
+
+namespace microgbt
+{
+
+/**
+    * FeatureBundles is an exclusive feature bundling (EFB) of the columns of a BinnedMatrix.
+    *
+    * Sparse features, e.g., one-hot encoded categorical features, rarely take a value other than their most
+    * frequent one (their default bin) on the same row. Such nearly mutually exclusive features are merged into a
+    * single bundle column, where the non-default bins of every feature occupy their own range of bins (i.e., are
+    * stored at an offset) and bin 0 stands for the default bins of all of them. Histogram-based split finding
+    * accumulates histograms per bundle instead of per feature; the histogram of a bundled feature is read back
+    * from its range of bins, and its default bin is the difference between the totals of the node and its
+    * other bins. Features are greedily added to the first bundle on which they conflict on at most
+    * maxConflictRate * rows rows; on a conflicting row, the bundle keeps the bin of the feature bundled first.
+    *
+    * A feature that is not bundled with any other one forms a bundle on its own, whose column is the column of
+    * the feature, i.e., its histogram is not affected by bundling.
+    *
+    * Refer to "LightGBM: A Highly Efficient Gradient Boosting Decision Tree", NIPS 2017 (Algorithms 3 and 4)
+    */
+class FeatureBundles
+{
+
+    // Number of bins per bundle, i.e., the range of uint8 bin codes
+    static constexpr int MaxBundleBins = 256;
+
+    std::shared_ptr<const BinnedMatrix> _bins;
+
+    // Features of every bundle, in the order they were bundled, and the bundle of every feature
+    std::vector<VectorT> _bundleFeatures;
+    VectorT _featureBundle;
+
+    // Number of bins of every bundle
+    std::vector<int> _numBundleBins;
+
+    // Bundled features: default bin, and first bundle bin of their non-default bins
+    std::vector<int> _defaultBin, _binOffset;
+
+    // Codes of the bundles of several features, in column-major order; bundles of a single feature view the
+    // codes of their feature
+    std::vector<uint8_t> _codes;
+    std::vector<const uint8_t *> _columns;
+
+    /**
+         * Most frequent bin of a feature
+         */
+    int mostFrequentBin(long featureId) const
+    {
+        std::vector<size_t> counts(static_cast<size_t>(_bins->numBins(featureId)), 0);
+        const uint8_t *codes = _bins->column(featureId);
+        for (long i = 0; i < _bins->rows(); i++)
+        {
+            counts[codes[i]]++;
+        }
+        return static_cast<int>(std::max_element(counts.begin(), counts.end()) - counts.begin());
+    }
+
+public:
+    /**
+         * Bundle the features of a binned matrix
+         *
+         * @param bins Quantized design matrix, held in memory
+         * @param maxConflictRate Maximum fraction of the rows on which the features of a bundle may conflict, i.e.,
+         *                        on which more than one of them is not in its default bin
+         * @throws std::invalid_argument if bins are memory-mapped
+         */
+    FeatureBundles(std::shared_ptr<const BinnedMatrix> bins, double maxConflictRate) : _bins(std::move(bins))
+    {
+        // Bundles are held in memory, and their columns are not columns of bins that could be read ahead
+        if (_bins->isMapped())
+        {
+            throw std::invalid_argument("Memory-mapped bins cannot be bundled");
+        }
+
+        long rows = _bins->rows(), cols = _bins->numFeatures();
+        size_t maxConflicts = static_cast<size_t>(std::floor(std::max(0.0, maxConflictRate) * static_cast<double>(rows)));
+
+        // Rows of every feature that are not in its default bin
+        _defaultBin.assign(static_cast<size_t>(cols), 0);
+        std::vector<std::vector<int>> nonDefaultRows(static_cast<size_t>(cols));
+        for (long j = 0; j < cols; j++)
+        {
+            _defaultBin[j] = mostFrequentBin(j);
+            const uint8_t *codes = _bins->column(j);
+            for (long i = 0; i < rows; i++)
+            {
+                if (codes[i] != _defaultBin[j])
+                {
+                    nonDefaultRows[j].push_back(static_cast<int>(i));
+                }
+            }
+        }
+
+        // Densest features first; each one joins the first bundle with enough bins and few enough conflicts
+        VectorT order(static_cast<size_t>(cols));
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&nonDefaultRows](size_t a, size_t b) {
+            return nonDefaultRows[a].size() > nonDefaultRows[b].size();
+        });
+
+        std::vector<std::vector<bool>> occupied;
+        std::vector<size_t> conflicts;
+        _featureBundle.assign(static_cast<size_t>(cols), 0);
+        for (size_t j : order)
+        {
+            int extraBins = _bins->numBins(j) - 1;
+            size_t bundle = 0;
+            for (; bundle < _bundleFeatures.size(); bundle++)
+            {
+                if (_numBundleBins[bundle] + extraBins > MaxBundleBins)
+                {
+                    continue;
+                }
+
+                size_t count = conflicts[bundle];
+                for (size_t k = 0; k < nonDefaultRows[j].size() && count <= maxConflicts; k++)
+                {
+                    count += occupied[bundle][nonDefaultRows[j][k]] ? 1 : 0;
+                }
+                if (count <= maxConflicts)
+                {
+                    conflicts[bundle] = count;
+                    break;
+                }
+            }
+
+            if (bundle == _bundleFeatures.size())
+            {
+                _bundleFeatures.emplace_back();
+                _numBundleBins.push_back(1);
+                occupied.emplace_back(static_cast<size_t>(rows), false);
+                conflicts.push_back(0);
+            }
+            _bundleFeatures[bundle].push_back(j);
+            _featureBundle[j] = bundle;
+            _numBundleBins[bundle] += extraBins;
+            for (int i : nonDefaultRows[j])
+            {
+                occupied[bundle][i] = true;
+            }
+        }
+
+        // Bin offsets and codes of bundles of several features
+        _binOffset.assign(static_cast<size_t>(cols), 0);
+        size_t numBundled = 0;
+        for (const VectorT &features : _bundleFeatures)
+        {
+            numBundled += (features.size() > 1) ? 1 : 0;
+        }
+        _codes.assign(numBundled * static_cast<size_t>(rows), 0);
+
+        size_t next = 0;
+        for (size_t bundle = 0; bundle < _bundleFeatures.size(); bundle++)
+        {
+            const VectorT &features = _bundleFeatures[bundle];
+            if (features.size() == 1)
+            {
+                _numBundleBins[bundle] = _bins->numBins(features[0]);
+                _columns.push_back(_bins->column(features[0]));
+                continue;
+            }
+
+            uint8_t *codes = _codes.data() + (next++) * static_cast<size_t>(rows);
+            int offset = 1;
+            for (size_t j : features)
+            {
+                _binOffset[j] = offset;
+                const uint8_t *featureCodes = _bins->column(j);
+                for (int i : nonDefaultRows[j])
+                {
+                    if (codes[i] == 0)
+                    {
+                        int bin = featureCodes[i];
+                        codes[i] = static_cast<uint8_t>(offset + ((bin < _defaultBin[j]) ? bin : bin - 1));
+                    }
+                }
+                offset += _bins->numBins(j) - 1;
+            }
+            _columns.push_back(codes);
+        }
+    }
+
+    inline size_t numBundles() const { return _bundleFeatures.size(); }
+
+    inline size_t numFeatures() const { return _featureBundle.size(); }
+
+    /**
+         * Bundle of a feature
+         */
+    inline size_t bundle(long featureId) const { return _featureBundle[featureId]; }
+
+    /**
+         * Features of a bundle, in the order they were bundled
+         */
+    inline const VectorT &features(size_t bundle) const { return _bundleFeatures[bundle]; }
+
+    /**
+         * Whether a feature shares its bundle with other features, i.e., its bins are stored at an offset
+         */
+    inline bool isBundled(long featureId) const { return _bundleFeatures[_featureBundle[featureId]].size() > 1; }
+
+    inline int numBins(size_t bundle) const { return _numBundleBins[bundle]; }
+
+    /**
+         * Bin codes of a bundle, indexed by (global) row index
+         */
+    inline const uint8_t *column(size_t bundle) const { return _columns[bundle]; }
+
+    /**
+         * Bundled features: default (most frequent) bin
+         */
+    inline int defaultBin(long featureId) const { return _defaultBin[featureId]; }
+
+    /**
+         * Bundled features: bundle bin of the non-default bin b of the feature, i.e., binOffset + b (if b is less
+         * than the default bin) or binOffset + b - 1 (otherwise)
+         */
+    inline int binOffset(long featureId) const { return _binOffset[featureId]; }
+
+    /**
+         * Bundled features: bin of a feature represented by a bundle code
+         *
+         * @param featureId Feature index
+         * @param code Bin code of the bundle of the feature
+         */
+    inline int featureBin(long featureId, uint8_t code) const
+    {
+        int bin = static_cast<int>(code) - _binOffset[featureId];
+        if (bin < 0 || bin >= _bins->numBins(featureId) - 1)
+        {
+            return _defaultBin[featureId];
+        }
+        return (bin < _defaultBin[featureId]) ? bin : bin + 1;
+    }
+};
+} // namespace microgbt
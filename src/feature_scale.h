@@ -0,0 +1,182 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <type_traits>
+#include <Eigen/Dense>
+
+#include "types.h"
+
+namespace microgbt
+{
+
+/**
+    * FeatureScale maps the stored values of a feature matrix (see BasicDataset) to feature values.
+    *
+    * Floating point storage (double or float) stores the feature values themselves, hence the mapping is the
+    * identity and has no state.
+    */
+template <typename Feature, bool Quantized = std::is_integral<Feature>::value>
+class FeatureScale
+{
+public:
+    FeatureScale() = default;
+
+    explicit FeatureScale(long /* numFeatures */) {}
+
+    explicit FeatureScale(const ColMajorMatrixRef & /* X */) {}
+
+    /**
+         * Convert a design matrix to stored values
+         *
+         * @param X Design matrix
+         */
+    FeatureMatrix<Feature> quantize(const ColMajorMatrixRef &X) const { return X.template cast<Feature>(); }
+
+    /**
+         * Feature value of a stored value
+         *
+         * @param colIndex Feature index
+         * @param stored Stored value
+         */
+    inline double value(long /* colIndex */, Feature stored) const { return static_cast<double>(stored); }
+
+    /**
+         * Smallest feature value represented by a stored value
+         *
+         * @param colIndex Feature index
+         * @param stored Stored value
+         */
+    inline double lowerBound(long /* colIndex */, Feature stored) const { return static_cast<double>(stored); }
+};
+
+/**
+    * Per-feature scale table of quantized (int16, uint8, ...) feature storage.
+    *
+    * Feature j is stored as integer codes, where code c represents the value offset_j + scale_j * c. Values are
+    * rounded to the nearest code, hence code c represents all values in [value(c) - scale_j / 2, value(c) + scale_j / 2).
+    * The codes of a feature span the range of its values in the matrix that the table is fitted to; the largest
+    * code of the storage type is reserved for missing values (NaN).
+    */
+template <typename Feature>
+class FeatureScale<Feature, true>
+{
+
+    // Offset and scale per feature
+    Vector _offset, _scale;
+
+public:
+    // Code of missing values
+    static constexpr Feature MissingCode = std::numeric_limits<Feature>::max();
+
+    FeatureScale() = default;
+
+    /**
+         * Identity scale table, i.e., codes are feature values
+         *
+         * @param numFeatures Number of features
+         */
+    explicit FeatureScale(long numFeatures) : _offset(static_cast<size_t>(numFeatures), 0.0),
+                                              _scale(static_cast<size_t>(numFeatures), 1.0) {}
+
+    /**
+         * Fit the scale table of every feature (column) of a design matrix to the range of its values
+         *
+         * @param X Design matrix
+         */
+    explicit FeatureScale(const ColMajorMatrixRef &X) : _offset(static_cast<size_t>(X.cols())),
+                                                        _scale(static_cast<size_t>(X.cols()))
+    {
+        const double lowestCode = static_cast<double>(std::numeric_limits<Feature>::lowest());
+        const double numSteps = static_cast<double>(MissingCode) - 1.0 - lowestCode;
+
+        for (long j = 0; j < X.cols(); j++)
+        {
+            double minValue = std::numeric_limits<double>::infinity();
+            double maxValue = -std::numeric_limits<double>::infinity();
+            for (long i = 0; i < X.rows(); i++)
+            {
+                double value = X(i, j);
+                if (!std::isnan(value))
+                {
+                    minValue = std::min(minValue, value);
+                    maxValue = std::max(maxValue, value);
+                }
+            }
+            if (minValue > maxValue)
+            {
+                minValue = maxValue = 0.0;
+            }
+
+            double scale = (maxValue - minValue) / numSteps;
+            _scale[j] = (scale > 0.0) ? scale : 1.0;
+            _offset[j] = minValue - _scale[j] * lowestCode;
+        }
+    }
+
+    /**
+         * Code of a feature value, clamped to the codes of the feature
+         *
+         * @param colIndex Feature index
+         * @param value Feature value
+         */
+    inline Feature quantize(long colIndex, double value) const
+    {
+        if (std::isnan(value))
+        {
+            return MissingCode;
+        }
+
+        double code = std::round((value - _offset[colIndex]) / _scale[colIndex]);
+        code = std::max(static_cast<double>(std::numeric_limits<Feature>::lowest()),
+                        std::min(code, static_cast<double>(MissingCode) - 1.0));
+        return static_cast<Feature>(code);
+    }
+
+    /**
+         * Convert a design matrix to codes
+         *
+         * @param X Design matrix
+         */
+    FeatureMatrix<Feature> quantize(const ColMajorMatrixRef &X) const
+    {
+        FeatureMatrix<Feature> codes(X.rows(), X.cols());
+        for (long j = 0; j < X.cols(); j++)
+        {
+            for (long i = 0; i < X.rows(); i++)
+            {
+                codes(i, j) = quantize(j, X(i, j));
+            }
+        }
+        return codes;
+    }
+
+    /**
+         * Feature value of a code
+         *
+         * @param colIndex Feature index
+         * @param code Code
+         */
+    inline double value(long colIndex, Feature code) const
+    {
+        return (code == MissingCode) ? std::numeric_limits<double>::quiet_NaN()
+                                     : _offset[colIndex] + _scale[colIndex] * static_cast<double>(code);
+    }
+
+    /**
+         * Smallest feature value represented by a code, i.e., the boundary between the code and the previous one
+         *
+         * @param colIndex Feature index
+         * @param code Code
+         */
+    inline double lowerBound(long colIndex, Feature code) const { return value(colIndex, code) - _scale[colIndex] / 2.0; }
+
+    inline double offset(long colIndex) const { return _offset[colIndex]; }
+
+    inline double scale(long colIndex) const { return _scale[colIndex]; }
+};
+
+template <typename Feature>
+constexpr Feature FeatureScale<Feature, true>::MissingCode;
+} // namespace microgbt
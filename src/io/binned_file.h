@@ -0,0 +1,369 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../types.h"
+#include "../binned_matrix.h"
+#include "mapped_file.h"
+
+namespace microgbt
+{
+
+/**
+     * File of pre-binned training data for out-of-core training.
+     *
+     * A file consists of a fixed-size header, the bin thresholds of every feature, the targets and the bin codes of
+     * every feature (see BinnedMatrix):
+     *
+     *      [Header][threshold offsets][thresholds][targets][codes of feature 0][codes of feature 1]...
+     *
+     * The codes of every feature start at a page-aligned offset, so that training reads (and releases) the pages
+     * of a column block by block from a memory mapping of the file. Values are stored in the native byte order.
+     *
+     * Files are written by BinnedFileWriter in chunks of rows, i.e., the training data is never entirely in memory.
+     */
+class BinnedFile
+{
+
+    // Mapping of the file
+    std::shared_ptr<const MappedFile> _file;
+
+    // Bins viewing the mapping
+    std::shared_ptr<const BinnedMatrix> _bins;
+
+    const double *_targets = nullptr;
+
+public:
+    static constexpr uint32_t Version = 1;
+
+    static constexpr uint32_t ByteOrderMark = 0x01020304;
+
+    // Alignment of the codes of every feature, a multiple of the page size
+    static constexpr uint64_t ColumnAlignment = 4096;
+
+    static inline uint64_t alignUp(uint64_t offset, uint64_t alignment)
+    {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    /**
+         * Whether an array of count elements of elementSize bytes at offset lies within fileSize bytes; the
+         * arithmetic does not overflow for any header values
+         */
+    static inline bool fits(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t fileSize)
+    {
+        return offset <= fileSize && (elementSize == 0 || count <= (fileSize - offset) / elementSize);
+    }
+
+    /**
+         * File header: format information and layout
+         */
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint64_t fileSize;
+
+        // Number of rows (samples) and columns (features)
+        uint64_t rows, cols;
+
+        // Layout, offsets are relative to the beginning of the file. Thresholds of feature j are
+        // thresholds[thresholdOffsets[j], thresholdOffsets[j + 1]), codes of feature j start at
+        // codesOffset + j * columnStride
+        uint64_t thresholdOffsetsOffset, thresholdsOffset, targetsOffset, codesOffset, columnStride;
+    };
+
+    static_assert(std::is_standard_layout<Header>::value, "Binned file header must have a fixed layout");
+
+    /**
+         * Layout of a file with given dimensions and bin thresholds
+         *
+         * @param rows Number of rows
+         * @param thresholds Bin thresholds per feature
+         */
+    static Header layout(uint64_t rows, const std::vector<Vector> &thresholds)
+    {
+        Header header;
+        std::memset(&header, 0, sizeof(Header));
+        std::memcpy(header.magic, "MGBTBINS", sizeof(header.magic));
+        header.version = Version;
+        header.byteOrder = ByteOrderMark;
+        header.rows = rows;
+        header.cols = thresholds.size();
+
+        uint64_t numThresholds = 0;
+        for (const Vector &featureThresholds : thresholds)
+        {
+            numThresholds += featureThresholds.size();
+        }
+
+        header.thresholdOffsetsOffset = alignUp(sizeof(Header), 64);
+        header.thresholdsOffset = alignUp(header.thresholdOffsetsOffset + (header.cols + 1) * sizeof(uint64_t), 64);
+        header.targetsOffset = alignUp(header.thresholdsOffset + numThresholds * sizeof(double), 64);
+        header.codesOffset = alignUp(header.targetsOffset + rows * sizeof(double), ColumnAlignment);
+        header.columnStride = alignUp(rows, ColumnAlignment);
+        header.fileSize = header.codesOffset + header.cols * header.columnStride;
+        return header;
+    }
+
+    /**
+         * Map a binned file in memory
+         *
+         * @param path File path
+         * @throws std::runtime_error if the file cannot be mapped or is not a valid binned file of this version
+         */
+    explicit BinnedFile(const std::string &path) : _file(std::make_shared<MappedFile>(path))
+    {
+        Header header;
+        if (_file->size() < sizeof(Header))
+        {
+            throw std::runtime_error("Invalid microgbt binned file: truncated header");
+        }
+        std::memcpy(&header, _file->data(), sizeof(Header));
+
+        if (std::memcmp(header.magic, "MGBTBINS", sizeof(header.magic)) != 0)
+        {
+            throw std::runtime_error("Invalid microgbt binned file: bad magic number");
+        }
+        if (header.byteOrder != ByteOrderMark)
+        {
+            throw std::runtime_error("Invalid microgbt binned file: written on a machine with different byte order");
+        }
+        if (header.version != Version)
+        {
+            throw std::runtime_error("Unsupported microgbt binned file version " + std::to_string(header.version));
+        }
+        uint64_t fileSize = header.fileSize;
+        if (fileSize > _file->size() || header.cols == std::numeric_limits<uint64_t>::max() ||
+            !fits(header.thresholdOffsetsOffset, header.cols + 1, sizeof(uint64_t), fileSize) ||
+            !fits(header.targetsOffset, header.rows, sizeof(double), fileSize) ||
+            !fits(header.codesOffset, header.cols, header.columnStride, fileSize) ||
+            header.columnStride < header.rows || header.codesOffset % ColumnAlignment != 0 ||
+            header.thresholdOffsetsOffset % sizeof(uint64_t) != 0 || header.thresholdsOffset % sizeof(double) != 0 ||
+            header.targetsOffset % sizeof(double) != 0)
+        {
+            throw std::runtime_error("Invalid microgbt binned file: corrupted layout");
+        }
+
+        // Thresholds of the features are consecutive ranges of the thresholds array, which lies within the file
+        const uint8_t *data = _file->data();
+        const uint64_t *thresholdOffsets = reinterpret_cast<const uint64_t *>(data + header.thresholdOffsetsOffset);
+        const double *allThresholds = reinterpret_cast<const double *>(data + header.thresholdsOffset);
+        std::vector<Vector> thresholds(header.cols);
+        for (uint64_t j = 0; j < header.cols; j++)
+        {
+            if (thresholdOffsets[j + 1] < thresholdOffsets[j] ||
+                !fits(header.thresholdsOffset, thresholdOffsets[j + 1], sizeof(double), fileSize))
+            {
+                throw std::runtime_error("Invalid microgbt binned file: corrupted threshold offsets");
+            }
+            if (thresholdOffsets[j + 1] - thresholdOffsets[j] >= static_cast<uint64_t>(BinnedMatrix::MaxBins))
+            {
+                throw std::runtime_error("Invalid microgbt binned file: too many bins");
+            }
+            thresholds[j].assign(allThresholds + thresholdOffsets[j], allThresholds + thresholdOffsets[j + 1]);
+        }
+
+        _targets = reinterpret_cast<const double *>(data + header.targetsOffset);
+        _bins = std::make_shared<const BinnedMatrix>(BinnedMatrix::mappedView(
+            data + header.codesOffset, static_cast<long>(header.rows), header.columnStride, std::move(thresholds),
+            _file));
+    }
+
+    inline long rows() const { return _bins->rows(); }
+
+    inline long numFeatures() const { return _bins->numFeatures(); }
+
+    /**
+         * Bins of the file, a view of its mapping
+         */
+    inline const std::shared_ptr<const BinnedMatrix> &bins() const { return _bins; }
+
+    /**
+         * Targets of the file, a view of its mapping that remains valid as long as bins() is referenced
+         */
+    inline const double *targets() const { return _targets; }
+
+    /**
+         * Owner of the mapping, e.g., to keep targets() valid
+         */
+    inline std::shared_ptr<const void> owner() const { return _file; }
+};
+
+/**
+     * Writer of a BinnedFile, where rows are appended in chunks
+     *
+     * The bin thresholds are fixed in advance, e.g., fitted to a sample of the rows that fits in memory, see
+     * fitThresholds.
+     */
+class BinnedFileWriter
+{
+
+    int _fd = -1;
+    std::string _path;
+    BinnedFile::Header _header;
+    std::vector<Vector> _thresholds;
+    uint64_t _rowsWritten = 0;
+
+    void writeAt(const void *data, size_t size, uint64_t offset)
+    {
+        const char *bytes = static_cast<const char *>(data);
+        while (size > 0)
+        {
+            ssize_t written = ::pwrite(_fd, bytes, size, static_cast<off_t>(offset));
+            if (written <= 0)
+            {
+                throw std::runtime_error("Cannot write file " + _path);
+            }
+            bytes += written;
+            size -= static_cast<size_t>(written);
+            offset += static_cast<uint64_t>(written);
+        }
+    }
+
+public:
+    /**
+         * Create a binned file of a given number of rows, with fixed bin thresholds
+         *
+         * @param path File path
+         * @param rows Total number of rows
+         * @param thresholds Bin thresholds per feature, at most BinnedMatrix::MaxBins - 1 per feature
+         * @throws std::runtime_error if the file cannot be created
+         */
+    BinnedFileWriter(const std::string &path, uint64_t rows, std::vector<Vector> thresholds)
+        : _path(path), _header(BinnedFile::layout(rows, thresholds)), _thresholds(std::move(thresholds))
+    {
+        for (const Vector &featureThresholds : _thresholds)
+        {
+            if (featureThresholds.size() >= static_cast<size_t>(BinnedMatrix::MaxBins))
+            {
+                throw std::invalid_argument("At most " + std::to_string(BinnedMatrix::MaxBins) + " bins per feature");
+            }
+        }
+
+        _fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (_fd < 0)
+        {
+            throw std::runtime_error("Cannot create file " + path);
+        }
+        if (::ftruncate(_fd, static_cast<off_t>(_header.fileSize)) != 0)
+        {
+            ::close(_fd);
+            throw std::runtime_error("Cannot resize file " + path);
+        }
+
+        std::vector<uint64_t> thresholdOffsets(_thresholds.size() + 1, 0);
+        for (size_t j = 0; j < _thresholds.size(); j++)
+        {
+            thresholdOffsets[j + 1] = thresholdOffsets[j] + _thresholds[j].size();
+            writeAt(_thresholds[j].data(), _thresholds[j].size() * sizeof(double),
+                    _header.thresholdsOffset + thresholdOffsets[j] * sizeof(double));
+        }
+        writeAt(thresholdOffsets.data(), thresholdOffsets.size() * sizeof(uint64_t), _header.thresholdOffsetsOffset);
+    }
+
+    BinnedFileWriter(const BinnedFileWriter &) = delete;
+    BinnedFileWriter &operator=(const BinnedFileWriter &) = delete;
+
+    ~BinnedFileWriter()
+    {
+        if (_fd >= 0)
+        {
+            ::close(_fd);
+        }
+    }
+
+    /**
+         * Bin and append a chunk of rows
+         *
+         * @param X Design matrix of the chunk
+         * @param y Targets of the chunk, X.rows() values
+         * @throws std::invalid_argument if the chunk does not fit in the file
+         */
+    void append(const ColMajorMatrixRef &X, const double *y)
+    {
+        if (static_cast<uint64_t>(X.cols()) != _header.cols || _rowsWritten + X.rows() > _header.rows)
+        {
+            throw std::invalid_argument("Chunk does not match the dimensions of the binned file");
+        }
+
+        std::vector<uint8_t> codes(static_cast<size_t>(X.rows()));
+        for (long j = 0; j < X.cols(); j++)
+        {
+            for (long i = 0; i < X.rows(); i++)
+            {
+                codes[i] = BinnedMatrix::code(_thresholds[j], X(i, j));
+            }
+            writeAt(codes.data(), codes.size(), _header.codesOffset + j * _header.columnStride + _rowsWritten);
+        }
+        writeAt(y, static_cast<size_t>(X.rows()) * sizeof(double), _header.targetsOffset + _rowsWritten * sizeof(double));
+
+        _rowsWritten += static_cast<uint64_t>(X.rows());
+    }
+
+    /**
+         * Write the header, after all rows are appended, and close the file
+         *
+         * @throws std::runtime_error if some rows are missing
+         */
+    void close()
+    {
+        if (_rowsWritten != _header.rows)
+        {
+            throw std::runtime_error("Binned file " + _path + " is incomplete");
+        }
+
+        writeAt(&_header, sizeof(BinnedFile::Header), 0);
+        if (::close(_fd) != 0)
+        {
+            _fd = -1;
+            throw std::runtime_error("Cannot close file " + _path);
+        }
+        _fd = -1;
+    }
+
+    /**
+         * Fit the bin thresholds of every feature to a design matrix, e.g., a sample of the rows of a binned file
+         *
+         * @param X Design matrix
+         * @param maxBin Maximum number of bins per feature
+         * @return Bin thresholds per feature
+         */
+    static std::vector<Vector> fitThresholds(const ColMajorMatrixRef &X, int maxBin)
+    {
+        BinnedMatrix bins(X, maxBin);
+        std::vector<Vector> thresholds(static_cast<size_t>(X.cols()));
+        for (long j = 0; j < X.cols(); j++)
+        {
+            thresholds[j] = bins.thresholds(j);
+        }
+        return thresholds;
+    }
+
+    /**
+         * Write a design matrix (and targets) that fits in memory to a binned file, with at most maxBin bins per
+         * feature
+         *
+         * @param path File path
+         * @param X Design matrix
+         * @param y Targets, X.rows() values
+         * @param maxBin Maximum number of bins per feature
+         */
+    static void write(const std::string &path, const ColMajorMatrixRef &X, const double *y, int maxBin)
+    {
+        BinnedFileWriter writer(path, static_cast<uint64_t>(X.rows()), fitThresholds(X, maxBin));
+        writer.append(X, y);
+        writer.close();
+    }
+};
+} // namespace microgbt
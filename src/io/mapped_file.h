@@ -0,0 +1,80 @@
+#pragma once
+#include <string>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace microgbt
+{
+
+/**
+     * A read-only, shared memory mapping of a whole file.
+     *
+     * Pages are backed by the page cache, hence all processes of a host that map the same file share a single
+     * physical copy of it.
+     */
+class MappedFile
+{
+
+    const uint8_t *_data = nullptr;
+    size_t _size = 0;
+
+public:
+    /**
+         * Map a file in memory
+         *
+         * @param path File path
+         * @throws std::runtime_error if the file cannot be opened or mapped
+         */
+    explicit MappedFile(const std::string &path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Cannot open file " + path);
+        }
+
+        struct stat status;
+        if (::fstat(fd, &status) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("Cannot stat file " + path);
+        }
+
+        _size = static_cast<size_t>(status.st_size);
+        if (_size > 0)
+        {
+            void *data = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+            if (data == MAP_FAILED)
+            {
+                ::close(fd);
+                throw std::runtime_error("Cannot map file " + path);
+            }
+            _data = static_cast<const uint8_t *>(data);
+        }
+
+        // The mapping remains valid after the file descriptor is closed
+        ::close(fd);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile()
+    {
+        if (_data != nullptr)
+        {
+            ::munmap(const_cast<uint8_t *>(_data), _size);
+        }
+    }
+
+    inline const uint8_t *data() const { return _data; }
+
+    inline size_t size() const { return _size; }
+};
+} // namespace microgbt
@@ -0,0 +1,293 @@
+#pragma once
+#include <string>
+#include <cstring>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+#include "../trees/flat_forest.h"
+
+namespace microgbt
+{
+
+/**
+     * Binary model format of microgbt.
+     *
+     * A model file consists of a fixed-size header followed by the arrays of the flat node table (see FlatForest),
+     * each one starting at a 64-byte aligned offset:
+     *
+     *      [Header][tree offsets][feature indices][thresholds][right children][leaf values][categories]
+     *      [categorical features]
+     *
+     * Values are stored in the native byte order, which is recorded in the header. Since the arrays are aligned,
+     * a model is used in place, e.g., directly from a memory-mapped file, without parsing or copying the trees.
+     */
+class ModelFormat
+{
+
+    static constexpr size_t Alignment = 64;
+
+    static inline uint64_t alignUp(uint64_t offset) { return (offset + Alignment - 1) / Alignment * Alignment; }
+
+    /**
+         * Whether an array of count elements of elementSize bytes at offset lies within fileSize bytes; the
+         * arithmetic does not overflow for any header values
+         */
+    static inline bool fits(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t fileSize)
+    {
+        return offset <= fileSize && count <= (fileSize - offset) / elementSize;
+    }
+
+public:
+    // Version 2 negates the right child offset of nodes whose missing values follow the left branch, version 3
+    // appends the sets of categories of categorical split nodes, see FlatForest, and version 4 appends the sampling
+    // and tree growth parameters to the header; models of earlier versions (where every offset is positive, without categorical
+    // splits, trained without sampling and grown depth-wise) are read as well
+    static constexpr uint32_t Version = 4;
+
+    static constexpr uint32_t ByteOrderMark = 0x01020304;
+
+    /**
+         * File header: format information, training parameters and layout of the node table
+         */
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint64_t fileSize;
+
+        // Training parameters, see GBT
+        int32_t metric, maxDepth, treeMethod, maxBin;
+        double lambda, gamma, minSplitGain, learningRate, minTreeSize, shrinkageRate;
+        int64_t bestIteration;
+
+        // Layout of the node table, offsets are relative to the beginning of the file
+        uint64_t numTrees, numNodes;
+        uint64_t treeOffsetsOffset, featureIndexOffset, thresholdOffset, rightChildOffset, leafValueOffset;
+
+        // Version 3: layout of the sets of categories
+        uint64_t numCategoryWords, categoriesOffset;
+
+        // Version 4: sampling and tree growth parameters, see GBT
+        double subsample, colsampleByTree, colsampleByLevel;
+        uint64_t seed;
+        int32_t maxLeaves, goss;
+        double topRate, otherRate;
+
+        // Version 4: indices of the categorical features (int32), see GBT::setCategoricalFeatures
+        uint64_t numCategoricalFeatures, categoricalFeaturesOffset;
+
+        // Version 4: number of features of the training samples
+        uint64_t numFeatures;
+    };
+
+    static_assert(std::is_standard_layout<Header>::value, "Model header must have a fixed layout");
+
+    // Size of the header of models before version 3, and of version 3
+    static constexpr size_t HeaderSizeV2 = offsetof(Header, numCategoryWords);
+    static constexpr size_t HeaderSizeV3 = offsetof(Header, subsample);
+
+    /**
+         * Serialize a model
+         *
+         * @param header Header with the training parameters; format and layout fields are filled in
+         * @param forest Trained trees
+         * @param categoricalFeatures Indices of the categorical features
+         * @return Model bytes
+         */
+    static std::string serialize(Header header, const FlatForest &forest,
+                                 const VectorT &categoricalFeatures = VectorT())
+    {
+        std::memcpy(header.magic, "MICROGBT", sizeof(header.magic));
+        header.version = Version;
+        header.byteOrder = ByteOrderMark;
+        header.numTrees = forest.numTrees();
+        header.numNodes = forest.numNodes();
+        header.numFeatures = forest.numFeatures();
+        header.treeOffsetsOffset = alignUp(sizeof(Header));
+        header.featureIndexOffset = alignUp(header.treeOffsetsOffset + header.numTrees * sizeof(int32_t));
+        header.thresholdOffset = alignUp(header.featureIndexOffset + header.numNodes * sizeof(int32_t));
+        header.rightChildOffset = alignUp(header.thresholdOffset + header.numNodes * sizeof(double));
+        header.leafValueOffset = alignUp(header.rightChildOffset + header.numNodes * sizeof(int32_t));
+        header.numCategoryWords = forest.numCategoryWords();
+        header.categoriesOffset = alignUp(header.leafValueOffset + header.numNodes * sizeof(double));
+        header.numCategoricalFeatures = categoricalFeatures.size();
+        header.categoricalFeaturesOffset = alignUp(header.categoriesOffset + header.numCategoryWords * sizeof(uint32_t));
+        header.fileSize = alignUp(header.categoricalFeaturesOffset + header.numCategoricalFeatures * sizeof(int32_t));
+
+        std::string bytes(header.fileSize, '\0');
+        char *data = &bytes[0];
+        std::memcpy(data, &header, sizeof(Header));
+        std::memcpy(data + header.treeOffsetsOffset, forest.treeOffsets(), header.numTrees * sizeof(int32_t));
+        std::memcpy(data + header.featureIndexOffset, forest.featureIndices(), header.numNodes * sizeof(int32_t));
+        std::memcpy(data + header.thresholdOffset, forest.thresholds(), header.numNodes * sizeof(double));
+        std::memcpy(data + header.rightChildOffset, forest.rightChildren(), header.numNodes * sizeof(int32_t));
+        std::memcpy(data + header.leafValueOffset, forest.leafValues(), header.numNodes * sizeof(double));
+        std::memcpy(data + header.categoriesOffset, forest.categoryWords(),
+                    header.numCategoryWords * sizeof(uint32_t));
+        for (size_t k = 0; k < categoricalFeatures.size(); k++)
+        {
+            int32_t featureId = static_cast<int32_t>(categoricalFeatures[k]);
+            std::memcpy(data + header.categoricalFeaturesOffset + k * sizeof(int32_t), &featureId, sizeof(int32_t));
+        }
+
+        return bytes;
+    }
+
+    /**
+         * Validate and return the header of a serialized model
+         *
+         * @param data Model bytes, aligned to at least 8 bytes
+         * @param size Number of bytes
+         * @throws std::runtime_error if the bytes are not a valid model of this version
+         * @return Header; the fields of versions after the one of the model are unspecified
+         */
+    static Header readHeader(const uint8_t *data, size_t size)
+    {
+        Header header;
+        if (size < HeaderSizeV2)
+        {
+            throw std::runtime_error("Invalid microgbt model: truncated header");
+        }
+        std::memcpy(&header, data, HeaderSizeV2);
+        header.numCategoryWords = 0;
+        header.categoriesOffset = 0;
+        header.numCategoricalFeatures = 0;
+        header.categoricalFeaturesOffset = 0;
+        header.numFeatures = 0;
+
+        if (std::memcmp(header.magic, "MICROGBT", sizeof(header.magic)) != 0)
+        {
+            throw std::runtime_error("Invalid microgbt model: bad magic number");
+        }
+        if (header.byteOrder != ByteOrderMark)
+        {
+            throw std::runtime_error("Invalid microgbt model: written on a machine with different byte order");
+        }
+        if (header.version < 1 || header.version > Version)
+        {
+            throw std::runtime_error("Unsupported microgbt model version " + std::to_string(header.version));
+        }
+        if (header.version >= 3)
+        {
+            size_t headerSize = (header.version >= 4) ? sizeof(Header) : HeaderSizeV3;
+            if (size < headerSize)
+            {
+                throw std::runtime_error("Invalid microgbt model: truncated header");
+            }
+            std::memcpy(&header, data, headerSize);
+        }
+        uint64_t fileSize = header.fileSize;
+        if (fileSize > size ||
+            !fits(header.treeOffsetsOffset, header.numTrees, sizeof(int32_t), fileSize) ||
+            !fits(header.featureIndexOffset, header.numNodes, sizeof(int32_t), fileSize) ||
+            !fits(header.thresholdOffset, header.numNodes, sizeof(double), fileSize) ||
+            !fits(header.rightChildOffset, header.numNodes, sizeof(int32_t), fileSize) ||
+            !fits(header.leafValueOffset, header.numNodes, sizeof(double), fileSize) ||
+            !fits(header.categoriesOffset, header.numCategoryWords, sizeof(uint32_t), fileSize) ||
+            !fits(header.categoricalFeaturesOffset, header.numCategoricalFeatures, sizeof(int32_t), fileSize) ||
+            header.treeOffsetsOffset % Alignment != 0 || header.featureIndexOffset % Alignment != 0 ||
+            header.thresholdOffset % Alignment != 0 || header.rightChildOffset % Alignment != 0 ||
+            header.leafValueOffset % Alignment != 0 || header.categoriesOffset % Alignment != 0 ||
+            header.categoricalFeaturesOffset % Alignment != 0)
+        {
+            throw std::runtime_error("Invalid microgbt model: corrupted layout");
+        }
+
+        return header;
+    }
+
+    /**
+         * Validate the node table of a serialized model, so that scoring its trees stays within its arrays: tree
+         * offsets and children are nodes of the table (children follow their parent), split features are features
+         * of the training samples (if the model records them), and sets of categories lie within their pool
+         *
+         * @param data Model bytes (aligned to at least 8 bytes) with a header validated by readHeader
+         * @param header Model header
+         * @throws std::runtime_error if the node table is corrupted
+         */
+    static void validateNodes(const uint8_t *data, const Header &header)
+    {
+        FlatForest forest = forestView(data, header, nullptr);
+        for (size_t t = 0; t < forest.numTrees(); t++)
+        {
+            int32_t offset = forest.treeOffsets()[t];
+            if (offset < 0 || static_cast<uint64_t>(offset) >= header.numNodes)
+            {
+                throw std::runtime_error("Invalid microgbt model: tree offset out of range");
+            }
+        }
+
+        for (size_t node = 0; node < forest.numNodes(); node++)
+        {
+            if (forest.isLeaf(node))
+            {
+                continue;
+            }
+
+            int32_t offset = forest.rightChildren()[node];
+            if (offset == std::numeric_limits<int32_t>::min() || std::abs(offset) < 2 ||
+                static_cast<uint64_t>(std::abs(offset)) >= header.numNodes - node)
+            {
+                throw std::runtime_error("Invalid microgbt model: right child out of range");
+            }
+            if (header.numFeatures > 0 && static_cast<uint64_t>(forest.featureIndex(node)) >= header.numFeatures)
+            {
+                throw std::runtime_error("Invalid microgbt model: feature index out of range");
+            }
+            if (forest.isCategorical(node))
+            {
+                double position = forest.threshold(node);
+                if (!(position >= 0.0) || position != std::floor(position) ||
+                    position >= static_cast<double>(header.numCategoryWords) ||
+                    forest.numCategoryWords(node) >= header.numCategoryWords - static_cast<uint64_t>(position))
+                {
+                    throw std::runtime_error("Invalid microgbt model: set of categories out of range");
+                }
+            }
+        }
+    }
+
+    /**
+         * Return the indices of the categorical features of a serialized model
+         *
+         * @param data Model bytes with a header validated by readHeader
+         * @param header Model header
+         */
+    static VectorT categoricalFeatures(const uint8_t *data, const Header &header)
+    {
+        VectorT features(header.numCategoricalFeatures);
+        for (size_t k = 0; k < features.size(); k++)
+        {
+            int32_t featureId;
+            std::memcpy(&featureId, data + header.categoricalFeaturesOffset + k * sizeof(int32_t), sizeof(int32_t));
+            features[k] = static_cast<size_t>(featureId);
+        }
+        return features;
+    }
+
+    /**
+         * Return the trees of a serialized model as a view of its bytes, i.e., without copying them
+         *
+         * @param data Model bytes (aligned to at least 8 bytes) with a header validated by readHeader
+         * @param header Model header
+         * @param buffer Owner of the bytes, kept alive by the returned forest
+         */
+    static FlatForest forestView(const uint8_t *data, const Header &header, std::shared_ptr<const void> buffer)
+    {
+        return FlatForest::view(reinterpret_cast<const int32_t *>(data + header.treeOffsetsOffset), header.numTrees,
+                                reinterpret_cast<const int32_t *>(data + header.featureIndexOffset),
+                                reinterpret_cast<const double *>(data + header.thresholdOffset),
+                                reinterpret_cast<const int32_t *>(data + header.rightChildOffset),
+                                reinterpret_cast<const double *>(data + header.leafValueOffset), header.numNodes,
+                                reinterpret_cast<const uint32_t *>(data + header.categoriesOffset),
+                                header.numCategoryWords, header.numFeatures, std::move(buffer));
+    }
+};
+} // namespace microgbt
@@ -0,0 +1,691 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <limits>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+
+#include "../types.h"
+#include "../dataset.h"
+#include "../utils/thread_pool.h"
+#include "mapped_file.h"
+
+namespace microgbt
+{
+
+/**
+     * Text formats read by TextLoader
+     *
+     * CSV: delimiter-separated values (comma, tab, ...), one sample per line
+     * LibSVM: "label index:value index:value ...", one sample per line; absent features are zero
+     */
+enum class TextFormat
+{
+    CSV,
+    LibSVM
+};
+
+/**
+     * Design matrix and target vector read from a text file
+     */
+struct TextData
+{
+    MatrixType X;
+    Eigen::VectorXd y;
+};
+
+/**
+     * Native loader of CSV and LibSVM files.
+     *
+     * The file is memory-mapped and split into chunks of lines, which are parsed in parallel in two passes: the
+     * first one counts the rows of every chunk (and, for LibSVM, finds the largest feature index), the second one
+     * parses every chunk directly into its rows of the column-major design matrix. Hence the file is neither copied
+     * nor parsed into intermediate rows.
+     *
+     * Empty fields and the tokens NA, NaN, null and ? (case-insensitive) are missing values (NaN). Fields may be
+     * enclosed in double quotes, e.g., text columns that are not selected, but quoted fields must not span lines.
+     */
+class TextLoader
+{
+
+public:
+    struct Options
+    {
+        TextFormat format = TextFormat::CSV;
+
+        // CSV field delimiter; if 0, it is detected from the first line (tab, comma, semicolon or whitespace).
+        // A space delimiter separates fields by runs of whitespace
+        char delimiter = 0;
+
+        // CSV only: whether the first line is a header, which is skipped
+        bool header = false;
+
+        // CSV only: column of the target; if negative, there is no target column and all targets are zero
+        long labelColumn = 0;
+
+        // Columns (CSV) or feature indices (LibSVM) of the features, in order; if empty, all columns except the
+        // label column (CSV) or all feature indices (LibSVM)
+        std::vector<long> columns;
+
+        // LibSVM only: number of feature indices; if 0, one plus the largest index of the file. Indices are
+        // one-based unless zeroBased is set
+        long numFeatures = 0;
+        bool zeroBased = false;
+
+        // Number of parsing threads; if non-positive, the number of hardware threads is used
+        int numThreads = 0;
+    };
+
+private:
+    // Lines [begin, end) of the file, their first row in the design matrix and the parsing results
+    struct Chunk
+    {
+        const char *begin, *end;
+        long numRows = 0, firstRow = 0, maxIndex = -1;
+        std::string error;
+    };
+
+    /**
+         * Reader of the fields of a line, separated by a delimiter (or by runs of whitespace if it is a space)
+         */
+    class FieldReader
+    {
+        const char *_pos, *_end;
+        char _delimiter;
+        bool _done = false;
+
+    public:
+        FieldReader(const char *begin, const char *end, char delimiter)
+            : _pos(begin), _end(end), _delimiter(delimiter) {}
+
+        /**
+             * Next field of the line, if any
+             *
+             * @param fieldBegin Output: start of the field
+             * @param fieldEnd Output: end of the field
+             */
+        inline bool next(const char *&fieldBegin, const char *&fieldEnd)
+        {
+            bool whitespace = (_delimiter == ' ');
+            while (whitespace && _pos < _end && isSpace(*_pos))
+            {
+                _pos++;
+            }
+            if (_done || (whitespace && _pos == _end))
+            {
+                return false;
+            }
+
+            bool quoted = false;
+            const char *p = _pos;
+            for (; p < _end && (quoted || !(whitespace ? isSpace(*p) : *p == _delimiter)); p++)
+            {
+                quoted = (*p == '"') ? !quoted : quoted;
+            }
+
+            fieldBegin = _pos;
+            fieldEnd = p;
+            // A delimiter at the end of the line is followed by an empty field
+            _done = (p == _end);
+            _pos = _done ? _end : p + 1;
+            return true;
+        }
+    };
+
+    static inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    static bool equalsIgnoreCase(const char *begin, const char *end, const char *token)
+    {
+        if (static_cast<size_t>(end - begin) != std::strlen(token))
+        {
+            return false;
+        }
+        for (; begin < end; begin++, token++)
+        {
+            char c = (*begin >= 'A' && *begin <= 'Z') ? static_cast<char>(*begin - 'A' + 'a') : *begin;
+            if (c != *token)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+         * End of the line starting at begin, i.e., position of its line break (or end)
+         */
+    static inline const char *lineEnd(const char *begin, const char *end)
+    {
+        const char *newline = static_cast<const char *>(std::memchr(begin, '\n', static_cast<size_t>(end - begin)));
+        return newline ? newline : end;
+    }
+
+    /**
+         * Whether a line holds no data, i.e., it is empty or whitespace only
+         */
+    static inline bool isBlank(const char *begin, const char *end)
+    {
+        while (begin < end && isSpace(*begin))
+        {
+            begin++;
+        }
+        return begin == end;
+    }
+
+    /**
+         * First non-blank line in [begin, end); lineBegin == end if there is none
+         */
+    static void firstLine(const char *begin, const char *end, const char *&lineBegin, const char *&lineStop)
+    {
+        for (lineBegin = begin; lineBegin < end; lineBegin = lineStop + 1)
+        {
+            lineStop = lineEnd(lineBegin, end);
+            if (!isBlank(lineBegin, lineStop))
+            {
+                return;
+            }
+        }
+        lineBegin = lineStop = end;
+    }
+
+    /**
+         * Split the bytes [begin, end) into at most numChunks chunks of whole lines
+         */
+    static std::vector<Chunk> splitLines(const char *begin, const char *end, size_t numChunks)
+    {
+        std::vector<Chunk> chunks;
+        size_t size = static_cast<size_t>(end - begin);
+        const char *chunkBegin = begin;
+        for (size_t k = 1; k <= numChunks && chunkBegin < end; k++)
+        {
+            const char *chunkEnd = std::max(chunkBegin, begin + size / numChunks * k);
+            chunkEnd = (k == numChunks) ? end : lineEnd(chunkEnd, end);
+            chunkEnd += (chunkEnd < end) ? 1 : 0;
+
+            Chunk chunk;
+            chunk.begin = chunkBegin;
+            chunk.end = chunkEnd;
+            chunks.push_back(chunk);
+            chunkBegin = chunkEnd;
+        }
+        return chunks;
+    }
+
+    /**
+         * Run a pass over all chunks in parallel, then assign the rows of the design matrix to the chunks
+         *
+         * @return Total number of rows
+         * @throws std::runtime_error with the message of the first chunk that failed
+         */
+    static long runPass(std::vector<Chunk> &chunks, ThreadPool &threadPool,
+                        const std::function<void(Chunk &)> &parseChunk)
+    {
+        threadPool.parallelFor(chunks.size(), [&](size_t k) {
+            try
+            {
+                parseChunk(chunks[k]);
+            }
+            catch (const std::exception &e)
+            {
+                chunks[k].error = e.what();
+            }
+        });
+
+        long numRows = 0;
+        for (Chunk &chunk : chunks)
+        {
+            if (!chunk.error.empty())
+            {
+                throw std::runtime_error(chunk.error);
+            }
+            chunk.firstRow = numRows;
+            numRows += chunk.numRows;
+        }
+        return numRows;
+    }
+
+    static inline void countRows(Chunk &chunk)
+    {
+        chunk.numRows = 0;
+        for (const char *line = chunk.begin; line < chunk.end;)
+        {
+            const char *end = lineEnd(line, chunk.end);
+            chunk.numRows += isBlank(line, end) ? 0 : 1;
+            line = end + 1;
+        }
+    }
+
+    static inline std::string parseError(const Chunk &chunk, long row, const std::string &message)
+    {
+        return "Cannot parse data row " + std::to_string(chunk.firstRow + row + 1) + ": " + message;
+    }
+
+    /**
+         * Parse a LibSVM feature index, i.e., the part of an "index:value" token before the colon
+         */
+    static bool parseIndex(const char *begin, const char *end, long &index)
+    {
+        index = 0;
+        for (const char *p = begin; p < end; p++)
+        {
+            if (*p < '0' || *p > '9' || index > std::numeric_limits<long>::max() / 10 - 1)
+            {
+                return false;
+            }
+            index = index * 10 + (*p - '0');
+        }
+        return begin < end;
+    }
+
+    static inline void parseDigits(const char *&p, const char *end, uint64_t &mantissa, int &numDigits,
+                                   int &exponent, bool fraction)
+    {
+        for (; p < end && *p >= '0' && *p <= '9'; p++)
+        {
+            if (numDigits < 19)
+            {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                numDigits += (mantissa > 0) ? 1 : 0;
+                exponent -= fraction ? 1 : 0;
+            }
+            else
+            {
+                // Digits beyond the precision of the mantissa only scale it
+                numDigits++;
+                exponent += fraction ? 0 : 1;
+            }
+        }
+    }
+
+public:
+    /**
+         * Parse a numeric field
+         *
+         * Numbers of at most 15 significant digits with a decimal exponent of at most 22 (the common case) are
+         * converted without strtod, by a single correctly rounded multiplication or division of exact doubles;
+         * other numbers (and inf) fall back to strtod.
+         *
+         * @param begin Start of the field
+         * @param end End of the field
+         * @param value Output: value of the field; NaN for missing values
+         * @return false if the field is neither a number nor a missing value
+         */
+    static bool parseValue(const char *begin, const char *end, double &value)
+    {
+        static const double powersOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                             1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+        while (begin < end && isSpace(*begin))
+        {
+            begin++;
+        }
+        while (end > begin && isSpace(end[-1]))
+        {
+            end--;
+        }
+        if (end - begin >= 2 && *begin == '"' && end[-1] == '"')
+        {
+            begin++;
+            end--;
+        }
+
+        if (begin == end || equalsIgnoreCase(begin, end, "na") || equalsIgnoreCase(begin, end, "nan") ||
+            equalsIgnoreCase(begin, end, "null") || equalsIgnoreCase(begin, end, "?"))
+        {
+            value = std::numeric_limits<double>::quiet_NaN();
+            return true;
+        }
+
+        const char *p = begin;
+        bool negative = (*p == '-');
+        p += (*p == '-' || *p == '+') ? 1 : 0;
+
+        uint64_t mantissa = 0;
+        int numDigits = 0, exponent = 0;
+        const char *digits = p;
+        parseDigits(p, end, mantissa, numDigits, exponent, false);
+        bool hasDigits = (p > digits);
+        if (p < end && *p == '.')
+        {
+            digits = ++p;
+            parseDigits(p, end, mantissa, numDigits, exponent, true);
+            hasDigits = hasDigits || (p > digits);
+        }
+        if (hasDigits && p < end && (*p == 'e' || *p == 'E'))
+        {
+            p++;
+            bool negativeExponent = (p < end && *p == '-');
+            p += (p < end && (*p == '-' || *p == '+')) ? 1 : 0;
+            int decimalExponent = 0;
+            for (digits = p; p < end && *p >= '0' && *p <= '9'; p++)
+            {
+                decimalExponent = std::min(decimalExponent * 10 + (*p - '0'), 100000);
+            }
+            hasDigits = (p > digits);
+            exponent += negativeExponent ? -decimalExponent : decimalExponent;
+        }
+
+        if (hasDigits && p == end && numDigits <= 15 && exponent >= -22 && exponent <= 22)
+        {
+            double magnitude = static_cast<double>(mantissa);
+            magnitude = (exponent < 0) ? magnitude / powersOfTen[-exponent] : magnitude * powersOfTen[exponent];
+            value = negative ? -magnitude : magnitude;
+            return true;
+        }
+
+        std::string field(begin, end);
+        char *parsedEnd = nullptr;
+        value = std::strtod(field.c_str(), &parsedEnd);
+        return parsedEnd == field.c_str() + field.size();
+    }
+
+    /**
+         * Load a CSV or LibSVM file
+         *
+         * @param path File path
+         * @param options Format and parsing options
+         * @throws std::runtime_error if the file cannot be read or parsed
+         * @throws std::invalid_argument if the options do not match the file, e.g., a column is out of range
+         */
+    static TextData load(const std::string &path, const Options &options)
+    {
+        MappedFile file(path);
+        const char *begin = reinterpret_cast<const char *>(file.data()), *end = begin + file.size();
+
+        // Several chunks per thread balance the load of chunks with different parsing costs; chunks of at least
+        // 64 KiB keep small files from being split needlessly
+        ThreadPool threadPool(options.numThreads);
+        size_t numChunks = std::min(static_cast<size_t>(threadPool.numThreads()) * 8, file.size() / (1 << 16) + 1);
+
+        return (options.format == TextFormat::LibSVM) ? loadLibSVM(begin, end, options, numChunks, threadPool)
+                                                      : loadCSV(begin, end, options, numChunks, threadPool);
+    }
+
+    /**
+         * Dataset of loaded data
+         *
+         * A double dataset views the loaded matrix without copying it, and keeps the data alive; other storage
+         * types convert a copy, see BasicDataset.
+         *
+         * @param data Loaded data
+         * @param scale Scale table of the storage type, e.g., the one of a training dataset; if nullptr, it is
+         *              fitted to the data
+         */
+    template <typename Feature>
+    static BasicDataset<Feature> dataset(std::shared_ptr<const TextData> data,
+                                         std::shared_ptr<const FeatureScale<Feature>> scale = nullptr)
+    {
+        return dataset(std::move(data), std::move(scale), std::is_same<Feature, double>());
+    }
+
+    /**
+         * Load a CSV or LibSVM file as a dataset, see load and dataset
+         */
+    template <typename Feature>
+    static BasicDataset<Feature> loadDataset(const std::string &path, const Options &options,
+                                             std::shared_ptr<const FeatureScale<Feature>> scale = nullptr)
+    {
+        return dataset<Feature>(std::make_shared<const TextData>(load(path, options)), std::move(scale));
+    }
+
+private:
+    static BasicDataset<double> dataset(std::shared_ptr<const TextData> data,
+                                        std::shared_ptr<const FeatureScale<double>> scale, std::true_type)
+    {
+        const MatrixType &X = data->X;
+        const double *y = data->y.data();
+        return BasicDataset<double>(MatrixView(X.data(), X.rows(), X.cols(), Eigen::OuterStride<>(X.rows())), y,
+                                    std::move(data), std::move(scale));
+    }
+
+    template <typename Feature>
+    static BasicDataset<Feature> dataset(std::shared_ptr<const TextData> data,
+                                         std::shared_ptr<const FeatureScale<Feature>> scale, std::false_type)
+    {
+        return BasicDataset<Feature>(data->X, Vector(data->y.data(), data->y.data() + data->y.size()),
+                                     std::move(scale));
+    }
+
+    static TextData loadCSV(const char *begin, const char *end, const Options &options, size_t numChunks,
+                            ThreadPool &threadPool)
+    {
+        // The first line (header or data) determines the delimiter and the number of columns
+        const char *lineBegin, *lineStop;
+        firstLine(begin, end, lineBegin, lineStop);
+        if (lineBegin == end)
+        {
+            throw std::runtime_error("Cannot parse CSV file: no data");
+        }
+
+        char delimiter = options.delimiter;
+        if (delimiter == 0)
+        {
+            const char *candidates = "\t,;";
+            for (const char *c = candidates; *c != 0 && delimiter == 0; c++)
+            {
+                delimiter = std::memchr(lineBegin, *c, static_cast<size_t>(lineStop - lineBegin)) ? *c : 0;
+            }
+            delimiter = (delimiter == 0) ? ' ' : delimiter;
+        }
+
+        long numColumns = 0;
+        const char *fieldBegin, *fieldEnd;
+        for (FieldReader fields(lineBegin, lineStop, delimiter); fields.next(fieldBegin, fieldEnd);)
+        {
+            numColumns++;
+        }
+
+        const char *dataBegin = options.header ? std::min(end, lineStop + 1) : lineBegin;
+        long labelColumn = options.labelColumn;
+        if (labelColumn >= numColumns)
+        {
+            throw std::invalid_argument("Label column " + std::to_string(labelColumn) + " is out of range; the file has " +
+                                        std::to_string(numColumns) + " columns");
+        }
+
+        // Feature (column of the design matrix) of every column of the file, -1 if not selected
+        std::vector<long> columns = options.columns;
+        if (columns.empty())
+        {
+            for (long c = 0; c < numColumns; c++)
+            {
+                if (c != labelColumn)
+                {
+                    columns.push_back(c);
+                }
+            }
+        }
+        std::vector<long> featureOfColumn(static_cast<size_t>(numColumns), -1);
+        for (size_t j = 0; j < columns.size(); j++)
+        {
+            long c = columns[j];
+            if (c < 0 || c >= numColumns || c == labelColumn || featureOfColumn[c] >= 0)
+            {
+                throw std::invalid_argument("Invalid feature column " + std::to_string(c) +
+                                            ": out of range, label column or duplicate");
+            }
+            featureOfColumn[c] = static_cast<long>(j);
+        }
+
+        std::vector<Chunk> chunks = splitLines(dataBegin, end, numChunks);
+        long numRows = runPass(chunks, threadPool, countRows);
+
+        TextData data;
+        data.X.resize(numRows, static_cast<long>(columns.size()));
+        data.y.setZero(numRows);
+
+        runPass(chunks, threadPool, [&](Chunk &chunk) {
+            long row = 0;
+            const char *rowStop;
+            for (const char *line = chunk.begin; line < chunk.end; line = rowStop + 1)
+            {
+                rowStop = lineEnd(line, chunk.end);
+                if (isBlank(line, rowStop))
+                {
+                    continue;
+                }
+
+                long column = 0, globalRow = chunk.firstRow + row;
+                const char *valueBegin, *valueEnd;
+                for (FieldReader fields(line, rowStop, delimiter); fields.next(valueBegin, valueEnd); column++)
+                {
+                    if (column >= numColumns || (featureOfColumn[column] < 0 && column != labelColumn))
+                    {
+                        continue;
+                    }
+
+                    double value;
+                    if (!parseValue(valueBegin, valueEnd, value))
+                    {
+                        throw std::runtime_error(parseError(chunk, row, "non-numeric value '" +
+                                                                            std::string(valueBegin, valueEnd) +
+                                                                            "' in column " + std::to_string(column)));
+                    }
+                    if (column == labelColumn)
+                    {
+                        data.y[globalRow] = value;
+                    }
+                    else
+                    {
+                        data.X(globalRow, featureOfColumn[column]) = value;
+                    }
+                }
+
+                if (column != numColumns)
+                {
+                    throw std::runtime_error(parseError(chunk, row, std::to_string(column) + " columns instead of " +
+                                                                        std::to_string(numColumns)));
+                }
+                row++;
+            }
+        });
+
+        return data;
+    }
+
+    static TextData loadLibSVM(const char *begin, const char *end, const Options &options, size_t numChunks,
+                               ThreadPool &threadPool)
+    {
+        const long indexBase = options.zeroBased ? 0 : 1;
+
+        // Visit the "index:value" tokens of every row of a chunk; "qid:..." tokens are skipped, and so are invalid
+        // tokens unless they are reported, i.e., once the first row of the chunk is known (see parseError)
+        auto forEachRow = [indexBase](Chunk &chunk, bool reportInvalid,
+                                      const std::function<void(long, const char *, const char *)> &label,
+                                      const std::function<void(long, long, const char *, const char *)> &feature) {
+            long row = 0;
+            const char *lineStop;
+            for (const char *line = chunk.begin; line < chunk.end; line = lineStop + 1)
+            {
+                lineStop = lineEnd(line, chunk.end);
+                if (isBlank(line, lineStop))
+                {
+                    continue;
+                }
+
+                const char *begin = line, *end = line;
+                FieldReader tokens(line, lineStop, ' ');
+                tokens.next(begin, end);
+                label(row, begin, end);
+                while (tokens.next(begin, end))
+                {
+                    const char *colon = static_cast<const char *>(std::memchr(begin, ':', static_cast<size_t>(end - begin)));
+                    long index;
+                    if (colon != nullptr && equalsIgnoreCase(begin, colon, "qid"))
+                    {
+                        continue;
+                    }
+                    if (colon == nullptr || !parseIndex(begin, colon, index) || index < indexBase)
+                    {
+                        if (!reportInvalid)
+                        {
+                            continue;
+                        }
+                        throw std::runtime_error(parseError(chunk, row, "invalid token '" + std::string(begin, end) + "'"));
+                    }
+                    feature(row, index - indexBase, colon + 1, end);
+                }
+                row++;
+            }
+            chunk.numRows = row;
+        };
+
+        // The first pass counts the rows and features; the first rows of the chunks are only known after it, hence
+        // invalid tokens are reported by the second pass
+        std::vector<Chunk> chunks = splitLines(begin, end, numChunks);
+        long numRows = runPass(chunks, threadPool, [&](Chunk &chunk) {
+            forEachRow(chunk, false, [](long, const char *, const char *) {},
+                       [&chunk](long, long index, const char *, const char *) {
+                           chunk.maxIndex = std::max(chunk.maxIndex, index);
+                       });
+        });
+
+        long numFeatures = options.numFeatures;
+        if (numFeatures <= 0)
+        {
+            for (const Chunk &chunk : chunks)
+            {
+                numFeatures = std::max(numFeatures, chunk.maxIndex + 1);
+            }
+        }
+
+        std::vector<long> features = options.columns;
+        if (features.empty())
+        {
+            features.resize(static_cast<size_t>(numFeatures));
+            std::iota(features.begin(), features.end(), 0);
+        }
+        std::vector<long> columnOfFeature(static_cast<size_t>(numFeatures), -1);
+        for (size_t j = 0; j < features.size(); j++)
+        {
+            long f = features[j];
+            if (f < 0 || f >= numFeatures || columnOfFeature[f] >= 0)
+            {
+                throw std::invalid_argument("Invalid feature index " + std::to_string(f) + ": out of range or duplicate");
+            }
+            columnOfFeature[f] = static_cast<long>(j);
+        }
+
+        TextData data;
+        data.X.setZero(numRows, static_cast<long>(features.size()));
+        data.y.setZero(numRows);
+
+        runPass(chunks, threadPool, [&](Chunk &chunk) {
+            auto parse = [&chunk](long row, const char *begin, const char *end) {
+                double value;
+                if (!parseValue(begin, end, value))
+                {
+                    throw std::runtime_error(parseError(chunk, row, "non-numeric value '" + std::string(begin, end) + "'"));
+                }
+                return value;
+            };
+
+            forEachRow(chunk, true,
+                       [&](long row, const char *begin, const char *end) {
+                           data.y[chunk.firstRow + row] = parse(row, begin, end);
+                       },
+                       [&](long row, long index, const char *begin, const char *end) {
+                           if (index >= numFeatures)
+                           {
+                               throw std::runtime_error(parseError(chunk, row, "feature index " +
+                                                                                   std::to_string(index + indexBase) +
+                                                                                   " exceeds the number of features"));
+                           }
+                           if (columnOfFeature[index] >= 0)
+                           {
+                               data.X(chunk.firstRow + row, columnOfFeature[index]) = parse(row, begin, end);
+                           }
+                       });
+        });
+
+        return data;
+    }
+};
+} // namespace microgbt
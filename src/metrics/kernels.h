@@ -0,0 +1,301 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)) && !defined(MICROGBT_NO_SIMD)
+#define MICROGBT_X86_SIMD 1
+// The AVX-512 intrinsics of some GCC versions trigger false positive warnings (GCC bug 105593)
+#if !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#endif
+#include <immintrin.h>
+#if !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+namespace microgbt
+{
+namespace kernels
+{
+
+/**
+     * Instruction sets of the objective kernels. The AVX2 and AVX-512 kernels are compiled with function-level
+     * target attributes and selected at runtime, hence no build flag is required; define MICROGBT_NO_SIMD to
+     * compile the scalar kernels only.
+     *
+     * All kernels evaluate the same floating point operations in the same order (without fused multiply-add), so
+     * that their results are identical.
+     */
+enum class InstructionSet
+{
+    Scalar,
+    AVX2,
+    AVX512
+};
+
+/**
+     * Return the widest instruction set supported by the host CPU
+     */
+inline InstructionSet hostInstructionSet()
+{
+#ifdef MICROGBT_X86_SIMD
+    static const InstructionSet instructionSet =
+        __builtin_cpu_supports("avx512f") ? InstructionSet::AVX512
+                                          : (__builtin_cpu_supports("avx2") ? InstructionSet::AVX2 : InstructionSet::Scalar);
+    return instructionSet;
+#else
+    return InstructionSet::Scalar;
+#endif
+}
+
+namespace detail
+{
+
+// exp(x) = 2^n * exp(r), where n = round(x / ln 2) and exp(r) is a Pade approximation (Cephes)
+constexpr double ExpMin = -708.0, ExpMax = 709.0;
+constexpr double Log2e = 1.4426950408889634073599;
+constexpr double Ln2Hi = 6.93145751953125E-1, Ln2Lo = 1.42860682030941723212E-6;
+constexpr double P0 = 1.26177193074810590878E-4, P1 = 3.02994407707441961300E-2, P2 = 9.99999999999999999910E-1;
+constexpr double Q0 = 3.00198505138664455042E-6, Q1 = 2.52448340349684104192E-3, Q2 = 2.27265548208155028766E-1,
+                 Q3 = 2.00000000000000000009E0;
+
+inline double pow2(double n)
+{
+    int64_t bits = (static_cast<int64_t>(n) + 1023) << 52;
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+inline double exp(double x)
+{
+    x = std::min(std::max(x, ExpMin), ExpMax);
+    double n = std::floor(Log2e * x + 0.5);
+    x = x - n * Ln2Hi;
+    x = x - n * Ln2Lo;
+    double xx = x * x;
+    double px = x * ((P0 * xx + P1) * xx + P2);
+    double qx = ((Q0 * xx + Q1) * xx + Q2) * xx + Q3;
+    return (1.0 + 2.0 * (px / (qx - px))) * pow2(n);
+}
+
+inline double sigmoid(double score, double eps)
+{
+    double value = 1.0 / (1.0 + exp(0.0 - score));
+    return std::min(std::max(value, eps), 1.0 - eps);
+}
+
+#ifdef MICROGBT_X86_SIMD
+
+__attribute__((target("avx2"))) inline __m256d exp4(__m256d x)
+{
+    x = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(ExpMin)), _mm256_set1_pd(ExpMax));
+    __m256d n = _mm256_floor_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(Log2e), x), _mm256_set1_pd(0.5)));
+    x = _mm256_sub_pd(x, _mm256_mul_pd(n, _mm256_set1_pd(Ln2Hi)));
+    x = _mm256_sub_pd(x, _mm256_mul_pd(n, _mm256_set1_pd(Ln2Lo)));
+    __m256d xx = _mm256_mul_pd(x, x);
+
+    __m256d px = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(P0), xx), _mm256_set1_pd(P1));
+    px = _mm256_add_pd(_mm256_mul_pd(px, xx), _mm256_set1_pd(P2));
+    px = _mm256_mul_pd(x, px);
+    __m256d qx = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(Q0), xx), _mm256_set1_pd(Q1));
+    qx = _mm256_add_pd(_mm256_mul_pd(qx, xx), _mm256_set1_pd(Q2));
+    qx = _mm256_add_pd(_mm256_mul_pd(qx, xx), _mm256_set1_pd(Q3));
+    __m256d e = _mm256_add_pd(_mm256_set1_pd(1.0),
+                              _mm256_mul_pd(_mm256_set1_pd(2.0), _mm256_div_pd(px, _mm256_sub_pd(qx, px))));
+
+    __m256i bits = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(n));
+    bits = _mm256_slli_epi64(_mm256_add_epi64(bits, _mm256_set1_epi64x(1023)), 52);
+    return _mm256_mul_pd(e, _mm256_castsi256_pd(bits));
+}
+
+__attribute__((target("avx2"))) inline void logLoss4(const double *scores, const double *targets, double eps,
+                                                     double *gradients, double *hessians)
+{
+    __m256d one = _mm256_set1_pd(1.0);
+    __m256d e = exp4(_mm256_sub_pd(_mm256_setzero_pd(), _mm256_loadu_pd(scores)));
+    __m256d p = _mm256_div_pd(one, _mm256_add_pd(one, e));
+    p = _mm256_min_pd(_mm256_max_pd(p, _mm256_set1_pd(eps)), _mm256_set1_pd(1.0 - eps));
+    _mm256_storeu_pd(gradients, _mm256_sub_pd(p, _mm256_loadu_pd(targets)));
+    _mm256_storeu_pd(hessians, _mm256_mul_pd(p, _mm256_sub_pd(one, p)));
+}
+
+__attribute__((target("avx2"))) inline void logLossAVX2(const double *scores, const double *targets, size_t n,
+                                                        double eps, double *gradients, double *hessians)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        logLoss4(scores + i, targets + i, eps, gradients + i, hessians + i);
+    }
+
+    // The remaining samples are padded, so that every sample is computed by the vector kernel
+    if (i < n)
+    {
+        double s[4] = {0.0, 0.0, 0.0, 0.0}, t[4] = {0.0, 0.0, 0.0, 0.0}, g[4], h[4];
+        std::copy(scores + i, scores + n, s);
+        std::copy(targets + i, targets + n, t);
+        logLoss4(s, t, eps, g, h);
+        std::copy(g, g + (n - i), gradients + i);
+        std::copy(h, h + (n - i), hessians + i);
+    }
+}
+
+__attribute__((target("avx2"))) inline void squaredErrorAVX2(const double *scores, const double *targets, size_t n,
+                                                             double *gradients, double *hessians)
+{
+    __m256d two = _mm256_set1_pd(2.0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d diff = _mm256_sub_pd(_mm256_loadu_pd(scores + i), _mm256_loadu_pd(targets + i));
+        _mm256_storeu_pd(gradients + i, _mm256_mul_pd(two, diff));
+        _mm256_storeu_pd(hessians + i, two);
+    }
+    for (; i < n; i++)
+    {
+        gradients[i] = 2.0 * (scores[i] - targets[i]);
+        hessians[i] = 2.0;
+    }
+}
+
+__attribute__((target("avx512f"))) inline __m512d exp8(__m512d x)
+{
+    x = _mm512_min_pd(_mm512_max_pd(x, _mm512_set1_pd(ExpMin)), _mm512_set1_pd(ExpMax));
+    __m512d n = _mm512_roundscale_pd(_mm512_add_pd(_mm512_mul_pd(_mm512_set1_pd(Log2e), x), _mm512_set1_pd(0.5)),
+                                     _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    x = _mm512_sub_pd(x, _mm512_mul_pd(n, _mm512_set1_pd(Ln2Hi)));
+    x = _mm512_sub_pd(x, _mm512_mul_pd(n, _mm512_set1_pd(Ln2Lo)));
+    __m512d xx = _mm512_mul_pd(x, x);
+
+    __m512d px = _mm512_add_pd(_mm512_mul_pd(_mm512_set1_pd(P0), xx), _mm512_set1_pd(P1));
+    px = _mm512_add_pd(_mm512_mul_pd(px, xx), _mm512_set1_pd(P2));
+    px = _mm512_mul_pd(x, px);
+    __m512d qx = _mm512_add_pd(_mm512_mul_pd(_mm512_set1_pd(Q0), xx), _mm512_set1_pd(Q1));
+    qx = _mm512_add_pd(_mm512_mul_pd(qx, xx), _mm512_set1_pd(Q2));
+    qx = _mm512_add_pd(_mm512_mul_pd(qx, xx), _mm512_set1_pd(Q3));
+    __m512d e = _mm512_add_pd(_mm512_set1_pd(1.0),
+                              _mm512_mul_pd(_mm512_set1_pd(2.0), _mm512_div_pd(px, _mm512_sub_pd(qx, px))));
+
+    __m512i bits = _mm512_cvtepi32_epi64(_mm512_cvtpd_epi32(n));
+    bits = _mm512_slli_epi64(_mm512_add_epi64(bits, _mm512_set1_epi64(1023)), 52);
+    return _mm512_mul_pd(e, _mm512_castsi512_pd(bits));
+}
+
+__attribute__((target("avx512f"))) inline void logLossAVX512(const double *scores, const double *targets, size_t n,
+                                                             double eps, double *gradients, double *hessians)
+{
+    __m512d one = _mm512_set1_pd(1.0), lower = _mm512_set1_pd(eps), upper = _mm512_set1_pd(1.0 - eps);
+    for (size_t i = 0; i < n; i += 8)
+    {
+        // The last block is masked, so that every sample is computed by the vector kernel
+        __mmask8 mask = (n - i >= 8) ? static_cast<__mmask8>(0xFF) : static_cast<__mmask8>((1u << (n - i)) - 1);
+        __m512d e = exp8(_mm512_sub_pd(_mm512_setzero_pd(), _mm512_maskz_loadu_pd(mask, scores + i)));
+        __m512d p = _mm512_div_pd(one, _mm512_add_pd(one, e));
+        p = _mm512_min_pd(_mm512_max_pd(p, lower), upper);
+        _mm512_mask_storeu_pd(gradients + i, mask, _mm512_sub_pd(p, _mm512_maskz_loadu_pd(mask, targets + i)));
+        _mm512_mask_storeu_pd(hessians + i, mask, _mm512_mul_pd(p, _mm512_sub_pd(one, p)));
+    }
+}
+
+__attribute__((target("avx512f"))) inline void squaredErrorAVX512(const double *scores, const double *targets,
+                                                                  size_t n, double *gradients, double *hessians)
+{
+    __m512d two = _mm512_set1_pd(2.0);
+    for (size_t i = 0; i < n; i += 8)
+    {
+        __mmask8 mask = (n - i >= 8) ? static_cast<__mmask8>(0xFF) : static_cast<__mmask8>((1u << (n - i)) - 1);
+        __m512d diff = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, scores + i), _mm512_maskz_loadu_pd(mask, targets + i));
+        _mm512_mask_storeu_pd(gradients + i, mask, _mm512_mul_pd(two, diff));
+        _mm512_mask_storeu_pd(hessians + i, mask, two);
+    }
+}
+
+#endif
+} // namespace detail
+
+/**
+     * Logistic function of a raw score, clipped to [eps, 1 - eps]; identical to the one of the vector kernels
+     *
+     * @param score Raw score
+     * @param eps Clipping tolerance
+     */
+inline double sigmoid(double score, double eps) { return detail::sigmoid(score, eps); }
+
+/**
+     * Gradients p - y and Hessians p (1 - p) of the logistic loss at predictions p = sigmoid(scores)
+     *
+     * @param scores Raw scores, n values
+     * @param targets Binary targets, n values
+     * @param n Number of samples
+     * @param eps Clipping tolerance of predictions
+     * @param gradients Output, n values
+     * @param hessians Output, n values
+     * @param instructionSet Instruction set, must be supported by the host CPU
+     */
+inline void logLossGradientsAndHessians(const double *scores, const double *targets, size_t n, double eps,
+                                        double *gradients, double *hessians,
+                                        InstructionSet instructionSet = hostInstructionSet())
+{
+#ifdef MICROGBT_X86_SIMD
+    if (instructionSet == InstructionSet::AVX512)
+    {
+        detail::logLossAVX512(scores, targets, n, eps, gradients, hessians);
+        return;
+    }
+    if (instructionSet == InstructionSet::AVX2)
+    {
+        detail::logLossAVX2(scores, targets, n, eps, gradients, hessians);
+        return;
+    }
+#endif
+    (void)instructionSet;
+    for (size_t i = 0; i < n; i++)
+    {
+        double p = detail::sigmoid(scores[i], eps);
+        gradients[i] = p - targets[i];
+        hessians[i] = p * (1.0 - p);
+    }
+}
+
+/**
+     * Gradients 2 (s - y) and Hessians 2 of the squared error at predictions s = scores
+     *
+     * @param scores Raw scores, n values
+     * @param targets Targets, n values
+     * @param n Number of samples
+     * @param gradients Output, n values
+     * @param hessians Output, n values
+     * @param instructionSet Instruction set, must be supported by the host CPU
+     */
+inline void squaredErrorGradientsAndHessians(const double *scores, const double *targets, size_t n,
+                                             double *gradients, double *hessians,
+                                             InstructionSet instructionSet = hostInstructionSet())
+{
+#ifdef MICROGBT_X86_SIMD
+    if (instructionSet == InstructionSet::AVX512)
+    {
+        detail::squaredErrorAVX512(scores, targets, n, gradients, hessians);
+        return;
+    }
+    if (instructionSet == InstructionSet::AVX2)
+    {
+        detail::squaredErrorAVX2(scores, targets, n, gradients, hessians);
+        return;
+    }
+#endif
+    (void)instructionSet;
+    for (size_t i = 0; i < n; i++)
+    {
+        gradients[i] = 2.0 * (scores[i] - targets[i]);
+        hessians[i] = 2.0;
+    }
+}
+} // namespace kernels
+} // namespace microgbt
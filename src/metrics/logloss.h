@@ -3,8 +3,11 @@
 #include <algorithm>
 #include <random>
 #include <cmath>
+#include <cstdio>
+#include <string>
 
 #include "metric.h"
+#include "kernels.h"
 
 namespace microgbt
 {
@@ -21,6 +24,13 @@ private:
     // Numerical tolerance on boundary of log(x) and log(1-x) function in range [0,1]
     double _eps;
 
+protected:
+    void gradientsAndHessiansBlock(const double *scores, const double *targets, size_t n,
+                                   double *gradients, double *hessians) const override
+    {
+        kernels::logLossGradientsAndHessians(scores, targets, n, _eps, gradients, hessians);
+    }
+
 public:
     LogLoss() { _eps = 10e-8; }
 
@@ -87,5 +97,20 @@ public:
     }
 
     double scoreToPrediction(double score) const override { return logit(score); }
+
+    std::string scoreToPredictionSource() const override
+    {
+        char eps[32];
+        snprintf(eps, sizeof(eps), "%.17g", _eps);
+
+        std::string source = "const double eps = ";
+        source += eps;
+        source += ";\n";
+        source += "double value = 1.0 / (1 + std::exp(-score));\n";
+        source += "if (value > 1 - eps)\n    return 1 - eps;\n";
+        source += "else if (value < eps)\n    return eps;\n";
+        source += "return value;";
+        return source;
+    }
 };
 } // namespace microgbt
\ No newline at end of file
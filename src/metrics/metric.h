@@ -1,9 +1,13 @@
 #pragma once
 #include <vector>
+#include <string>
 #include <cmath>
+#include <algorithm>
+#include <functional>
 #include <Eigen/Dense>
 
 #include "../types.h"
+#include "../utils/thread_pool.h"
 
 namespace microgbt
 {
@@ -18,7 +22,17 @@ namespace microgbt
 class Metric
 {
 
+protected:
+    /**
+         * Compute the gradients and Hessians of a contiguous block of samples, see gradientsAndHessians
+         */
+    virtual void gradientsAndHessiansBlock(const double *scores, const double *targets, size_t n,
+                                           double *gradients, double *hessians) const = 0;
+
 public:
+    // Number of samples per block of gradientsAndHessians, a multiple of the cache line size
+    static constexpr size_t BlockSize = 16384;
+
     virtual ~Metric() = default;
 
     /**
@@ -38,6 +52,42 @@ public:
          */
     virtual Vector hessian(const Vector &predictions) const = 0;
 
+    /**
+         * Compute the gradient and Hessian vectors at given raw scores in a single pass, i.e., gradients(predictions)
+         * and hessian(predictions) where predictions are the scoreToPrediction transformations of the scores
+         *
+         * Results are written into caller-owned buffers, which are meant to be reused across boosting iterations.
+         * Blocks of samples are processed in parallel if a thread pool is given; the results do not depend on it.
+         *
+         * @param scores Raw scores, i.e., sums of scores over all trees
+         * @param targets Vector of values to be predicted
+         * @param n Number of samples
+         * @param gradients Output gradient vector of n values
+         * @param hessians Output Hessian vector of n values
+         * @param threadPool Optional thread pool
+         */
+    void gradientsAndHessians(const double *scores, const double *targets, size_t n,
+                              double *gradients, double *hessians, ThreadPool *threadPool = nullptr) const
+    {
+        size_t numBlocks = (n + BlockSize - 1) / BlockSize;
+        std::function<void(size_t)> computeBlock = [&](size_t block) {
+            size_t begin = block * BlockSize, end = std::min(n, begin + BlockSize);
+            gradientsAndHessiansBlock(scores + begin, targets + begin, end - begin, gradients + begin, hessians + begin);
+        };
+
+        if (threadPool && numBlocks > 1)
+        {
+            threadPool->parallelFor(numBlocks, computeBlock);
+        }
+        else
+        {
+            for (size_t block = 0; block < numBlocks; block++)
+            {
+                computeBlock(block);
+            }
+        }
+    }
+
     /**
          * Compute the loss at given prediction values.
          *
@@ -56,5 +106,13 @@ public:
          * @return Prediction value
          */
     virtual double scoreToPrediction(double score) const = 0;
+
+    /**
+         * C++ source of the body of a function "double scoreToPrediction(double score)" that is equivalent to
+         * scoreToPrediction; used to generate standalone model source code.
+         *
+         * @return Function body, i.e., one or more C++ statements returning the prediction
+         */
+    virtual std::string scoreToPredictionSource() const = 0;
 };
 } // namespace microgbt
\ No newline at end of file
@@ -2,12 +2,20 @@
 #include <cmath>
 
 #include "metric.h"
+#include "kernels.h"
 
 namespace microgbt
 {
 
 class RMSE : public Metric
 {
+protected:
+    void gradientsAndHessiansBlock(const double *scores, const double *targets, size_t n,
+                                   double *gradients, double *hessians) const override
+    {
+        kernels::squaredErrorGradientsAndHessians(scores, targets, n, gradients, hessians);
+    }
+
 public:
     RMSE() = default;
 
@@ -32,13 +40,16 @@ public:
         size_t n = predictions.size();
         for (size_t i = 0; i < n; i++)
         {
-            loss += pow(labels[i] - predictions[i], 2.0);
+            double diff = labels[i] - predictions[i];
+            loss += diff * diff;
         }
 
         return (double)std::sqrt(loss / n);
     }
 
     double scoreToPrediction(double score) const override { return score; }
+
+    std::string scoreToPredictionSource() const override { return "return score;"; }
 };
 
 } // namespace microgbt
\ No newline at end of file
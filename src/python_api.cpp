@@ -3,39 +3,145 @@
 #include <pybind11/stl.h>
 #include <vector>
 #include "GBT.h"
+#include "codegen/code_generator.h"
+#include "io/text_loader.h"
 
 namespace py = pybind11;
 
-PYBIND11_MODULE(microgbtpy, m)
+/**
+     * Bind a GBT model with feature storage type Feature as Python class name
+     */
+template <typename Feature>
+void bindModel(py::module &m, const char *name)
 {
-        m.doc() = "microGBT Python API";
+        using Model = microgbt::BasicGBT<Feature>;
 
-        py::class_<microgbt::GBT> gbt(m, "GBT");
+        py::class_<Model> gbt(m, name);
 
         // Common methods
         gbt.def(py::init<std::map<std::string, double>>())
-            .def("max_depth", &microgbt::GBT::maxDepth)
-            .def("gamma", &microgbt::GBT::gamma)
-            .def("min_split_gain", &microgbt::GBT::minSplitGain)
-            .def("learning_rate", &microgbt::GBT::getLearningRate)
-            .def("get_lambda", &microgbt::GBT::lambda)
-            .def("best_iteration", &microgbt::GBT::getBestIteration);
-
-        // Train API
-        gbt.def("train", &microgbt::GBT::trainPython,
+            .def("max_depth", &Model::maxDepth)
+            .def("max_leaves", &Model::maxLeaves)
+            .def("enable_bundle", &Model::enableBundle)
+            .def("max_conflict_rate", &Model::maxConflictRate)
+            .def("categorical_features", &Model::categoricalFeatures)
+            .def("set_categorical_features", &Model::setCategoricalFeatures,
+                 "Declare the categorical features (integer category codes) of the training data",
+                 pybind11::arg("features"))
+            .def("goss", &Model::goss)
+            .def("subsample", &Model::subsample)
+            .def("colsample_bytree", &Model::colsampleByTree)
+            .def("colsample_bylevel", &Model::colsampleByLevel)
+            .def("gamma", &Model::gamma)
+            .def("min_split_gain", &Model::minSplitGain)
+            .def("learning_rate", &Model::getLearningRate)
+            .def("get_lambda", &Model::lambda)
+            .def("best_iteration", &Model::getBestIteration)
+            .def("verbosity", [](const Model &a) { return static_cast<int>(a.verbosity()); })
+            .def("set_verbosity", [](Model &a, int level) { a.setVerbosity(static_cast<microgbt::LogLevel>(level)); },
+                 "Set the log level of training: 0 (silent), 1 (info) or 2 (debug)", pybind11::arg("level"));
+
+        // Training metrics, as a dict of per-iteration lists (see microgbt::IterationStats)
+        gbt.def("history",
+                [](const Model &a) {
+                        py::dict history;
+                        for (const std::pair<std::string, double> &field : microgbt::IterationStats().fields())
+                        {
+                                history[py::str(field.first)] = py::list();
+                        }
+                        for (const microgbt::IterationStats &stats : a.history())
+                        {
+                                for (const std::pair<std::string, double> &field : stats.fields())
+                                {
+                                        history[py::str(field.first)].cast<py::list>().append(field.second);
+                                }
+                        }
+                        return history;
+                },
+                "Metrics of every iteration of the last training run: phase durations (ms), node counts, rows "
+                "touched, bytes allocated and losses");
+
+        // Train API; Fortran-ordered arrays of the input type are used in place, other arrays are converted by pybind11
+        using TrainPython = void (Model::*)(const typename Model::InputMatrixRef &,
+                                            const Eigen::Ref<const Eigen::VectorXd> &,
+                                            const typename Model::InputMatrixRef &,
+                                            const Eigen::Ref<const Eigen::VectorXd> &, int, int);
+        gbt.def("train", static_cast<TrainPython>(&Model::trainPython),
                 "Python API for microGBT training",
                 py::call_guard<py::gil_scoped_release>(),
                 pybind11::arg("train_X"), pybind11::arg("train_y"),
                 pybind11::arg("valid_x"), pybind11::arg("valid_y"),
                 pybind11::arg("num_iterations"), pybind11::arg("early_stopping_rounds") = 5);
 
+        // Sparse train API; scipy.sparse matrices are converted to CSC. A separate method, since pybind11 would convert
+        // dense arrays to sparse matrices as well, i.e., zeros to missing values
+        using TrainSparsePython = void (Model::*)(const microgbt::SparseMatrixType &,
+                                                  const Eigen::Ref<const Eigen::VectorXd> &,
+                                                  const microgbt::SparseMatrixType &,
+                                                  const Eigen::Ref<const Eigen::VectorXd> &, int, int);
+        gbt.def("train_sparse", static_cast<TrainSparsePython>(&Model::trainPython),
+                "Python API for microGBT training on scipy.sparse matrices, whose missing entries are missing values",
+                py::call_guard<py::gil_scoped_release>(),
+                pybind11::arg("train_X"), pybind11::arg("train_y"),
+                pybind11::arg("valid_x"), pybind11::arg("valid_y"),
+                pybind11::arg("num_iterations"), pybind11::arg("early_stopping_rounds") = 5);
+
         // Predict API
-        gbt.def("predict", &microgbt::GBT::predict, "Python API to get predictions using microGBT",
+        gbt.def("predict", &Model::predict, "Python API to get predictions using microGBT",
                 pybind11::arg("x"),
                 pybind11::arg("num_iterations") = 0);
 
+        gbt.def("predict_batch", &Model::predictBatch,
+                "Python API to get predictions of all rows of a matrix using microGBT",
+                py::call_guard<py::gil_scoped_release>(),
+                pybind11::arg("X"),
+                pybind11::arg("num_iterations") = 0,
+                pybind11::arg("num_threads") = 0,
+                pybind11::arg("raw_score") = false,
+                pybind11::arg("engine") = microgbt::PredictionEngine::TreeTraversal);
+
+        gbt.def("predict_sparse", &Model::predictSparse,
+                "Python API to get predictions of all rows of a scipy.sparse matrix (converted to CSR) using microGBT",
+                py::call_guard<py::gil_scoped_release>(),
+                pybind11::arg("X"),
+                pybind11::arg("num_iterations") = 0,
+                pybind11::arg("num_threads") = 0,
+                pybind11::arg("raw_score") = false,
+                pybind11::arg("engine") = microgbt::PredictionEngine::TreeTraversal);
+
+        // Out-of-core train API, on a file written by BinnedFileWriter
+        gbt.def("train_out_of_core", &Model::trainOutOfCorePython,
+                "Train on a memory-mapped file of pre-binned training data, block by block",
+                py::call_guard<py::gil_scoped_release>(),
+                pybind11::arg("train_path"),
+                pybind11::arg("valid_x"), pybind11::arg("valid_y"),
+                pybind11::arg("num_iterations"), pybind11::arg("early_stopping_rounds") = 5);
+
+        // Export API
+        gbt.def("export_cpp", &microgbt::CodeGenerator::generate<Feature>,
+                "Export the model as a standalone C++ header",
+                pybind11::arg("num_iterations") = 0,
+                pybind11::arg("namespace") = "microgbt_model");
+
+        // Persistence API, see microgbt::ModelFormat
+        gbt.def("save_model", &Model::saveModel,
+                "Save the model to a file in the binary model format",
+                pybind11::arg("path"));
+
+        gbt.def_static("load_model", &Model::loadModel,
+                       "Load a model file; the file is memory-mapped and shared across processes",
+                       pybind11::arg("path"));
+
+        gbt.def(py::pickle(
+            [](const Model &a) {
+                    return py::bytes(a.serialize());
+            },
+            [](const py::bytes &state) {
+                    return Model::deserialize(std::string(state));
+            }));
+
         gbt.def("__repr__",
-                [](const microgbt::GBT &a) {
+                [](const Model &a) {
                         std::string repr;
                         repr += "<microgbt>[";
                         repr += "learningRate:";
@@ -53,4 +159,88 @@ PYBIND11_MODULE(microgbtpy, m)
                         repr += "]";
                         return repr;
                 });
+}
+
+PYBIND11_MODULE(microgbtpy, m)
+{
+        m.doc() = "microGBT Python API";
+
+        py::enum_<microgbt::PredictionEngine>(m, "PredictionEngine")
+            .value("TreeTraversal", microgbt::PredictionEngine::TreeTraversal)
+            .value("QuickScorer", microgbt::PredictionEngine::QuickScorer);
+
+        // Writer of pre-binned training files for out-of-core training
+        py::class_<microgbt::BinnedFileWriter>(m, "BinnedFileWriter")
+            .def(py::init<const std::string &, uint64_t, std::vector<microgbt::Vector>>(),
+                 pybind11::arg("path"), pybind11::arg("rows"), pybind11::arg("thresholds"))
+            .def("append",
+                 [](microgbt::BinnedFileWriter &writer, const microgbt::ColMajorMatrixRef &X,
+                    const Eigen::Ref<const Eigen::VectorXd> &y) {
+                         if (y.size() != X.rows())
+                         {
+                                 throw std::invalid_argument("Number of targets does not match number of samples");
+                         }
+                         writer.append(X, y.data());
+                 },
+                 "Bin and append a chunk of rows", pybind11::arg("X"), pybind11::arg("y"))
+            .def("close", &microgbt::BinnedFileWriter::close)
+            .def_static("fit_thresholds", &microgbt::BinnedFileWriter::fitThresholds,
+                        "Fit the bin thresholds of every feature to a sample of the rows",
+                        pybind11::arg("X"), pybind11::arg("max_bin") = 255)
+            .def_static("write",
+                        [](const std::string &path, const microgbt::ColMajorMatrixRef &X,
+                           const Eigen::Ref<const Eigen::VectorXd> &y, int maxBin) {
+                                if (y.size() != X.rows())
+                                {
+                                        throw std::invalid_argument("Number of targets does not match number of samples");
+                                }
+                                microgbt::BinnedFileWriter::write(path, X, y.data(), maxBin);
+                        },
+                        "Write an in-memory dataset to a binned file",
+                        pybind11::arg("path"), pybind11::arg("X"), pybind11::arg("y"), pybind11::arg("max_bin") = 255);
+
+        // Native loaders; the design matrix is returned as a Fortran-ordered array, which training uses in place
+        m.def("load_csv",
+              [](const std::string &path, long labelColumn, std::vector<long> columns, const std::string &delimiter,
+                 bool header, int numThreads) {
+                      if (delimiter.size() > 1)
+                      {
+                              throw std::invalid_argument("Delimiter must be a single character");
+                      }
+                      microgbt::TextLoader::Options options;
+                      options.labelColumn = labelColumn;
+                      options.columns = std::move(columns);
+                      options.delimiter = delimiter.empty() ? 0 : delimiter[0];
+                      options.header = header;
+                      options.numThreads = numThreads;
+                      microgbt::TextData data = microgbt::TextLoader::load(path, options);
+                      return std::make_pair(std::move(data.X), std::move(data.y));
+              },
+              "Load a CSV file as a (X, y) tuple, parsing it in parallel",
+              py::call_guard<py::gil_scoped_release>(),
+              pybind11::arg("path"), pybind11::arg("label_column") = 0,
+              pybind11::arg("columns") = std::vector<long>(), pybind11::arg("delimiter") = "",
+              pybind11::arg("header") = false, pybind11::arg("num_threads") = 0);
+
+        m.def("load_libsvm",
+              [](const std::string &path, long numFeatures, bool zeroBased, std::vector<long> columns, int numThreads) {
+                      microgbt::TextLoader::Options options;
+                      options.format = microgbt::TextFormat::LibSVM;
+                      options.numFeatures = numFeatures;
+                      options.zeroBased = zeroBased;
+                      options.columns = std::move(columns);
+                      options.numThreads = numThreads;
+                      microgbt::TextData data = microgbt::TextLoader::load(path, options);
+                      return std::make_pair(std::move(data.X), std::move(data.y));
+              },
+              "Load a LibSVM file as a (X, y) tuple, parsing it in parallel",
+              py::call_guard<py::gil_scoped_release>(),
+              pybind11::arg("path"), pybind11::arg("num_features") = 0, pybind11::arg("zero_based") = false,
+              pybind11::arg("columns") = std::vector<long>(), pybind11::arg("num_threads") = 0);
+
+        // Models with double, float32, int16 and uint8 (quantized) training feature storage
+        bindModel<double>(m, "GBT");
+        bindModel<float>(m, "GBTFloat32");
+        bindModel<int16_t>(m, "GBTInt16");
+        bindModel<uint8_t>(m, "GBTUInt8");
 } // PYBIND11_MODULE
@@ -0,0 +1,96 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <random>
+#include <numeric>
+#include <algorithm>
+
+#include "../types.h"
+#include "random_subset.h"
+
+namespace microgbt
+{
+
+/**
+     * Gradient-based One-Side Sampling (GOSS) of the training samples of a boosting iteration
+     *
+     * Samples with large gradients contribute most to the split gains, hence GOSS keeps the topRate fraction of
+     * the samples with the largest absolute gradient and samples an otherRate fraction of all samples uniformly at
+     * random from the remaining ones. The gradients and Hessians of the latter are amplified by
+     * (1 - topRate) / otherRate, so that the split gains remain (approximately) unbiased.
+     *
+     * Refer to "LightGBM: A Highly Efficient Gradient Boosting Decision Tree", NIPS 2017
+     */
+class GOSS
+{
+
+    // Fractions of samples with large gradients, and of samples drawn at random from the rest
+    double _topRate, _otherRate;
+
+public:
+    GOSS(double topRate, double otherRate) : _topRate(topRate), _otherRate(otherRate) {}
+
+    inline double topRate() const { return _topRate; }
+
+    inline double otherRate() const { return _otherRate; }
+
+    /**
+         * Sample the rows of a dataset based on their gradients
+         *
+         * @param gradient Gradient vector, one coordinate per sample / dataset row
+         * @param rng Random number generator
+         * @param weights Output: weight of every sampled row, i.e., 1 for the rows with large gradients and
+         *                (1 - topRate) / otherRate for the other ones
+         * @return Increasing list of sampled (local) row indices; all rows if the rates keep every sample
+         */
+    template <typename RandomGenerator>
+    VectorT sample(const Vector &gradient, RandomGenerator &rng, Vector &weights) const
+    {
+        size_t numRows = gradient.size();
+        size_t numTop = static_cast<size_t>(std::ceil(_topRate * static_cast<double>(numRows)));
+        size_t numOther = static_cast<size_t>(std::ceil(_otherRate * static_cast<double>(numRows)));
+
+        VectorT rows(numRows);
+        std::iota(rows.begin(), rows.end(), 0);
+        if (numTop + numOther >= numRows)
+        {
+            weights.assign(numRows, 1.0);
+            return rows;
+        }
+
+        // Rows with the largest absolute gradient first; ties are broken by row index, so that the sample
+        // only depends on the state of the random number generator
+        std::nth_element(rows.begin(), rows.begin() + numTop, rows.end(),
+                         [&gradient](size_t i, size_t j) {
+                             double gi = std::fabs(gradient[i]), gj = std::fabs(gradient[j]);
+                             return gi > gj || (gi == gj && i < j);
+                         });
+        std::sort(rows.begin() + numTop, rows.end());
+
+        // Uniform sample of the remaining rows
+        VectorT others = randomSubset(numRows - numTop, numOther, rng);
+
+        double otherWeight = (1.0 - _topRate) / _otherRate;
+        std::vector<double> rowWeight(numRows, 0.0);
+        for (size_t k = 0; k < numTop; k++)
+        {
+            rowWeight[rows[k]] = 1.0;
+        }
+        for (size_t k = 0; k < numOther; k++)
+        {
+            rows[numTop + k] = rows[numTop + others[k]];
+            rowWeight[rows[numTop + k]] = otherWeight;
+        }
+
+        rows.resize(numTop + numOther);
+        std::sort(rows.begin(), rows.end());
+        weights.resize(rows.size());
+        for (size_t k = 0; k < rows.size(); k++)
+        {
+            weights[k] = rowWeight[rows[k]];
+        }
+
+        return rows;
+    }
+};
+} // namespace microgbt
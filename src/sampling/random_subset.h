@@ -0,0 +1,63 @@
+#pragma once
+#include <vector>
+#include <random>
+#include <numeric>
+#include <algorithm>
+
+#include "../types.h"
+
+namespace microgbt
+{
+
+/**
+     * Draw a uniformly random subset of k distinct indices of [0, n), by a partial Fisher-Yates shuffle
+     *
+     * @param n Number of indices
+     * @param k Size of the subset, at most n
+     * @param rng Random number generator
+     * @return Increasing list of k indices
+     */
+template <typename RandomGenerator>
+VectorT randomSubset(size_t n, size_t k, RandomGenerator &rng)
+{
+    VectorT indices(n);
+    std::iota(indices.begin(), indices.end(), 0);
+    for (size_t i = 0; i < k; i++)
+    {
+        std::uniform_int_distribution<size_t> uniform(i, n - 1);
+        std::swap(indices[i], indices[uniform(rng)]);
+    }
+
+    indices.resize(k);
+    std::sort(indices.begin(), indices.end());
+    return indices;
+}
+
+/**
+     * Draw a uniformly random subset of a fraction of a list of indices, e.g., a column sample of the features of a
+     * dataset
+     *
+     * @param indices Increasing list of indices
+     * @param rate Fraction of indices to keep; at least one index is kept
+     * @param rng Random number generator
+     * @return Increasing sub-list of indices; all indices if rate >= 1
+     */
+template <typename RandomGenerator>
+VectorT randomFraction(const VectorT &indices, double rate, RandomGenerator &rng)
+{
+    if (rate >= 1.0 || indices.empty())
+    {
+        return indices;
+    }
+
+    size_t k = static_cast<size_t>(rate * static_cast<double>(indices.size()) + 0.5);
+    k = std::max<size_t>(1, std::min(k, indices.size()));
+
+    VectorT subset = randomSubset(indices.size(), k, rng);
+    for (size_t &i : subset)
+    {
+        i = indices[i];
+    }
+    return subset;
+}
+} // namespace microgbt
@@ -0,0 +1,89 @@
+#pragma once
+#include <limits>
+#include <algorithm>
+#include <Eigen/SparseCore>
+
+namespace microgbt
+{
+
+// Compressed sparse column matrix (CSC), e.g., a scipy.sparse.csc_matrix; used for training, see BasicDataset
+using SparseMatrixType = Eigen::SparseMatrix<double, Eigen::ColMajor, int>;
+
+// Compressed sparse row matrix (CSR), e.g., a scipy.sparse.csr_matrix; used for prediction, see GBT::predictSparse
+using SparseRowMatrixType = Eigen::SparseMatrix<double, Eigen::RowMajor, int>;
+
+/**
+     * Return an entry of a compressed sparse matrix, or NaN if it is not stored, i.e., entries that are not stored
+     * are missing values
+     *
+     * @param X Compressed sparse matrix
+     * @param outer Outer index, i.e., column of a CSC matrix or row of a CSR matrix
+     * @param inner Inner index, i.e., row of a CSC matrix or column of a CSR matrix
+     */
+template <typename SparseMatrix>
+inline double sparseValue(const SparseMatrix &X, long outer, long inner)
+{
+    const int *begin = X.innerIndexPtr() + X.outerIndexPtr()[outer];
+    const int *end = X.innerIndexPtr() + X.outerIndexPtr()[outer + 1];
+    const int *position = std::lower_bound(begin, end, static_cast<int>(inner));
+    if (position == end || *position != inner)
+    {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return X.valuePtr()[position - X.innerIndexPtr()];
+}
+
+/**
+     * Whether a sparse matrix is compressed and its inner indices are increasing within each outer vector, as
+     * required by sparseValue (e.g., the indices of a scipy.sparse matrix need not be sorted)
+     */
+template <typename SparseMatrix>
+bool isCanonical(const SparseMatrix &X)
+{
+    if (!X.isCompressed())
+    {
+        return false;
+    }
+    for (long j = 0; j < X.outerSize(); j++)
+    {
+        if (!std::is_sorted(X.innerIndexPtr() + X.outerIndexPtr()[j], X.innerIndexPtr() + X.outerIndexPtr()[j + 1]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+     * Return a copy of a sparse matrix that is canonical, see isCanonical
+     */
+template <typename SparseMatrix>
+SparseMatrix canonicalCopy(const SparseMatrix &X)
+{
+    if (isCanonical(X))
+    {
+        return X;
+    }
+
+    // Converting to the other storage order, and back, sorts the inner indices
+    Eigen::SparseMatrix<double, (SparseMatrix::IsRowMajor ? Eigen::ColMajor : Eigen::RowMajor), int> transposed(X);
+    SparseMatrix copy(transposed);
+    copy.makeCompressed();
+    return copy;
+}
+
+/**
+     * Lightweight view of a row of a compressed sparse row matrix, i.e., sample[colIndex] is a feature value (NaN if
+     * the entry is not stored)
+     */
+class SparseRowSample
+{
+    const SparseRowMatrixType *_X;
+    long _rowIndex;
+
+public:
+    SparseRowSample(const SparseRowMatrixType &X, long rowIndex) : _X(&X), _rowIndex(rowIndex) {}
+
+    inline double operator[](long colIndex) const { return sparseValue(*_X, _rowIndex, colIndex); }
+};
+} // namespace microgbt
@@ -0,0 +1,71 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+namespace microgbt
+{
+
+/**
+     * Sets of categories of categorical splits, stored as bitsets of 32-bit words
+     *
+     * The values of a categorical feature are integer category codes in [0, MaxCategory]; negative and missing (NaN)
+     * values belong to no category. A sample goes to the left child of a categorical split if and only if its category
+     * is in the set of the split, i.e., missing values and categories unseen in training go to the right child.
+     */
+class CategorySet
+{
+public:
+    // Categories per word of a bitset
+    static constexpr int WordBits = 32;
+
+    // Largest category, i.e., a bitset has at most 32768 words
+    static constexpr long MaxCategory = (1L << 20) - 1;
+
+    /**
+         * Category of a feature value, or -1 if it belongs to no category (including values above MaxCategory)
+         */
+    static inline long category(double value)
+    {
+        return (value >= 0.0 && value <= static_cast<double>(MaxCategory)) ? static_cast<long>(value) : -1;
+    }
+
+    /**
+         * Whether a feature value belongs to a set of categories
+         *
+         * @param words Bitset of the categories
+         * @param numWords Number of words of the bitset
+         * @param value Feature value
+         */
+    static inline bool contains(const uint32_t *words, size_t numWords, double value)
+    {
+        long c = category(value);
+        if (c < 0 || static_cast<size_t>(c / WordBits) >= numWords)
+        {
+            return false;
+        }
+        return ((words[c / WordBits] >> (c % WordBits)) & 1U) != 0;
+    }
+
+    /**
+         * Bitset of a list of categories, with as many words as its largest category requires
+         *
+         * @param categories Non-negative categories
+         */
+    static std::vector<uint32_t> bitset(const std::vector<long> &categories)
+    {
+        std::vector<uint32_t> words;
+        for (long c : categories)
+        {
+            size_t word = static_cast<size_t>(c / WordBits);
+            if (word >= words.size())
+            {
+                words.resize(word + 1, 0);
+            }
+            words[word] |= 1U << (c % WordBits);
+        }
+        return words;
+    }
+};
+} // namespace microgbt
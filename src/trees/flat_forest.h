@@ -0,0 +1,358 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "tree.h"
+#include "treenode.h"
+#include "category_set.h"
+
+namespace microgbt
+{
+
+/**
+     * FlatForest is the inference representation of an ensemble of trees.
+     *
+     * All nodes of all trees are stored in a single contiguous node table laid out as a structure of arrays.
+     * The nodes of a tree are stored in pre-order, hence the left child of an internal node is the next node
+     * of the table and only the offset of the right child is stored. Scoring a sample walks the table iteratively.
+     *
+     * The node table is either owned by the forest, or is a read-only view of an external buffer, e.g., a
+     * memory-mapped model file, that is kept alive by the forest (see FlatForest::view).
+     *
+     * Categorical split nodes store their feature f as -2 - f, and the offset of their set of categories (the
+     * categories of the left branch, see CategorySet) in a pool of bitset words as their threshold. Each set of the
+     * pool is stored as its number of words followed by its words.
+     */
+class FlatForest
+{
+
+    // Feature index of internal nodes; -1 for leaves, -2 - feature index for categorical split nodes
+    std::vector<int32_t> _featureIndex;
+
+    // Numeric split value of internal nodes; offset of the set of categories for categorical split nodes
+    std::vector<double> _threshold;
+
+    // Offset of the right child of internal nodes, relative to the node itself. The offset is negated for nodes
+    // whose samples with a missing (NaN) feature value follow the left branch; otherwise they follow the right one
+    std::vector<int32_t> _rightChild;
+
+    // Weight of leaves
+    std::vector<double> _leafValue;
+
+    // Node table offset of the root of each tree
+    std::vector<int32_t> _treeOffsets;
+
+    // Sets of categories of categorical split nodes
+    std::vector<uint32_t> _categories;
+
+    // Arrays of the node table used for inference: either the vectors above or an external buffer
+    struct NodeTable
+    {
+        const int32_t *featureIndex = nullptr, *rightChild = nullptr, *treeOffsets = nullptr;
+        const double *threshold = nullptr, *leafValue = nullptr;
+        const uint32_t *categories = nullptr;
+        size_t numNodes = 0, numTrees = 0, numCategoryWords = 0;
+    } _table;
+
+    // Owner of the external buffer, if any
+    std::shared_ptr<const void> _externalBuffer;
+
+    // Number of features of the training samples; zero if unknown, e.g., for models that do not record it
+    size_t _numFeatures = 0;
+
+    // One more than the largest split feature, i.e., the minimum number of features of a sample
+    size_t _minFeatures = 0;
+
+    void viewOwnedTable()
+    {
+        _table.featureIndex = _featureIndex.data();
+        _table.threshold = _threshold.data();
+        _table.rightChild = _rightChild.data();
+        _table.leafValue = _leafValue.data();
+        _table.treeOffsets = _treeOffsets.data();
+        _table.categories = _categories.data();
+        _table.numNodes = _featureIndex.size();
+        _table.numTrees = _treeOffsets.size();
+        _table.numCategoryWords = _categories.size();
+    }
+
+    /**
+         * Append a subtree in pre-order
+         *
+         * @param node Root of subtree
+         */
+    template <typename Node>
+    void appendNode(const Node &node)
+    {
+        size_t index = _featureIndex.size();
+
+        if (!node.isLeaf() && node.isCategorical())
+        {
+            _featureIndex.push_back(-2 - static_cast<int32_t>(node.splitFeatureIndex()));
+            _threshold.push_back(static_cast<double>(_categories.size()));
+            _categories.push_back(static_cast<uint32_t>(node.categories().size()));
+            _categories.insert(_categories.end(), node.categories().begin(), node.categories().end());
+        }
+        else
+        {
+            _featureIndex.push_back(node.isLeaf() ? -1 : static_cast<int32_t>(node.splitFeatureIndex()));
+            _threshold.push_back(node.isLeaf() ? 0.0 : node.splitValue());
+        }
+        if (!node.isLeaf())
+        {
+            _minFeatures = std::max(_minFeatures, static_cast<size_t>(node.splitFeatureIndex()) + 1);
+        }
+        _rightChild.push_back(0);
+        _leafValue.push_back(node.isLeaf() ? node.weight() : 0.0);
+
+        if (!node.isLeaf())
+        {
+            appendNode(*node.left());
+            int32_t offset = static_cast<int32_t>(_featureIndex.size() - index);
+            _rightChild[index] = node.defaultLeft() ? -offset : offset;
+            appendNode(*node.right());
+        }
+    }
+
+public:
+    FlatForest() = default;
+
+    FlatForest(const FlatForest &other)
+        : _featureIndex(other._featureIndex), _threshold(other._threshold), _rightChild(other._rightChild),
+          _leafValue(other._leafValue), _treeOffsets(other._treeOffsets), _categories(other._categories),
+          _table(other._table), _externalBuffer(other._externalBuffer), _numFeatures(other._numFeatures),
+          _minFeatures(other._minFeatures)
+    {
+        if (!_externalBuffer)
+        {
+            viewOwnedTable();
+        }
+    }
+
+    FlatForest(FlatForest &&other) = default;
+
+    FlatForest &operator=(FlatForest other)
+    {
+        std::swap(_featureIndex, other._featureIndex);
+        std::swap(_threshold, other._threshold);
+        std::swap(_rightChild, other._rightChild);
+        std::swap(_leafValue, other._leafValue);
+        std::swap(_treeOffsets, other._treeOffsets);
+        std::swap(_categories, other._categories);
+        std::swap(_table, other._table);
+        std::swap(_externalBuffer, other._externalBuffer);
+        std::swap(_numFeatures, other._numFeatures);
+        std::swap(_minFeatures, other._minFeatures);
+        return *this;
+    }
+
+    /**
+         * Return a forest whose node table is a read-only view of external arrays, without copying them
+         *
+         * @param treeOffsets Node table offset of the root of each tree
+         * @param numTrees Number of trees
+         * @param featureIndex Feature index of each node (-1 for leaves)
+         * @param threshold Split value of each node
+         * @param rightChild Relative offset of the right child of each node
+         * @param leafValue Weight of each node
+         * @param numNodes Number of nodes
+         * @param categories Sets of categories of the categorical split nodes
+         * @param numCategoryWords Number of words of the sets of categories
+         * @param numFeatures Number of features of the training samples; zero if unknown
+         * @param buffer Owner of the arrays, kept alive as long as the forest (or a copy of it) exists
+         */
+    static FlatForest view(const int32_t *treeOffsets, size_t numTrees,
+                           const int32_t *featureIndex, const double *threshold,
+                           const int32_t *rightChild, const double *leafValue, size_t numNodes,
+                           const uint32_t *categories, size_t numCategoryWords, size_t numFeatures,
+                           std::shared_ptr<const void> buffer)
+    {
+        FlatForest forest;
+        forest._table.treeOffsets = treeOffsets;
+        forest._table.numTrees = numTrees;
+        forest._table.featureIndex = featureIndex;
+        forest._table.threshold = threshold;
+        forest._table.rightChild = rightChild;
+        forest._table.leafValue = leafValue;
+        forest._table.numNodes = numNodes;
+        forest._table.categories = categories;
+        forest._table.numCategoryWords = numCategoryWords;
+        forest._externalBuffer = std::move(buffer);
+        forest._numFeatures = numFeatures;
+        for (size_t node = 0; node < numNodes; node++)
+        {
+            if (!forest.isLeaf(node))
+            {
+                forest._minFeatures = std::max(forest._minFeatures, static_cast<size_t>(forest.featureIndex(node)) + 1);
+            }
+        }
+        return forest;
+    }
+
+    /**
+         * Compile a built tree and append it to the forest
+         *
+         * @param tree Built tree
+         */
+    template <typename Feature>
+    void addTree(const BasicTree<Feature> &tree)
+    {
+        // An external node table is read-only, hence it is copied before it is extended
+        if (_externalBuffer)
+        {
+            _featureIndex.assign(_table.featureIndex, _table.featureIndex + _table.numNodes);
+            _threshold.assign(_table.threshold, _table.threshold + _table.numNodes);
+            _rightChild.assign(_table.rightChild, _table.rightChild + _table.numNodes);
+            _leafValue.assign(_table.leafValue, _table.leafValue + _table.numNodes);
+            _treeOffsets.assign(_table.treeOffsets, _table.treeOffsets + _table.numTrees);
+            _categories.assign(_table.categories, _table.categories + _table.numCategoryWords);
+            _externalBuffer.reset();
+        }
+
+        _treeOffsets.push_back(static_cast<int32_t>(_featureIndex.size()));
+        appendNode(*tree.root());
+        viewOwnedTable();
+    }
+
+    inline size_t numTrees() const { return _table.numTrees; }
+
+    inline size_t numNodes() const { return _table.numNodes; }
+
+    /**
+         * Number of features of the training samples; zero if unknown
+         */
+    inline size_t numFeatures() const { return _numFeatures; }
+
+    inline void setNumFeatures(size_t numFeatures) { _numFeatures = numFeatures; }
+
+    /**
+         * Minimum number of features of a sample, i.e., one more than the largest split feature
+         */
+    inline size_t minFeatures() const { return _minFeatures; }
+
+    // Raw arrays of the node table, see FlatForest::view
+
+    inline const int32_t *treeOffsets() const { return _table.treeOffsets; }
+
+    inline const int32_t *featureIndices() const { return _table.featureIndex; }
+
+    inline const double *thresholds() const { return _table.threshold; }
+
+    inline const int32_t *rightChildren() const { return _table.rightChild; }
+
+    inline const double *leafValues() const { return _table.leafValue; }
+
+    inline const uint32_t *categoryWords() const { return _table.categories; }
+
+    inline size_t numCategoryWords() const { return _table.numCategoryWords; }
+
+    /**
+         * Node table offset of the root of a tree
+         *
+         * @param treeIndex Tree index
+         */
+    inline size_t treeOffset(size_t treeIndex) const { return static_cast<size_t>(_table.treeOffsets[treeIndex]); }
+
+    inline bool isLeaf(size_t node) const { return _table.featureIndex[node] == -1; }
+
+    inline bool isCategorical(size_t node) const { return _table.featureIndex[node] < -1; }
+
+    /**
+         * Split feature of an internal node (numerical or categorical)
+         */
+    inline int32_t featureIndex(size_t node) const
+    {
+        int32_t f = _table.featureIndex[node];
+        return (f < -1) ? -2 - f : f;
+    }
+
+    inline double threshold(size_t node) const { return _table.threshold[node]; }
+
+    inline size_t leftChild(size_t node) const { return node + 1; }
+
+    inline size_t rightChild(size_t node) const
+    {
+        return node + static_cast<size_t>(std::abs(_table.rightChild[node]));
+    }
+
+    /**
+         * Whether samples with a missing value of the split feature of an internal node follow its left branch
+         */
+    inline bool defaultLeft(size_t node) const { return _table.rightChild[node] < 0; }
+
+    inline double leafValue(size_t node) const { return _table.leafValue[node]; }
+
+    /**
+         * Categorical split nodes: bitset of the categories of the left branch, and its number of words
+         */
+    inline const uint32_t *categories(size_t node) const
+    {
+        return _table.categories + static_cast<size_t>(_table.threshold[node]) + 1;
+    }
+
+    inline size_t numCategoryWords(size_t node) const
+    {
+        return _table.categories[static_cast<size_t>(_table.threshold[node])];
+    }
+
+    /**
+         * Return the score of a single tree for a sample
+         *
+         * @param treeIndex Tree index
+         * @param sample Sample features, any type supporting sample[featureIndex]
+         * @return Score of tree
+         */
+    template <typename Sample>
+    inline double scoreTree(size_t treeIndex, const Sample &sample) const
+    {
+        const int32_t *featureIndex = _table.featureIndex;
+        const double *threshold = _table.threshold;
+        const int32_t *rightChild = _table.rightChild;
+
+        int32_t node = _table.treeOffsets[treeIndex], f;
+        while ((f = featureIndex[node]) != -1)
+        {
+            int32_t offset = rightChild[node];
+            bool left;
+            if (f >= 0)
+            {
+                double value = sample[f];
+                left = (value < threshold[node]) || (offset < 0 && std::isnan(value));
+            }
+            else
+            {
+                const uint32_t *set = _table.categories + static_cast<size_t>(threshold[node]);
+                left = CategorySet::contains(set + 1, set[0], sample[-2 - f]);
+            }
+            node += left ? 1 : std::abs(offset);
+        }
+
+        return _table.leafValue[node];
+    }
+
+    /**
+         * Return sum of scores of the first numTrees trees for a sample
+         *
+         * @param sample Sample features, any type supporting sample[featureIndex]
+         * @param numTrees Number of trees to use; all trees if zero
+         * @return Sum of scores
+         */
+    template <typename Sample>
+    double score(const Sample &sample, size_t numTrees) const
+    {
+        numTrees = (numTrees == 0) ? _table.numTrees : std::min(numTrees, _table.numTrees);
+
+        long double score = 0.0;
+        for (size_t t = 0; t < numTrees; t++)
+        {
+            score += scoreTree(t, sample);
+        }
+
+        return (double)score;
+    }
+};
+} // namespace microgbt
@@ -0,0 +1,379 @@
+#pragma once
+#include <memory>
+#include <limits>
+#include <algorithm>
+#include <numeric>
+
+#include "splitter.h"
+#include "../binned_matrix.h"
+#include "../feature_bundles.h"
+
+namespace microgbt
+{
+
+/**
+     * Splitter on pre-binned numerical features
+     *
+     * Instead of scanning every sorted sample, the gradient and Hessian values of a node are accumulated into
+     * per-bin histograms, and only the bin boundaries are considered as split candidates. The histograms are the
+     * node statistics of the splitter, hence the histogram of the larger child of a split is derived by subtracting
+     * the histogram of the smaller child from the one of its parent.
+     */
+template <typename Feature>
+class BasicHistogramSplitter : public BasicSplitter<Feature>
+{
+
+    // Quantized training design matrix, indexed by global row index
+    std::shared_ptr<const BinnedMatrix> _bins;
+
+    // Bundles of the features of _bins, if any: histograms are then accumulated per bundle
+    std::shared_ptr<const FeatureBundles> _bundles;
+
+    // The bins of column c occupy [_binOffsets[c], _binOffsets[c + 1]) of a histogram, where the columns are the
+    // bundles if features are bundled, and the features otherwise
+    VectorT _binOffsets;
+
+    /**
+         * Histogram column of a feature, see _binOffsets
+         */
+    inline size_t histogramColumn(long featureId) const
+    {
+        return _bundles ? _bundles->bundle(featureId) : static_cast<size_t>(featureId);
+    }
+
+    /**
+         * Gradient, Hessian and sample count histograms of a node over all features
+         */
+    class Histogram : public NodeStatistics
+    {
+    public:
+        Vector histG, histH;
+        VectorT counts;
+
+        explicit Histogram(size_t numBins) : histG(numBins, 0.0), histH(numBins, 0.0), counts(numBins, 0) {}
+
+        size_t bytes() const override { return histG.size() * (2 * sizeof(double) + sizeof(size_t)); }
+    };
+
+    /**
+         * Return an empty histogram over all bins: released statistics of the arena if any, otherwise a new one
+         */
+    std::unique_ptr<Histogram> emptyHistogram(ScratchArena *arena) const
+    {
+        std::unique_ptr<Histogram> histogram = arena ? arena->statistics.acquire<Histogram>() : nullptr;
+        if (!histogram)
+        {
+            return std::unique_ptr<Histogram>(new Histogram(_binOffsets.back()));
+        }
+
+        histogram->histG.assign(_binOffsets.back(), 0.0);
+        histogram->histH.assign(_binOffsets.back(), 0.0);
+        histogram->counts.assign(_binOffsets.back(), 0);
+        return histogram;
+    }
+
+    /**
+        * Per-thread scratch histogram of a bundled feature, reused across nodes and features so that evaluating a
+        * bundled feature does not allocate once the histogram has grown
+        */
+    static Histogram &scratch()
+    {
+        static thread_local Histogram histogram(0);
+        return histogram;
+    }
+
+    /**
+        * Returns an optimal binary split over the bin boundaries of a feature histogram.
+        *
+        * @param histG Gradient histogram of the feature
+        * @param histH Hessian histogram of the feature
+        * @param counts Sample count histogram of the feature
+        * @param numBins Number of bins of the feature
+        * @param numRows Number of samples of the node
+        * @param bestBin Output: last bin of the left side of the best split
+        * @return Gain of the best split over all bin boundaries
+        */
+    double optimumGainByBins(const double *histG, const double *histH, const size_t *counts, int numBins,
+                             size_t numRows, int &bestBin) const
+    {
+        double G = std::accumulate(histG, histG + numBins, 0.0);
+        double H = std::accumulate(histH, histH + numBins, 0.0);
+
+        // Scan bin boundaries, skipping those that leave one side empty
+        double bestGain = std::numeric_limits<double>::lowest(), G_l = 0.0, H_l = 0.0;
+        size_t leftCount = 0;
+        bestBin = -1;
+        for (int bin = 0; bin < numBins - 1; bin++)
+        {
+            G_l += histG[bin];
+            H_l += histH[bin];
+            leftCount += counts[bin];
+            if (leftCount == 0 || leftCount == numRows)
+            {
+                continue;
+            }
+
+            double gain = this->calc_split_gain(G, H, G_l, H_l);
+            if (gain > bestGain)
+            {
+                bestGain = gain;
+                bestBin = bin;
+            }
+        }
+
+        return bestGain;
+    }
+
+    /**
+        * Returns an optimal binary split for a given feature index, considering bin boundaries only.
+        *
+        * @param histogram Histogram of the node
+        * @param numRows Number of samples of the node
+        * @param featureId Feature index
+        * @param bestBin Output: last bin of the left side of the best split
+        * @return Gain of the best split over all bin boundaries of feature with featureId
+        */
+    double optimumGainByFeature(const Histogram &histogram,
+                                size_t numRows,
+                                long featureId,
+                                int &bestBin) const
+    {
+        int numBins = _bins->numBins(featureId);
+        size_t offset = _binOffsets[histogramColumn(featureId)];
+        if (!_bundles || !_bundles->isBundled(featureId))
+        {
+            return optimumGainByBins(histogram.histG.data() + offset, histogram.histH.data() + offset,
+                                     histogram.counts.data() + offset, numBins, numRows, bestBin);
+        }
+
+        // The non-default bins of a bundled feature are a range of the bins of its bundle, and its default bin
+        // holds the remaining samples of the node
+        size_t numBundleBins = static_cast<size_t>(_bundles->numBins(_bundles->bundle(featureId)));
+        const double *bundleG = histogram.histG.data() + offset, *bundleH = histogram.histH.data() + offset;
+        const size_t *bundleCounts = histogram.counts.data() + offset;
+        double G = std::accumulate(bundleG, bundleG + numBundleBins, 0.0);
+        double H = std::accumulate(bundleH, bundleH + numBundleBins, 0.0);
+
+        int defaultBin = _bundles->defaultBin(featureId);
+        Histogram &featureHistogram = scratch();
+        Vector &histG = featureHistogram.histG, &histH = featureHistogram.histH;
+        VectorT &counts = featureHistogram.counts;
+        histG.assign(static_cast<size_t>(numBins), 0.0);
+        histH.assign(static_cast<size_t>(numBins), 0.0);
+        counts.assign(static_cast<size_t>(numBins), 0);
+        size_t defaultCount = numRows;
+        for (int bin = 0, k = _bundles->binOffset(featureId); bin < numBins; bin++)
+        {
+            if (bin != defaultBin)
+            {
+                histG[bin] = bundleG[k];
+                histH[bin] = bundleH[k];
+                counts[bin] = bundleCounts[k];
+                G -= histG[bin];
+                H -= histH[bin];
+                defaultCount -= counts[bin];
+                k++;
+            }
+        }
+        histG[defaultBin] = G;
+        histH[defaultBin] = H;
+        counts[defaultBin] = defaultCount;
+
+        return optimumGainByBins(histG.data(), histH.data(), counts.data(), numBins, numRows, bestBin);
+    }
+
+public:
+    /**
+         * @param lambda Regularization parameter
+         * @param bins Quantized training design matrix
+         * @param threadPool Optional thread pool on which features are evaluated in parallel
+         * @param bundles Optional bundles of the features of bins (see FeatureBundles)
+         */
+    BasicHistogramSplitter(double lambda, std::shared_ptr<const BinnedMatrix> bins, std::shared_ptr<ThreadPool> threadPool = nullptr,
+                           std::shared_ptr<const FeatureBundles> bundles = nullptr)
+        : BasicSplitter<Feature>(lambda, std::move(threadPool)), _bins(std::move(bins)), _bundles(std::move(bundles))
+    {
+        size_t numColumns = _bundles ? _bundles->numBundles() : static_cast<size_t>(_bins->numFeatures());
+        _binOffsets.assign(numColumns + 1, 0);
+        for (size_t column = 0; column < numColumns; column++)
+        {
+            int numBins = _bundles ? _bundles->numBins(column) : _bins->numBins(static_cast<long>(column));
+            _binOffsets[column + 1] = _binOffsets[column] + static_cast<size_t>(numBins);
+        }
+    }
+
+    using BasicSplitter<Feature>::findBestSplit;
+
+    /**
+         * Accumulate the gradient, Hessian and sample counts of a dataset per feature (or bundle) and bin; the bins
+         * of the features outside dataset.features() remain empty
+         */
+    std::unique_ptr<NodeStatistics> statistics(const BasicDataset<Feature> &trainSet,
+                                               const Vector &gradient,
+                                               const Vector &hessian,
+                                               ScratchArena *arena = nullptr) const override
+    {
+        std::unique_ptr<Histogram> histogram = emptyHistogram(arena);
+        const VectorT &rowIndices = trainSet.rowIter();
+
+        // Every feature fills its own bins, hence features are accumulated in parallel. Rows (in increasing
+        // order) are processed in blocks: for memory-mapped bins, the next block is read ahead while the current
+        // one is accumulated, and the current one is released afterwards. Bundled features are accumulated once
+        // per bundle
+        PooledBuffer<VectorT> columnsBuffer(arena ? &arena->indices : nullptr, trainSet.features().size());
+        VectorT &columns = *columnsBuffer;
+        std::copy(trainSet.features().begin(), trainSet.features().end(), columns.begin());
+        if (_bundles)
+        {
+            for (size_t &column : columns)
+            {
+                column = _bundles->bundle(static_cast<long>(column));
+            }
+            std::sort(columns.begin(), columns.end());
+            columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+        }
+        size_t numRows = rowIndices.size();
+        Histogram &accumulated = *histogram;
+        this->forEachFeature(static_cast<long>(columns.size()), [&](size_t k) {
+            size_t column = columns[k];
+            const uint8_t *codes = _bundles ? _bundles->column(column) : _bins->column(column);
+            double *histG = accumulated.histG.data() + _binOffsets[column];
+            double *histH = accumulated.histH.data() + _binOffsets[column];
+            size_t *counts = accumulated.counts.data() + _binOffsets[column];
+            for (size_t begin = 0; begin < numRows; begin += BinnedMatrix::BlockRows)
+            {
+                size_t end = std::min(begin + BinnedMatrix::BlockRows, numRows);
+                // Columns of bundles are bundle indices, and bundled bins are held in memory (see FeatureBundles)
+                if (end < numRows && !_bundles)
+                {
+                    _bins->prefetch(column, rowIndices[end],
+                                    rowIndices[std::min(end + BinnedMatrix::BlockRows, numRows) - 1]);
+                }
+
+                for (size_t i = begin; i < end; i++)
+                {
+                    uint8_t bin = codes[rowIndices[i]];
+                    histG[bin] += gradient[i];
+                    histH[bin] += hessian[i];
+                    counts[bin]++;
+                }
+
+                if (!_bundles)
+                {
+                    _bins->release(column, rowIndices[begin], rowIndices[end - 1]);
+                }
+            }
+        });
+
+        return std::unique_ptr<NodeStatistics>(std::move(histogram));
+    }
+
+    /**
+         * Histogram of a child node, i.e., the histogram of its parent minus the histogram of its sibling
+         */
+    std::unique_ptr<NodeStatistics> subtract(const NodeStatistics &parent,
+                                             const NodeStatistics &sibling,
+                                             ScratchArena *arena = nullptr) const override
+    {
+        const Histogram &parentHistogram = static_cast<const Histogram &>(parent);
+        const Histogram &siblingHistogram = static_cast<const Histogram &>(sibling);
+
+        std::unique_ptr<Histogram> histogram = emptyHistogram(arena);
+        for (size_t bin = 0; bin < _binOffsets.back(); bin++)
+        {
+            histogram->histG[bin] = parentHistogram.histG[bin] - siblingHistogram.histG[bin];
+            histogram->histH[bin] = parentHistogram.histH[bin] - siblingHistogram.histH[bin];
+            histogram->counts[bin] = parentHistogram.counts[bin] - siblingHistogram.counts[bin];
+        }
+
+        return std::unique_ptr<NodeStatistics>(std::move(histogram));
+    }
+
+    SplitInfo findBestSplit(const BasicDataset<Feature> &trainSet,
+                            const Vector &gradient,
+                            const Vector &hessian,
+                            const VectorT &features,
+                            ScratchArena *arena = nullptr) const override
+    {
+        std::unique_ptr<NodeStatistics> nodeStatistics = statistics(trainSet, gradient, hessian, arena);
+        SplitInfo split = findBestSplitFromStatistics(trainSet, gradient, hessian, features, *nodeStatistics, arena);
+        if (arena)
+        {
+            arena->statistics.release(std::move(nodeStatistics));
+        }
+        return split;
+    }
+
+    SplitInfo findBestSplitFromStatistics(const BasicDataset<Feature> &trainSet,
+                                          const Vector &gradient,
+                                          const Vector &hessian,
+                                          const VectorT &features,
+                                          const NodeStatistics &statistics,
+                                          ScratchArena *arena = nullptr) const override
+    {
+        const Histogram &histogram = static_cast<const Histogram &>(statistics);
+        long numFeatures = static_cast<long>(features.size());
+        const VectorT &rowIndices = trainSet.rowIter();
+
+        // Evaluate features (possibly in parallel), then reduce in feature order so that the result
+        // does not depend on the number of threads
+        PooledBuffer<Vector> gainBuffer(arena ? &arena->values : nullptr, features.size());
+        PooledBuffer<std::vector<int>> binBuffer(arena ? &arena->ints : nullptr, features.size());
+        Vector &gainPerFeature = *gainBuffer;
+        std::vector<int> &binPerFeature = *binBuffer;
+        this->forEachFeature(numFeatures, [&](size_t k) {
+            gainPerFeature[k] = optimumGainByFeature(histogram, rowIndices.size(), features[k], binPerFeature[k]);
+        });
+
+        double bestGain = std::numeric_limits<double>::lowest();
+        long bestFeatureId = -1;
+        int bestBin = -1;
+        for (long k = 0; k < numFeatures; k++)
+        {
+            if (binPerFeature[k] >= 0 && gainPerFeature[k] > bestGain)
+            {
+                bestGain = gainPerFeature[k];
+                bestFeatureId = static_cast<long>(features[k]);
+                bestBin = binPerFeature[k];
+            }
+        }
+
+        if (bestFeatureId < 0)
+        {
+            return SplitInfo(bestGain, 0.0);
+        }
+
+        // Materialize the partition of the winning feature only: left samples first, then right samples
+        const uint8_t *codes = _bins->column(bestFeatureId);
+        PooledBuffer<std::vector<int>> partition(arena ? &arena->ints : nullptr, rowIndices.size());
+        long left = 0;
+        double leftG = 0.0, leftH = 0.0, rightG = 0.0, rightH = 0.0;
+        for (size_t i = 0; i < rowIndices.size(); i++)
+        {
+            if (codes[rowIndices[i]] <= bestBin)
+            {
+                (*partition)[left++] = static_cast<int>(i);
+                leftG += gradient[i];
+                leftH += hessian[i];
+            }
+        }
+        for (size_t i = 0, k = static_cast<size_t>(left); i < rowIndices.size(); i++)
+        {
+            if (codes[rowIndices[i]] > bestBin)
+            {
+                (*partition)[k++] = static_cast<int>(i);
+                rightG += gradient[i];
+                rightH += hessian[i];
+            }
+        }
+
+        SplitInfo bestSplitInfo(std::move(partition), bestGain, _bins->threshold(bestFeatureId, bestBin), left);
+        bestSplitInfo.setSides(leftG, leftH, static_cast<size_t>(left), rightG, rightH,
+                               rowIndices.size() - static_cast<size_t>(left));
+        bestSplitInfo.setBestFeatureId(bestFeatureId);
+        return bestSplitInfo;
+    }
+};
+
+using HistogramSplitter = BasicHistogramSplitter<double>;
+} // Namespace microgbt
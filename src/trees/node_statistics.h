@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+
+namespace microgbt
+{
+
+/**
+     * Statistics of the samples of a tree node that a splitter accumulates to find its best split, e.g., per-bin
+     * gradient and Hessian histograms.
+     *
+     * Statistics are additive over samples, hence the statistics of a child node are derived from the ones of its
+     * parent and its sibling by subtraction.
+     */
+class NodeStatistics
+{
+public:
+    virtual ~NodeStatistics() = default;
+
+    /**
+         * Number of bytes allocated for the statistics
+         */
+    virtual size_t bytes() const = 0;
+};
+} // namespace microgbt
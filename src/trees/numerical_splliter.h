@@ -1,67 +1,184 @@
 #pragma once
+#include <limits>
+#include <cmath>
+#include <numeric>
+#include <vector>
+#include <algorithm>
+
 #include "splitter.h"
+#include "category_set.h"
 
 namespace microgbt
 {
 
 /**
-     * Splitter on numerical features
+     * Splitter on numerical and categorical features
      */
-class NumericalSplitter : public Splitter
+template <typename Feature>
+class BasicNumericalSplitter : public BasicSplitter<Feature>
 {
 
-    // Regularization parameter of xgboost
-    double _lambda;
+    // Whether each feature is categorical, see categoricalOptimumGainByFeature; features beyond its size are numerical
+    std::vector<bool> _categorical;
 
     /**
-        * Returns objective value for a given gradient, hessian and lambda value
+        * Per-thread scratch buffer of split finding (e.g., cumulative sums of gradients), reused across nodes and
+        * features so that evaluating a feature does not allocate once the buffer has grown
         *
-        * @param gradient Gradient value
-        * @param hessian Hessian value
-        * @return
+        * @param index Index of the buffer, 0 or 1
+        */
+    static Vector &scratch(size_t index)
+    {
+        static thread_local Vector buffers[2];
+        return buffers[index];
+    }
+
+    /**
+        * Per-thread buffer of the candidate splits of the features of a node; evaluations on other threads must
+        * access it through a reference of the calling thread
         */
-    constexpr double objective(double gradient, double hessian) const
+    static std::vector<SplitInfo> &candidates()
     {
-        return (gradient * gradient) / (hessian + _lambda);
+        static thread_local std::vector<SplitInfo> splits;
+        return splits;
     }
 
     /**
-        * Returns gain difference of a specific binary tree split.
+        * Per-thread mask over the samples of a node (e.g., whether a sample has a stored value), reused across nodes
+        * so that materializing a partition does not allocate once the mask has grown
+        */
+    static std::vector<bool> &mask()
+    {
+        static thread_local std::vector<bool> samples;
+        return samples;
+    }
+
+    /**
+        * Returns the best boundary of the sorted non-missing values of a feature.
+        *
+        * Candidate splits are the boundaries between distinct values, with the missing values on the right side or
+        * on the left side (in this order), and the split of the missing values from all the others. Without missing
+        * values, only the right side is considered, i.e., the default direction is right.
         *
-        * Refer to Eq7 of Reference [1]
+        * Refer to "XGBoost: A Scalable Tree Boosting System", KDD 2016 (Algorithm 3, sparsity-aware split finding)
         *
-        * @param G Gradient on node before the split applied
-        * @param H Hessian on node before the split applied
-        * @param G_l Gradient on left split node
-        * @param H_l Hesssian on left split node
-        * @return Gain on split, i.e., reduction on objective value
+        * @param cumG Cumulative sums of gradients of the sorted values, at least numPresent of them
+        * @param cumH Cumulative sums of Hessians of the sorted values, at least numPresent of them
+        * @param numPresent Number of non-missing values
+        * @param sumG Sum of gradients of all samples, including the ones with a missing value
+        * @param sumH Sum of Hessians of all samples, including the ones with a missing value
+        * @param hasMissing Whether some samples have a missing value
+        * @param distinct distinct(i) is true if the i-th and (i+1)-th smallest values differ
+        * @param bestSortedIndex Output: number of sorted values on the left side of the best split
+        * @param defaultLeft Output: whether missing values are on the left side of the best split
+        * @return Best gain, or std::numeric_limits<double>::lowest() if there is no candidate split
         */
-    constexpr double calc_split_gain(double G, double H, double G_l, double H_l) const
+    template <typename Distinct>
+    double bestBoundary(const Vector &cumG, const Vector &cumH, size_t numPresent, double sumG, double sumH,
+                        bool hasMissing, const Distinct &distinct, size_t &bestSortedIndex, bool &defaultLeft) const
     {
-        return objective(G_l, H_l) + objective(G - G_l, H - H_l) - objective(G, H) / 2.0; // TODO: minus \gamma
+        double bestGain = std::numeric_limits<double>::lowest(), missingG = 0.0, missingH = 0.0;
+        bestSortedIndex = 1;
+        defaultLeft = false;
+
+        if (hasMissing && numPresent > 0)
+        {
+            missingG = sumG - cumG[numPresent - 1];
+            missingH = sumH - cumH[numPresent - 1];
+            bestGain = this->calc_split_gain(sumG, sumH, missingG, missingH);
+            bestSortedIndex = 0;
+            defaultLeft = true;
+        }
+
+        // Splits are only considered between distinct feature values, so that the partition of the samples
+        // agrees with the "x < split value" test of TreeNode::score
+        for (size_t i = 0; i + 1 < numPresent; i++)
+        {
+            if (!distinct(i))
+            {
+                continue;
+            }
+
+            double gain = this->calc_split_gain(sumG, sumH, cumG[i], cumH[i]);
+            if (gain > bestGain)
+            {
+                bestGain = gain;
+                bestSortedIndex = i + 1;
+                defaultLeft = false;
+            }
+
+            if (hasMissing)
+            {
+                gain = this->calc_split_gain(sumG, sumH, cumG[i] + missingG, cumH[i] + missingH);
+                if (gain > bestGain)
+                {
+                    bestGain = gain;
+                    bestSortedIndex = i + 1;
+                    defaultLeft = true;
+                }
+            }
+        }
+
+        return bestGain;
+    }
+
+    /**
+        * Returns the compact record of a boundary of bestBoundary, i.e., its gain, split value, and the sums and
+        * counts of both sides, whose partition is not materialized
+        *
+        * @param cumG Cumulative sums of gradients of the sorted values, at least numPresent of them
+        * @param cumH Cumulative sums of Hessians of the sorted values, at least numPresent of them
+        * @param numPresent Number of non-missing values
+        * @param numRows Number of samples, including the ones with a missing value
+        * @param sumG Sum of gradients of all samples
+        * @param sumH Sum of Hessians of all samples
+        * @param gain Gain of the boundary
+        * @param splitValue Split value of the boundary
+        * @param bestSortedIndex Number of sorted values on the left side, at most numPresent
+        * @param defaultLeft Whether missing values are on the left side
+        */
+    SplitInfo boundarySplit(const Vector &cumG, const Vector &cumH, size_t numPresent, size_t numRows, double sumG,
+                            double sumH, double gain, double splitValue, size_t bestSortedIndex,
+                            bool defaultLeft) const
+    {
+        double leftG = (bestSortedIndex > 0) ? cumG[bestSortedIndex - 1] : 0.0;
+        double leftH = (bestSortedIndex > 0) ? cumH[bestSortedIndex - 1] : 0.0;
+        size_t leftCount = bestSortedIndex;
+        if (defaultLeft)
+        {
+            leftG += sumG - ((numPresent > 0) ? cumG[numPresent - 1] : 0.0);
+            leftH += sumH - ((numPresent > 0) ? cumH[numPresent - 1] : 0.0);
+            leftCount += numRows - numPresent;
+        }
+
+        SplitInfo split(gain, splitValue, bestSortedIndex, defaultLeft);
+        split.setSides(leftG, leftH, leftCount, sumG - leftG, sumH - leftH, numRows - leftCount);
+        return split;
     }
 
     /**
-        * Returns an optimal binary split for a given feature index of a Dataset.
+        * Returns an optimal binary split for a given feature index of a Dataset, whose partition is not
+        * materialized (see densePartition).
         *
         * @param dataset Input dataset
-        * @param previousPreds
         * @param gradient Gradient vector
         * @param hessian Hessian vector
         * @param featureId Feature index
         * @return Best split over all possible splits of feature with featureId
         */
-    SplitInfo optimumGainByFeature(const Dataset &dataset,
+    SplitInfo optimumGainByFeature(const BasicDataset<Feature> &dataset,
                                    const Vector &gradient,
                                    const Vector &hessian,
                                    long featureId) const
     {
 
         // Sort the feature by value and return permutation of indices (i.e., argsort)
-        const Eigen::RowVectorXi &sortedInstanceIds = dataset.sortedColumnIndices(featureId);
+        SortedIndices sortedInstanceIds = dataset.sortedColumnIndices(featureId);
 
         // Cummulative sum of gradients and Hessian
-        Vector cum_sum_G(dataset.nRows()), cum_sum_H(dataset.nRows());
+        Vector &cum_sum_G = scratch(0), &cum_sum_H = scratch(1);
+        cum_sum_G.resize(dataset.nRows());
+        cum_sum_H.resize(dataset.nRows());
         double cum_sum_g = 0.0, cum_sum_h = 0.0;
         for (long i = 0; i < dataset.nRows(); i++)
         {
@@ -72,53 +189,374 @@ class NumericalSplitter : public Splitter
             cum_sum_H[i] = cum_sum_h;
         }
 
-        // For each feature, compute split gain and keep the split index with maximum gain
-        Vector gainPerOrderedSampleIndex(dataset.nRows());
-        for (long i = 0; i < dataset.nRows(); i++)
+        // Missing (NaN) values are sorted last
+        long numPresent = dataset.nRows();
+        while (numPresent > 0 && std::isnan(dataset.value(sortedInstanceIds[numPresent - 1], featureId)))
         {
-            gainPerOrderedSampleIndex[i] = calc_split_gain(cum_sum_g, cum_sum_h, cum_sum_G[i], cum_sum_H[i]);
+            numPresent--;
         }
 
-        long bestGainIndex =
-            std::max_element(gainPerOrderedSampleIndex.begin(), gainPerOrderedSampleIndex.end()) - gainPerOrderedSampleIndex.begin();
-        double bestGain = gainPerOrderedSampleIndex[bestGainIndex];
-        double bestSplitNumericValue = dataset.row(sortedInstanceIds[bestGainIndex])[featureId];
-        long bestSortedIndex = bestGainIndex + 1;
+        size_t bestSortedIndex;
+        bool defaultLeft;
+        double bestGain = bestBoundary(cum_sum_G, cum_sum_H, static_cast<size_t>(numPresent), cum_sum_g, cum_sum_h,
+                                       numPresent < dataset.nRows(),
+                                       [&](size_t i) {
+                                           return dataset.value(sortedInstanceIds[i], featureId) <
+                                                  dataset.value(sortedInstanceIds[i + 1], featureId);
+                                       },
+                                       bestSortedIndex, defaultLeft);
 
-        return SplitInfo(sortedInstanceIds, bestGain, bestSplitNumericValue, bestSortedIndex);
+        // The split value is the smallest feature value on the right side of the split (for quantized storage,
+        // the lower boundary of its code, so that unquantized samples follow the same branch as their codes)
+        double bestSplitNumericValue = dataset.splitValue(sortedInstanceIds[std::min(static_cast<long>(bestSortedIndex), dataset.nRows() - 1)], featureId);
+
+        // Without candidate split (e.g., all values are missing), bestSortedIndex may exceed numPresent
+        bestSortedIndex = std::min(bestSortedIndex, static_cast<size_t>(numPresent));
+        return boundarySplit(cum_sum_G, cum_sum_H, static_cast<size_t>(numPresent), static_cast<size_t>(dataset.nRows()),
+                             cum_sum_g, cum_sum_h, bestGain, bestSplitNumericValue, bestSortedIndex, defaultLeft);
+    }
+
+    /**
+        * Materialize the partition of the samples of a dataset by a split of optimumGainByFeature, in a buffer of an arena if any
+        */
+    SplitInfo densePartition(const BasicDataset<Feature> &dataset, SplitInfo split, long featureId,
+                             ScratchArena *arena) const
+    {
+        SortedIndices sortedInstanceIds = dataset.sortedColumnIndices(featureId);
+        const int *sorted = sortedInstanceIds.data();
+        PooledBuffer<std::vector<int>> partition(arena ? &arena->ints : nullptr, static_cast<size_t>(dataset.nRows()));
+        split.setBestFeatureId(featureId);
+        if (!split.defaultLeft())
+        {
+            std::copy(sorted, sorted + dataset.nRows(), partition->data());
+            split.setPartition(std::move(partition));
+            return split;
+        }
+
+        // Samples with a missing value (sorted last) are moved between the left and right side
+        long left = static_cast<long>(split.bestSortedIndex());
+        long numMissing = static_cast<long>(split.count(SplitInfo::Side::Left)) - left;
+        long numPresent = dataset.nRows() - numMissing;
+        int *out = std::copy(sorted, sorted + left, partition->data());
+        out = std::copy(sorted + numPresent, sorted + dataset.nRows(), out);
+        std::copy(sorted + left, sorted + numPresent, out);
+        split.setPartition(std::move(partition));
+        return split;
+    }
+
+    /**
+        * Returns an optimal binary split for a given feature index of a sparse Dataset, whose partition is not
+        * materialized (see sparsePartition), in time linear in the number of stored values of the feature
+        *
+        * @param dataset Input sparse dataset
+        * @param gradient Gradient vector
+        * @param hessian Hessian vector
+        * @param sumG Sum of gradients of the dataset
+        * @param sumH Sum of Hessians of the dataset
+        * @param featureId Feature index
+        */
+    SplitInfo sparseOptimumGainByFeature(const BasicDataset<Feature> &dataset,
+                                         const Vector &gradient,
+                                         const Vector &hessian,
+                                         double sumG, double sumH,
+                                         long featureId) const
+    {
+        size_t numPresent = dataset.numStoredValues(featureId);
+        const int *rows = dataset.storedRows(featureId);
+
+        Vector &cumG = scratch(0), &cumH = scratch(1);
+        cumG.resize(numPresent);
+        cumH.resize(numPresent);
+        double g = 0.0, h = 0.0;
+        for (size_t i = 0; i < numPresent; i++)
+        {
+            g += gradient[rows[i]];
+            h += hessian[rows[i]];
+            cumG[i] = g;
+            cumH[i] = h;
+        }
+
+        size_t bestSortedIndex;
+        bool defaultLeft;
+        double bestGain = bestBoundary(cumG, cumH, numPresent, sumG, sumH,
+                                       numPresent < static_cast<size_t>(dataset.nRows()),
+                                       [&](size_t i) {
+                                           return dataset.storedValue(featureId, i) <
+                                                  dataset.storedValue(featureId, i + 1);
+                                       },
+                                       bestSortedIndex, defaultLeft);
+
+        // Without candidate split (e.g., no stored value), bestSortedIndex may exceed numPresent
+        bestSortedIndex = std::min(bestSortedIndex, numPresent);
+        double splitValue = (bestSortedIndex < numPresent) ? dataset.storedValue(featureId, bestSortedIndex) : 0.0;
+        return boundarySplit(cumG, cumH, numPresent, static_cast<size_t>(dataset.nRows()), sumG, sumH, bestGain,
+                             splitValue, bestSortedIndex, defaultLeft);
+    }
+
+    /**
+        * Materialize the partition of the samples of a sparse dataset by a split of sparseOptimumGainByFeature, in a buffer of an arena if any
+        */
+    SplitInfo sparsePartition(const BasicDataset<Feature> &dataset, SplitInfo split, long featureId,
+                              ScratchArena *arena) const
+    {
+        size_t numPresent = dataset.numStoredValues(featureId), left = split.bestSortedIndex();
+        const int *rows = dataset.storedRows(featureId);
+
+        std::vector<bool> &isPresent = mask();
+        isPresent.assign(static_cast<size_t>(dataset.nRows()), false);
+        for (size_t i = 0; i < numPresent; i++)
+        {
+            isPresent[rows[i]] = true;
+        }
+
+        PooledBuffer<std::vector<int>> partition(arena ? &arena->ints : nullptr, static_cast<size_t>(dataset.nRows()));
+        long size = 0;
+        auto appendMissing = [&]() {
+            for (long i = 0; i < dataset.nRows(); i++)
+            {
+                if (!isPresent[i])
+                {
+                    (*partition)[size++] = static_cast<int>(i);
+                }
+            }
+        };
+
+        std::copy(rows, rows + left, partition->data());
+        size = static_cast<long>(left);
+        if (split.defaultLeft())
+        {
+            appendMissing();
+        }
+        std::copy(rows + left, rows + numPresent, partition->data() + size);
+        size += static_cast<long>(numPresent - left);
+        if (!split.defaultLeft())
+        {
+            appendMissing();
+        }
+
+        split.setPartition(std::move(partition));
+        split.setBestFeatureId(featureId);
+        return split;
+    }
+
+    /**
+        * Returns an optimal split of the categories of a categorical feature into two sets, whose partition is not
+        * materialized (see categoricalPartition).
+        *
+        * The categories present in the dataset are sorted by the ratio of their gradient and Hessian sums, and the
+        * candidate splits are the prefixes of this order versus the remaining categories, i.e., k - 1 candidates
+        * for k categories instead of 2^(k - 1) - 1. Samples without a category (missing, negative or too large
+        * values, see CategorySet) follow the right side.
+        *
+        * Refer to "LightGBM: A Highly Efficient Gradient Boosting Decision Tree", NIPS 2017 (categorical features)
+        * and Fisher, "On Grouping for Maximum Homogeneity", JASA 1958
+        *
+        * @param numValues Number of sorted feature values of the dataset (including missing values, sorted last)
+        * @param rowAt rowAt(i) is the local row index of the i-th smallest value
+        * @param valueAt valueAt(i) is the i-th smallest value
+        * @param gradient Gradient vector
+        * @param hessian Hessian vector
+        * @param numRows Number of rows of the dataset
+        * @param sumG Sum of gradients of the dataset
+        * @param sumH Sum of Hessians of the dataset
+        */
+    template <typename RowAt, typename ValueAt>
+    SplitInfo categoricalOptimumGainByFeature(size_t numValues, const RowAt &rowAt, const ValueAt &valueAt,
+                                              const Vector &gradient, const Vector &hessian,
+                                              size_t numRows, double sumG, double sumH) const
+    {
+        struct Category
+        {
+            long category;
+            double g, h;
+            size_t count;
+        };
+
+        // Sorted values group the samples of every category
+        static thread_local std::vector<Category> categories;
+        categories.clear();
+        size_t numCategorized = 0;
+        for (size_t i = 0; i < numValues; i++)
+        {
+            long c = CategorySet::category(valueAt(i));
+            if (c < 0)
+            {
+                continue;
+            }
+            if (categories.empty() || categories.back().category != c)
+            {
+                categories.push_back(Category{c, 0.0, 0.0, 0});
+            }
+            size_t row = rowAt(i);
+            categories.back().g += gradient[row];
+            categories.back().h += hessian[row];
+            categories.back().count++;
+            numCategorized++;
+        }
+
+        double lambda = this->_lambda;
+        std::stable_sort(categories.begin(), categories.end(), [lambda](const Category &a, const Category &b) {
+            return a.g / (a.h + lambda) < b.g / (b.h + lambda);
+        });
+
+        // All categories versus the samples without a category is a candidate only if there are such samples
+        size_t numCandidates = categories.size() - ((numCategorized == numRows && !categories.empty()) ? 1 : 0);
+        double bestGain = std::numeric_limits<double>::lowest(), leftG = 0.0, leftH = 0.0;
+        double bestLeftG = 0.0, bestLeftH = 0.0;
+        size_t bestPrefix = 0, leftCount = 0, bestLeftCount = 0;
+        for (size_t k = 0; k < numCandidates; k++)
+        {
+            leftG += categories[k].g;
+            leftH += categories[k].h;
+            leftCount += categories[k].count;
+            double gain = this->calc_split_gain(sumG, sumH, leftG, leftH);
+            if (gain > bestGain)
+            {
+                bestGain = gain;
+                bestPrefix = k + 1;
+                bestLeftG = leftG;
+                bestLeftH = leftH;
+                bestLeftCount = leftCount;
+            }
+        }
+
+        std::vector<long> leftCategories;
+        for (size_t k = 0; k < bestPrefix; k++)
+        {
+            leftCategories.push_back(categories[k].category);
+        }
+        SplitInfo split(bestGain, 0.0, bestLeftCount, false);
+        split.setCategories(CategorySet::bitset(leftCategories));
+        split.setSides(bestLeftG, bestLeftH, bestLeftCount, sumG - bestLeftG, sumH - bestLeftH,
+                       numRows - bestLeftCount);
+        return split;
+    }
+
+    /**
+        * Materialize the partition of the samples of a dataset by a split of categoricalOptimumGainByFeature, in a buffer of an arena if any
+        */
+    SplitInfo categoricalPartition(const BasicDataset<Feature> &dataset, SplitInfo split, long featureId,
+                                   ScratchArena *arena) const
+    {
+        const std::vector<uint32_t> &categories = split.categories();
+        std::vector<bool> &isLeft = mask();
+        isLeft.assign(static_cast<size_t>(dataset.nRows()), false);
+        if (dataset.isSparse())
+        {
+            const int *rows = dataset.storedRows(featureId);
+            for (size_t i = 0; i < dataset.numStoredValues(featureId); i++)
+            {
+                isLeft[rows[i]] = CategorySet::contains(categories.data(), categories.size(),
+                                                        dataset.storedValue(featureId, i));
+            }
+        }
+        else
+        {
+            for (long i = 0; i < dataset.nRows(); i++)
+            {
+                isLeft[i] = CategorySet::contains(categories.data(), categories.size(), dataset.value(i, featureId));
+            }
+        }
+
+        PooledBuffer<std::vector<int>> partition(arena ? &arena->ints : nullptr, static_cast<size_t>(dataset.nRows()));
+        long size = 0;
+        for (bool side : {true, false})
+        {
+            for (long i = 0; i < dataset.nRows(); i++)
+            {
+                if (isLeft[i] == side)
+                {
+                    (*partition)[size++] = static_cast<int>(i);
+                }
+            }
+        }
+
+        split.setPartition(std::move(partition));
+        split.setBestFeatureId(featureId);
+        return split;
     }
 
 public:
-    explicit NumericalSplitter(double lambda)
+    /**
+         * @param lambda Regularization parameter
+         * @param threadPool Optional thread pool on which features are evaluated in parallel
+         * @param categorical Whether each feature is categorical; features beyond its size are numerical
+         */
+    explicit BasicNumericalSplitter(double lambda, std::shared_ptr<ThreadPool> threadPool = nullptr,
+                                    std::vector<bool> categorical = std::vector<bool>())
+        : BasicSplitter<Feature>(lambda, std::move(threadPool)), _categorical(std::move(categorical)) {}
+
+    inline bool isCategorical(long featureId) const
     {
-        _lambda = lambda;
+        return static_cast<size_t>(featureId) < _categorical.size() && _categorical[featureId];
     }
 
-    SplitInfo findBestSplit(const Dataset &trainSet,
+    using BasicSplitter<Feature>::findBestSplit;
+
+    SplitInfo findBestSplit(const BasicDataset<Feature> &trainSet,
                             const Vector &gradient,
-                            const Vector &hessian) const override
+                            const Vector &hessian,
+                            const VectorT &features,
+                            ScratchArena *arena = nullptr) const override
     {
 
-        long numFeatures = trainSet.numFeatures();
+        long numFeatures = static_cast<long>(features.size());
 
-        // 1) For each tree node, enumerate over all features:
+        // 1) For each tree node, enumerate over the candidate features:
         // 2) For each feature, sorted the instances by feature numeric value
-        //    - Compute gain for every feature (column of design matrix)
-        std::vector<SplitInfo> gainPerFeature(numFeatures);
-        for (long featureId = 0; featureId < numFeatures; featureId++)
+        //    - Compute gain for every feature (column of design matrix), possibly in parallel, into compact
+        //      records without partition (a buffer of the calling thread, reused across nodes)
+        std::vector<SplitInfo> &gainPerFeature = candidates();
+        gainPerFeature.clear();
+        gainPerFeature.resize(static_cast<size_t>(numFeatures));
+        double sumG = std::accumulate(gradient.begin(), gradient.end(), 0.0);
+        double sumH = std::accumulate(hessian.begin(), hessian.end(), 0.0);
+        size_t numRows = static_cast<size_t>(trainSet.nRows());
+        if (trainSet.isSparse())
+        {
+            this->forEachFeature(numFeatures, [&](size_t k) {
+                long f = features[k];
+                const int *rows = trainSet.storedRows(f);
+                gainPerFeature[k] = isCategorical(f)
+                                        ? categoricalOptimumGainByFeature(
+                                              trainSet.numStoredValues(f), [rows](size_t i) { return rows[i]; },
+                                              [&trainSet, f](size_t i) { return trainSet.storedValue(f, i); },
+                                              gradient, hessian, numRows, sumG, sumH)
+                                        : sparseOptimumGainByFeature(trainSet, gradient, hessian, sumG, sumH, f);
+            });
+        }
+        else
         {
-            gainPerFeature[featureId] = optimumGainByFeature(trainSet, gradient, hessian, featureId);
+            this->forEachFeature(numFeatures, [&](size_t k) {
+                long f = features[k];
+                if (!isCategorical(f))
+                {
+                    gainPerFeature[k] = optimumGainByFeature(trainSet, gradient, hessian, f);
+                    return;
+                }
+                SortedIndices sorted = trainSet.sortedColumnIndices(f);
+                gainPerFeature[k] = categoricalOptimumGainByFeature(
+                    numRows, [&sorted](size_t i) { return sorted[i]; },
+                    [&trainSet, &sorted, f](size_t i) { return trainSet.value(sorted[i], f); },
+                    gradient, hessian, numRows, sumG, sumH);
+            });
         }
 
         // 3) Use a linear scan to decide the best split along that feature
         // 4) Take the best split solution (that maximises gain reduction) over all features
-        long bestFeatureId =
-            std::max_element(gainPerFeature.begin(), gainPerFeature.end()) - gainPerFeature.begin();
-        SplitInfo bestSplitInfo = gainPerFeature[bestFeatureId];
-
-        bestSplitInfo.setBestFeatureId(bestFeatureId);
-
-        return bestSplitInfo;
+        // 5) Materialize the partition of the winning feature only
+        long best = std::max_element(gainPerFeature.begin(), gainPerFeature.end()) - gainPerFeature.begin();
+        if (isCategorical(features[best]))
+        {
+            return categoricalPartition(trainSet, std::move(gainPerFeature[best]), features[best], arena);
+        }
+        if (trainSet.isSparse())
+        {
+            return sparsePartition(trainSet, std::move(gainPerFeature[best]), features[best], arena);
+        }
+        return densePartition(trainSet, std::move(gainPerFeature[best]), features[best], arena);
     }
 };
+
+using NumericalSplitter = BasicNumericalSplitter<double>;
 } // Namespace microgbt
\ No newline at end of file
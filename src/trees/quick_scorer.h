@@ -0,0 +1,246 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+#include "flat_forest.h"
+
+namespace microgbt
+{
+
+/**
+     * QuickScorer is an inference engine for ensembles of shallow trees with at most 64 leaves each.
+     *
+     * Instead of traversing each tree, the leaves of every tree are numbered from left to right and each internal
+     * node is encoded as a 64-bit mask that clears the leaves of its left subtree. The nodes of all trees are
+     * grouped by feature and sorted by threshold. Scoring a sample scans, for each feature, the nodes whose test
+     * is false (i.e., those with threshold <= feature value) and ANDs their masks into the bitvector of their tree.
+     * The exit leaf of a tree is then the leftmost leaf whose bit is still set. Categorical split nodes cannot be
+     * sorted by threshold, hence their tests are evaluated one by one.
+     *
+     * Reference: Lucchese et al., "QuickScorer: a fast algorithm to rank documents with additive ensembles of
+     * regression trees", SIGIR 2015.
+     */
+class QuickScorer
+{
+
+    // Internal nodes sorted by (feature, threshold): threshold, tree index and mask of each node, and whether
+    // missing values follow its left branch
+    Vector _thresholds;
+    std::vector<uint32_t> _treeIds;
+    std::vector<uint64_t> _masks;
+    std::vector<uint8_t> _defaultLeft;
+
+    // Nodes of feature f are stored in [_featureOffsets[f], _featureOffsets[f + 1])
+    std::vector<size_t> _featureOffsets;
+
+    // Leaf values of all trees, from left to right; leaves of tree t start at _leafOffsets[t]
+    Vector _leafValues;
+    std::vector<size_t> _leafOffsets;
+
+    // Categorical split nodes, with the offsets of their sets of categories (see FlatForest) in _categories
+    struct CategoricalNode
+    {
+        int32_t featureIndex;
+        uint32_t treeId;
+        uint64_t mask;
+        size_t categories;
+    };
+    std::vector<CategoricalNode> _categoricalNodes;
+    std::vector<uint32_t> _categories;
+
+    struct Node
+    {
+        int32_t featureIndex;
+        double threshold;
+        uint32_t treeId;
+        uint64_t mask;
+        bool defaultLeft;
+    };
+
+    static inline int lowestSetBit(uint64_t bitvector)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(bitvector);
+#else
+        int bit = 0;
+        while ((bitvector & 1ULL) == 0)
+        {
+            bitvector >>= 1;
+            bit++;
+        }
+        return bit;
+#endif
+    }
+
+    static size_t countLeaves(const FlatForest &forest, size_t node)
+    {
+        if (forest.isLeaf(node))
+        {
+            return 1;
+        }
+        return countLeaves(forest, forest.leftChild(node)) + countLeaves(forest, forest.rightChild(node));
+    }
+
+    /**
+         * Append the leaves of a subtree (from left to right) and the encoded masks of its internal nodes
+         *
+         * @return Number of leaves of the subtree
+         */
+    size_t encodeSubtree(const FlatForest &forest, size_t node, uint32_t treeId, std::vector<Node> &nodes)
+    {
+        if (forest.isLeaf(node))
+        {
+            _leafValues.push_back(forest.leafValue(node));
+            return 1;
+        }
+
+        size_t firstLeaf = _leafValues.size() - _leafOffsets[treeId];
+        size_t leftLeaves = encodeSubtree(forest, forest.leftChild(node), treeId, nodes);
+        uint64_t leftMask = ((leftLeaves == 64) ? ~0ULL : ((1ULL << leftLeaves) - 1)) << firstLeaf;
+        if (forest.isCategorical(node))
+        {
+            _categoricalNodes.push_back(CategoricalNode{forest.featureIndex(node), treeId, ~leftMask, _categories.size()});
+            _categories.push_back(static_cast<uint32_t>(forest.numCategoryWords(node)));
+            _categories.insert(_categories.end(), forest.categories(node),
+                               forest.categories(node) + forest.numCategoryWords(node));
+        }
+        else
+        {
+            nodes.push_back(Node{forest.featureIndex(node), forest.threshold(node), treeId, ~leftMask,
+                                 forest.defaultLeft(node)});
+        }
+
+        return leftLeaves + encodeSubtree(forest, forest.rightChild(node), treeId, nodes);
+    }
+
+public:
+    // Maximum number of leaves per tree
+    static constexpr size_t MaxLeaves = 64;
+
+    QuickScorer() = default;
+
+    /**
+         * Whether every tree of a forest has at most MaxLeaves leaves, i.e., the forest can be encoded
+         *
+         * @param forest Trained trees
+         */
+    static bool supports(const FlatForest &forest)
+    {
+        for (size_t t = 0; t < forest.numTrees(); t++)
+        {
+            if (countLeaves(forest, forest.treeOffset(t)) > MaxLeaves)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+         * Build the QuickScorer encoding of a forest
+         *
+         * @param forest Trained trees
+         * @throws std::invalid_argument if a tree has more than MaxLeaves leaves
+         */
+    explicit QuickScorer(const FlatForest &forest)
+    {
+        std::vector<Node> nodes;
+        for (size_t t = 0; t < forest.numTrees(); t++)
+        {
+            size_t numLeaves = countLeaves(forest, forest.treeOffset(t));
+            if (numLeaves > MaxLeaves)
+            {
+                throw std::invalid_argument("QuickScorer supports trees with at most 64 leaves, tree " +
+                                            std::to_string(t) + " has " + std::to_string(numLeaves));
+            }
+
+            _leafOffsets.push_back(_leafValues.size());
+            encodeSubtree(forest, forest.treeOffset(t), static_cast<uint32_t>(t), nodes);
+        }
+
+        std::stable_sort(nodes.begin(), nodes.end(), [](const Node &a, const Node &b) {
+            return (a.featureIndex < b.featureIndex) ||
+                   (a.featureIndex == b.featureIndex && a.threshold < b.threshold);
+        });
+
+        int32_t numFeatures = nodes.empty() ? 0 : nodes.back().featureIndex + 1;
+        _featureOffsets.assign(static_cast<size_t>(numFeatures) + 1, 0);
+        for (const Node &node : nodes)
+        {
+            _thresholds.push_back(node.threshold);
+            _treeIds.push_back(node.treeId);
+            _masks.push_back(node.mask);
+            _defaultLeft.push_back(node.defaultLeft ? 1 : 0);
+            _featureOffsets[node.featureIndex + 1]++;
+        }
+        std::partial_sum(_featureOffsets.begin(), _featureOffsets.end(), _featureOffsets.begin());
+    }
+
+    inline size_t numTrees() const { return _leafOffsets.size(); }
+
+    /**
+         * Return sum of scores of the first numTrees trees for a sample
+         *
+         * @param sample Sample features, any type supporting sample[featureIndex]
+         * @param numTrees Number of trees to use; all trees if zero
+         * @param bitvectors Scratch buffer, one bitvector per tree
+         * @return Sum of scores, identical to FlatForest::score
+         */
+    template <typename Sample>
+    double score(const Sample &sample, size_t numTrees, std::vector<uint64_t> &bitvectors) const
+    {
+        numTrees = (numTrees == 0) ? _leafOffsets.size() : std::min(numTrees, _leafOffsets.size());
+        bitvectors.assign(_leafOffsets.size(), ~0ULL);
+
+        for (size_t f = 0; f + 1 < _featureOffsets.size(); f++)
+        {
+            size_t begin = _featureOffsets[f], end = _featureOffsets[f + 1];
+            if (begin == end)
+            {
+                continue;
+            }
+
+            // Missing values fail the test of every node, unless they follow its left branch
+            double value = sample[f];
+            if (std::isnan(value))
+            {
+                for (size_t k = begin; k < end; k++)
+                {
+                    if (!_defaultLeft[k])
+                    {
+                        bitvectors[_treeIds[k]] &= _masks[k];
+                    }
+                }
+                continue;
+            }
+
+            for (size_t k = begin; k < end && _thresholds[k] <= value; k++)
+            {
+                bitvectors[_treeIds[k]] &= _masks[k];
+            }
+        }
+
+        for (const CategoricalNode &node : _categoricalNodes)
+        {
+            const uint32_t *set = _categories.data() + node.categories;
+            if (!CategorySet::contains(set + 1, set[0], sample[node.featureIndex]))
+            {
+                bitvectors[node.treeId] &= node.mask;
+            }
+        }
+
+        long double score = 0.0;
+        for (size_t t = 0; t < numTrees; t++)
+        {
+            score += _leafValues[_leafOffsets[t] + lowestSetBit(bitvectors[t])];
+        }
+
+        return (double)score;
+    }
+};
+} // namespace microgbt
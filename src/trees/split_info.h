@@ -1,9 +1,12 @@
 #pragma once
 #include <utility>
+#include <algorithm>
 #include <Eigen/Dense>
 #include <vector>
+#include <cstdint>
 
 #include "../types.h"
+#include "../utils/arena.h"
 
 namespace microgbt
 {
@@ -11,12 +14,17 @@ namespace microgbt
 /**
          * SplitInfo contains information of a binary tree split such as
          * gain value, split numeric value on which best split gain is attained.
+         *
+         * Splitters evaluate every candidate feature into a compact record (feature, split value, gain, and the
+         * gradient / Hessian sums and sample counts of both sides); the partition of the samples into the left and
+         * right side is only materialized for the winning split, see setPartition. The partition is a buffer of
+         * the arena of tree construction, if any (see ScratchArena), hence splits are moved but not copied.
          */
 class SplitInfo
 {
 
-    // Sorted list of feature indices with respect to feature values
-    Eigen::RowVectorXi _sortedFeatureIndices;
+    // Partition of the local row indices: the left side, then the right side; empty until materialized
+    PooledBuffer<std::vector<int>> _partition;
 
     /* Best gain of split and split value on which the best gain is attained */
     double _bestGain = std::numeric_limits<double>::min(), _bestSplitNumericValue = 0.0;
@@ -27,6 +35,18 @@ class SplitInfo
     // Feature index on which best gain was attained
     long _bestFeatureId = -1;
 
+    // Whether samples with a missing value of the feature follow the left branch, see TreeNode::score
+    bool _defaultLeft = false;
+
+    // Sums of gradients and Hessians of the samples of each side
+    double _leftG = 0.0, _leftH = 0.0, _rightG = 0.0, _rightH = 0.0;
+
+    // Number of samples of each side
+    size_t _leftCount = 0, _rightCount = 0;
+
+    // Categorical splits: bitset of the categories of the left side (see CategorySet); empty for numerical splits
+    std::vector<uint32_t> _categories;
+
 public:
     enum Side
     {
@@ -42,13 +62,44 @@ public:
         _bestSplitNumericValue = bestSplitNumericValue;
     }
 
-    SplitInfo(const Eigen::RowVectorXi &sortedFeatureIndices, double gain, double bestSplitNumericValue, size_t bestSortedIdx) : _sortedFeatureIndices(sortedFeatureIndices)
+    /**
+             * Split whose partition is not materialized, i.e., of the bestSortedIdx smallest values of a feature (and
+             * of the missing values if defaultLeft) versus the others
+             */
+    SplitInfo(double gain, double bestSplitNumericValue, size_t bestSortedIdx, bool defaultLeft)
     {
         _bestGain = gain;
         _bestSplitNumericValue = bestSplitNumericValue;
         _bestSortedIndex = bestSortedIdx;
+        _defaultLeft = defaultLeft;
+    }
+
+    SplitInfo(PooledBuffer<std::vector<int>> partition, double gain, double bestSplitNumericValue, size_t bestSortedIdx,
+              bool defaultLeft = false) : _partition(std::move(partition))
+    {
+        _bestGain = gain;
+        _bestSplitNumericValue = bestSplitNumericValue;
+        _bestSortedIndex = bestSortedIdx;
+        _defaultLeft = defaultLeft;
+        _leftCount = bestSortedIdx;
+        _rightCount = _partition->size() - bestSortedIdx;
+    }
+
+    /**
+             * Split of the bestSortedIdx first local row indices versus the others, with a partition without arena
+             */
+    SplitInfo(const Eigen::RowVectorXi &sortedFeatureIndices, double gain, double bestSplitNumericValue,
+              size_t bestSortedIdx, bool defaultLeft = false)
+        : SplitInfo(PooledBuffer<std::vector<int>>(nullptr, static_cast<size_t>(sortedFeatureIndices.size())), gain,
+                    bestSplitNumericValue, bestSortedIdx, defaultLeft)
+    {
+        std::copy(sortedFeatureIndices.data(), sortedFeatureIndices.data() + sortedFeatureIndices.size(),
+                  _partition->begin());
     }
 
+    SplitInfo(SplitInfo &&) = default;
+    SplitInfo &operator=(SplitInfo &&) = default;
+
     bool operator<(const SplitInfo &rhs) const { return this->_bestGain <= rhs.bestGain(); }
 
     inline double bestGain() const { return _bestGain; }
@@ -59,15 +110,61 @@ public:
 
     inline long getBestFeatureId() const { return _bestFeatureId; }
 
-    VectorT getLeftLocalIds() const
+    inline size_t bestSortedIndex() const { return _bestSortedIndex; }
+
+    inline bool defaultLeft() const { return _defaultLeft; }
+
+    inline bool isCategorical() const { return !_categories.empty(); }
+
+    inline const std::vector<uint32_t> &categories() const { return _categories; }
+
+    void setCategories(std::vector<uint32_t> categories) { _categories = std::move(categories); }
+
+    /**
+             * Set the gradient / Hessian sums and sample counts of both sides of the split
+             */
+    void setSides(double leftG, double leftH, size_t leftCount, double rightG, double rightH, size_t rightCount)
     {
-        return VectorT(_sortedFeatureIndices.data(), _sortedFeatureIndices.data() + _bestSortedIndex);
+        _leftG = leftG;
+        _leftH = leftH;
+        _leftCount = leftCount;
+        _rightG = rightG;
+        _rightH = rightH;
+        _rightCount = rightCount;
     }
 
-    VectorT getRightLocalIds() const
+    inline double gradientSum(Side side) const { return (side == Side::Left) ? _leftG : _rightG; }
+
+    inline double hessianSum(Side side) const { return (side == Side::Left) ? _leftH : _rightH; }
+
+    /**
+             * Number of samples of a side of the split
+             */
+    inline size_t count(Side side) const { return (side == Side::Left) ? _leftCount : _rightCount; }
+
+    /**
+             * Materialize the partition of the samples, i.e., the local row indices of the left side (count(Left) of
+             * them) followed by the ones of the right side
+             */
+    void setPartition(PooledBuffer<std::vector<int>> partition) { _partition = std::move(partition); }
+
+    inline bool hasPartition() const { return !_partition->empty(); }
+
+    VectorT getLeftLocalIds() const { return VectorT(_partition->begin(), _partition->begin() + _leftCount); }
+
+    VectorT getRightLocalIds() const { return VectorT(_partition->begin() + _leftCount, _partition->end()); }
+
+    /**
+             * Local row indices of a side of the split, without copying them
+             */
+    inline const int *localIds(Side side) const
     {
-        return VectorT(_sortedFeatureIndices.data() + _bestSortedIndex,
-                       _sortedFeatureIndices.data() + _sortedFeatureIndices.size());
+        return _partition->data() + ((side == Side::Left) ? 0 : _leftCount);
+    }
+
+    inline size_t numLocalIds(Side side) const
+    {
+        return (side == Side::Left) ? _leftCount : _partition->size() - _leftCount;
     }
 
     /**
@@ -100,5 +197,22 @@ public:
 
         return splitVector;
     }
+
+    /**
+             * Split a vector based on a side into a given buffer, e.g., a pooled one (see ScratchArena)
+             *
+             * @param vector Input vector to split
+             * @param side Left or right side
+             * @param splitVector Output: the sub-vector of the input vector, resized to the size of the side
+             */
+    void split(const VectorD &vector, const SplitInfo::Side &side, VectorD &splitVector) const
+    {
+        const int *rowIndices = localIds(side);
+        splitVector.resize(numLocalIds(side));
+        for (size_t i = 0; i < splitVector.size(); i++)
+        {
+            splitVector[i] = vector[rowIndices[i]];
+        }
+    }
 };
 } // namespace microgbt
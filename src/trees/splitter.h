@@ -1,30 +1,168 @@
 #pragma once
 
+#include <memory>
+#include <functional>
+
 #include "../dataset.h"
+#include "../utils/thread_pool.h"
 #include "split_info.h"
+#include "node_statistics.h"
 
 namespace microgbt
 {
 
 /**
-     * Splitter defines a binary tree splits interface
+     * Splitter defines a binary tree splits interface over datasets with feature storage type Feature
      */
-class Splitter
+template <typename Feature>
+class BasicSplitter
 {
+protected:
+    // Regularization parameter of xgboost
+    double _lambda;
+
+    // Optional thread pool on which features are evaluated in parallel
+    std::shared_ptr<ThreadPool> _threadPool;
+
+    /**
+        * Invoke evaluate(k) for every index k in [0, numFeatures), in parallel if a thread pool is set
+        *
+        * @param numFeatures Number of features
+        * @param evaluate Independent evaluation of a single feature; only wrapped in a std::function (which may
+        *                 allocate) if a thread pool is set
+        */
+    template <typename Evaluate>
+    void forEachFeature(long numFeatures, const Evaluate &evaluate) const
+    {
+        if (_threadPool)
+        {
+            _threadPool->parallelFor(static_cast<size_t>(numFeatures), std::function<void(size_t)>(evaluate));
+        }
+        else
+        {
+            for (long featureId = 0; featureId < numFeatures; featureId++)
+            {
+                evaluate(static_cast<size_t>(featureId));
+            }
+        }
+    }
+
+    /**
+        * Returns objective value for a given gradient, hessian and lambda value
+        *
+        * @param gradient Gradient value
+        * @param hessian Hessian value
+        * @return
+        */
+    constexpr double objective(double gradient, double hessian) const
+    {
+        return (gradient * gradient) / (hessian + _lambda);
+    }
+
+    /**
+        * Returns gain difference of a specific binary tree split.
+        *
+        * Refer to Eq7 of Reference [1]
+        *
+        * @param G Gradient on node before the split applied
+        * @param H Hessian on node before the split applied
+        * @param G_l Gradient on left split node
+        * @param H_l Hesssian on left split node
+        * @return Gain on split, i.e., reduction on objective value
+        */
+    constexpr double calc_split_gain(double G, double H, double G_l, double H_l) const
+    {
+        return objective(G_l, H_l) + objective(G - G_l, H - H_l) - objective(G, H) / 2.0; // TODO: minus \gamma
+    }
+
 public:
-    virtual ~Splitter() = default;
+    explicit BasicSplitter(double lambda, std::shared_ptr<ThreadPool> threadPool = nullptr)
+        : _lambda(lambda), _threadPool(std::move(threadPool)) {}
+
+    virtual ~BasicSplitter() = default;
 
     /**
          * Return the best binary tree split based on a dataset (matrix, target vector) and
-         * the corresponding gradient and Hessian vectors
+         * the corresponding gradient and Hessian vectors, over a subset of its features
          *
          * @param dataset Current dataset (matrix, train vector)
          * @param gradient Gradient vector, one coordinate per sample / dataset row
          * @param hessian Hessian vector, one coordinate per sample / dataset row
-         * @return Best split over all features
+         * @param features Increasing list of candidate feature indices, a subset of dataset.features()
+         * @param arena Arena that the partition of the split is a buffer of, if any; it must outlive the split
+         * @return Best split over the candidate features
          */
-    virtual SplitInfo findBestSplit(const Dataset &dataset,
+    virtual SplitInfo findBestSplit(const BasicDataset<Feature> &dataset,
                                     const Vector &gradient,
-                                    const Vector &hessian) const = 0;
+                                    const Vector &hessian,
+                                    const VectorT &features,
+                                    ScratchArena *arena = nullptr) const = 0;
+
+    /**
+         * Return the best binary tree split over all features of a dataset
+         *
+         * @param dataset Current dataset (matrix, train vector)
+         * @param gradient Gradient vector, one coordinate per sample / dataset row
+         * @param hessian Hessian vector, one coordinate per sample / dataset row
+         * @return Best split over all features
+         */
+    SplitInfo findBestSplit(const BasicDataset<Feature> &dataset,
+                            const Vector &gradient,
+                            const Vector &hessian) const
+    {
+        return findBestSplit(dataset, gradient, hessian, dataset.features());
+    }
+
+    /**
+         * Return the statistics of a dataset, or nullptr if the splitter does not use node statistics
+         *
+         * @param dataset Current dataset (matrix, train vector)
+         * @param gradient Gradient vector, one coordinate per sample / dataset row
+         * @param hessian Hessian vector, one coordinate per sample / dataset row
+         * @param arena Arena whose released statistics (see StatisticsPool) are reused, if any
+         */
+    virtual std::unique_ptr<NodeStatistics> statistics(const BasicDataset<Feature> & /* dataset */,
+                                                       const Vector & /* gradient */,
+                                                       const Vector & /* hessian */,
+                                                       ScratchArena * /* arena */ = nullptr) const
+    {
+        return nullptr;
+    }
+
+    /**
+         * Return the statistics of a child node, derived from the statistics of its parent and its sibling
+         *
+         * @param parent Statistics of the parent node
+         * @param sibling Statistics of the sibling node
+         * @param arena Arena whose released statistics (see StatisticsPool) are reused, if any
+         */
+    virtual std::unique_ptr<NodeStatistics> subtract(const NodeStatistics & /* parent */,
+                                                     const NodeStatistics & /* sibling */,
+                                                     ScratchArena * /* arena */ = nullptr) const
+    {
+        return nullptr;
+    }
+
+    /**
+         * Return the best binary tree split of a dataset, given its statistics (see statistics)
+         *
+         * @param dataset Current dataset (matrix, train vector)
+         * @param gradient Gradient vector, one coordinate per sample / dataset row
+         * @param hessian Hessian vector, one coordinate per sample / dataset row
+         * @param features Increasing list of candidate feature indices, a subset of dataset.features()
+         * @param statistics Statistics of the dataset
+         * @param arena Arena that the partition of the split is a buffer of, if any; it must outlive the split
+         */
+    virtual SplitInfo findBestSplitFromStatistics(const BasicDataset<Feature> &dataset,
+                                                  const Vector &gradient,
+                                                  const Vector &hessian,
+                                                  const VectorT &features,
+                                                  const NodeStatistics & /* statistics */,
+                                                  ScratchArena *arena = nullptr) const
+    {
+        return findBestSplit(dataset, gradient, hessian, features, arena);
+    }
 };
-} // namespace microgbt
\ No newline at end of file
+
+using Splitter = BasicSplitter<double>;
+} // namespace microgbt
@@ -10,48 +10,91 @@ namespace microgbt
 {
 
 /**
-     * A decision / regression tree with binary splits
+     * A decision / regression tree with binary splits, trained on datasets with feature storage type Feature
      */
-class Tree
+template <typename Feature>
+class BasicTree
 {
 
     // Maximum depth of tree
     int _maxDepth;
 
+    // Maximum number of leaves of a tree grown leaf-wise; zero for depth-wise growth
+    int _maxLeaves;
+
     // Gradient boosting parameters
     double _lambda, _minSplitGain, _minTreeSize;
 
+    // Arena of the nodes of the tree, possibly shared with other trees; it outlives the root
+    std::shared_ptr<BasicTreeArena<Feature>> _arena;
+
     // Root of tree
-    std::shared_ptr<TreeNode> _root;
+    std::shared_ptr<BasicTreeNode<Feature>> _root;
+
+    // Split finding strategy
+    std::shared_ptr<const BasicSplitter<Feature>> _splitter;
 
 public:
-    Tree(double lambda, double minSplitGain, double minTreeSize, int maxDepth)
+    BasicTree(double lambda, double minSplitGain, double minTreeSize, int maxDepth)
+        : BasicTree(lambda, minSplitGain, minTreeSize, maxDepth,
+                    std::make_shared<BasicNumericalSplitter<Feature>>(lambda))
+    {
+    }
+
+    /**
+         * @param arena Arena of the nodes and buffers of tree construction, e.g., shared by the trees of all boosting
+         *              rounds; a new arena if nullptr
+         */
+    BasicTree(double lambda, double minSplitGain, double minTreeSize, int maxDepth,
+              std::shared_ptr<const BasicSplitter<Feature>> splitter, int maxLeaves = 0,
+              std::shared_ptr<BasicTreeArena<Feature>> arena = nullptr)
     {
+        _arena = arena ? std::move(arena) : std::make_shared<BasicTreeArena<Feature>>();
         _lambda = lambda;
         _minSplitGain = minSplitGain;
         _maxDepth = maxDepth;
         _minTreeSize = minTreeSize;
+        _splitter = std::move(splitter);
+        _maxLeaves = maxLeaves;
     }
 
     /**
           * Recursively (and greedily) build regression tree using 'optimal greedy' binary splits
           * based on gradient & Hessian vectors.
           *
+          * The tree is grown depth-wise, or leaf-wise up to maxLeaves leaves if maxLeaves is positive.
+          *
           * @param trainSet Training dataset
           * @param previousPreds Prediction based on previous trees
           * @param gradient Gradient vector
           * @param hessian Vector of second derivatives, Hessian
           * @param shrinkage Shrinkage rate
+          * @param trainScores Raw scores of all training samples (indexed by global row index), incremented by
+          *                    the score of the tree for each training sample
+          * @param levelFeatures Candidate split features per depth 0, ..., maxDepth (subsets of the features of
+          *                      trainSet), or empty if all features of trainSet are candidates at every depth
+          * @param stats Construction counters, incremented if not nullptr
           */
-    void build(const Dataset &trainSet, const Vector &previousPreds,
+    void build(const BasicDataset<Feature> &trainSet, const Vector &previousPreds,
                const Vector &gradient,
                const Vector &hessian,
-               double shrinkage)
+               double shrinkage,
+               Vector &trainScores,
+               const std::vector<VectorT> &levelFeatures = std::vector<VectorT>(),
+               BuildStats *stats = nullptr)
     {
 
-        this->_root = std::unique_ptr<TreeNode>(new TreeNode(_lambda, _minSplitGain, _minTreeSize, _maxDepth));
+        this->_root = BasicTreeNode<Feature>::create(_arena.get(), _lambda, _minSplitGain, _minTreeSize, _maxDepth);
+        if (_maxLeaves > 0)
+        {
+            this->_root->buildLeafWise(trainSet, previousPreds, gradient, hessian, shrinkage, _maxLeaves, *_splitter,
+                                       levelFeatures, trainScores, stats, _arena.get());
+            return;
+        }
+
         int depth = 0;
-        this->_root->build(trainSet, previousPreds, gradient, hessian, shrinkage, depth);
+        this->_root->build(trainSet, previousPreds, gradient, hessian, shrinkage, depth, *_splitter, levelFeatures,
+                           trainScores, nullptr, stats, _arena.get());
     }
 
     /**
@@ -61,5 +104,12 @@ public:
          * @return Score of tree
          */
     double score(const Eigen::RowVectorXd &sample) const { return _root->score(sample); }
+
+    /**
+         * Return the root node of the tree, or nullptr if the tree is not built
+         */
+    inline const BasicTreeNode<Feature> *root() const { return _root.get(); }
 };
+
+using Tree = BasicTree<double>;
 } // namespace microgbt
\ No newline at end of file
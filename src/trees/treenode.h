@@ -8,19 +8,27 @@
 #include <iterator>
 #include <iostream>
 #include <thread>
+#include <cmath>
 
 #include "../dataset.h"
 #include "split_info.h"
+#include "category_set.h"
 #include "numerical_splliter.h"
 #include "../types.h"
+#include "../utils/training_log.h"
+#include "../utils/arena.h"
 
 namespace microgbt
 {
 
+template <typename Feature>
+class BasicTreeArena;
+
 /**
-     * A node of a regression tree of GBT
+     * A node of a regression tree of GBT, trained on datasets with feature storage type Feature
      */
-class TreeNode
+template <typename Feature>
+class BasicTreeNode
 {
 
     // Maximum tree depth
@@ -32,8 +40,36 @@ class TreeNode
     // Is the node a leaf?
     bool _isLeaf = false;
 
+    friend class BasicTreeArena<Feature>;
+
+public:
+    /**
+         * Deleter of nodes: nodes of an arena are returned to its pool
+         */
+    struct Deleter
+    {
+        ObjectPool<BasicTreeNode> *pool;
+
+        explicit Deleter(ObjectPool<BasicTreeNode> *pool = nullptr) : pool(pool) {}
+
+        void operator()(BasicTreeNode *node) const
+        {
+            if (pool)
+            {
+                pool->destroy(node);
+            }
+            else
+            {
+                delete node;
+            }
+        }
+    };
+
+    using Ptr = std::unique_ptr<BasicTreeNode, Deleter>;
+
+private:
     // Pointers to left and right subtrees
-    std::unique_ptr<TreeNode> leftSubTree, rightSubTree;
+    Ptr leftSubTree, rightSubTree;
 
     // Feature index on which the split took place
     long _splitFeatureIndex = -1;
@@ -41,14 +77,283 @@ class TreeNode
     // Numeric value on which the binary tree split took place
     double _splitNumericValue = std::numeric_limits<double>::min(), _weight = 0.0;
 
-    template <typename T, typename... Args>
-    std::unique_ptr<T> make_unique(Args &&... args)
+    // Whether samples with a missing value of the split feature follow the left branch
+    bool _defaultLeft = false;
+
+    // Categorical splits: bitset of the categories of the left branch (see CategorySet), empty otherwise
+    std::vector<uint32_t> _categories;
+
+    /**
+         * A leaf of a tree grown leaf-wise, together with its samples and its best split
+         */
+    struct Candidate
+    {
+        BasicTreeNode *node;
+
+        // Samples of the leaf: the ones of the caller for the root (not copied), otherwise the owned ones below
+        const BasicDataset<Feature> *trainSet;
+        const Vector *previousPreds, *gradient, *hessian;
+
+        // Samples of a non-root leaf, i.e., buffers of the arena if any
+        BasicDataset<Feature> ownTrainSet;
+        PooledBuffer<Vector> ownPreviousPreds, ownGradient, ownHessian;
+
+        int depth;
+        SplitInfo split;
+
+        // Statistics of the splitter, if computed or derived from the parent; released to the arena, if any
+        std::unique_ptr<NodeStatistics> statistics;
+        BasicTreeArena<Feature> *arena;
+
+        // Creation order, used to break ties between equal gains
+        size_t order = 0;
+
+        /**
+             * Root leaf, whose samples are the dataset and vectors of the caller; they must outlive the candidate
+             */
+        Candidate(BasicTreeNode *root, const BasicDataset<Feature> &rootSet, const Vector &rootPreds,
+                  const Vector &rootGradient, const Vector &rootHessian, BasicTreeArena<Feature> *arena)
+            : node(root), trainSet(&rootSet), previousPreds(&rootPreds), gradient(&rootGradient),
+              hessian(&rootHessian), depth(0), arena(arena) {}
+
+        /**
+             * Child leaf on one side of the best split of parent, whose samples are split from the ones of parent
+             */
+        Candidate(BasicTreeNode *child, const Candidate &parent, SplitInfo::Side side, BasicTreeArena<Feature> *arena)
+            : node(child), ownTrainSet(*parent.trainSet, parent.split, side, arena),
+              ownPreviousPreds(arena ? &arena->values : nullptr, parent.split.numLocalIds(side)),
+              ownGradient(arena ? &arena->values : nullptr, parent.split.numLocalIds(side)),
+              ownHessian(arena ? &arena->values : nullptr, parent.split.numLocalIds(side)),
+              depth(parent.depth + 1), arena(arena)
+        {
+            parent.split.split(*parent.previousPreds, side, *ownPreviousPreds);
+            parent.split.split(*parent.gradient, side, *ownGradient);
+            parent.split.split(*parent.hessian, side, *ownHessian);
+            trainSet = &ownTrainSet;
+            previousPreds = &*ownPreviousPreds;
+            gradient = &*ownGradient;
+            hessian = &*ownHessian;
+        }
+
+        Candidate(const Candidate &) = delete;
+        Candidate &operator=(const Candidate &) = delete;
+
+        ~Candidate() { releaseStatistics(statistics, arena); }
+    };
+
+    /**
+         * Deleter of candidates: candidates of an arena are returned to its pool
+         */
+    struct CandidateDeleter
+    {
+        ObjectPool<Candidate> *pool;
+
+        explicit CandidateDeleter(ObjectPool<Candidate> *pool = nullptr) : pool(pool) {}
+
+        void operator()(Candidate *candidate) const
+        {
+            if (pool)
+            {
+                pool->destroy(candidate);
+            }
+            else
+            {
+                delete candidate;
+            }
+        }
+    };
+
+    using CandidatePtr = std::unique_ptr<Candidate, CandidateDeleter>;
+
+    /**
+         * Create a candidate, in the pool of an arena if any
+         */
+    template <typename... Args>
+    static CandidatePtr newCandidate(BasicTreeArena<Feature> *arena, Args &&... args)
+    {
+        if (arena == nullptr)
+        {
+            return CandidatePtr(new Candidate(std::forward<Args>(args)..., arena), CandidateDeleter());
+        }
+        return CandidatePtr(arena->candidates.create(std::forward<Args>(args)..., arena),
+                            CandidateDeleter(&arena->candidates));
+    }
+
+    /**
+         * Release the statistics of a node to the arena, if any, for reuse by the nodes built next
+         */
+    static void releaseStatistics(std::unique_ptr<NodeStatistics> &statistics, ScratchArena *arena)
+    {
+        if (arena)
+        {
+            arena->statistics.release(std::move(statistics));
+        }
+        statistics.reset();
+    }
+
+    /**
+         * Whether a candidate leaf has a smaller priority than another one, i.e., a smaller gain or, on ties,
+         * a later creation
+         */
+    static bool lowerPriority(const CandidatePtr &a, const CandidatePtr &b)
+    {
+        return (a->split.bestGain() < b->split.bestGain()) ||
+               (a->split.bestGain() == b->split.bestGain() && a->order > b->order);
+    }
+
+    /**
+         * Whether the leaf of a candidate satisfies the depth and size constraints, and its best split the minimum
+         * split gain, i.e., whether it may be split
+         */
+    bool canSplit(const Candidate &candidate) const
     {
-        return std::unique_ptr<T>(new T(std::forward<Args>(args)...));
+        return candidate.depth <= _maxDepth && candidate.trainSet->nRows() > _minTreeSize &&
+               candidate.split.bestGain() >= _minSplitGain;
+    }
+
+    /**
+         * Find the best split of a node, using (or computing) the statistics of the splitter if it has any
+         *
+         * @param trainSet Train dataset of the node
+         * @param gradient Gradient vector
+         * @param hessian Hessian vector
+         * @param splitter Split finding strategy
+         * @param features Increasing list of candidate feature indices
+         * @param statistics Statistics of the node; if nullptr, they are computed and stored in it
+         * @param stats Construction counters of the tree, if any
+         * @param arena Arena of the partition of the split, if any
+         */
+    static SplitInfo findBestSplit(const BasicDataset<Feature> &trainSet,
+                                   const Vector &gradient,
+                                   const Vector &hessian,
+                                   const BasicSplitter<Feature> &splitter,
+                                   const VectorT &features,
+                                   std::unique_ptr<NodeStatistics> &statistics,
+                                   BuildStats *stats,
+                                   ScratchArena *arena)
+    {
+        PhaseTimer timer(stats ? &stats->splitMillis : nullptr);
+
+        // Rows are scanned unless the statistics are derived from the parent
+        if (!statistics)
+        {
+            statistics = splitter.statistics(trainSet, gradient, hessian, arena);
+            if (stats != nullptr)
+            {
+                stats->rowsTouched += trainSet.nRows();
+                stats->bytesAllocated += statistics ? statistics->bytes() : 0;
+            }
+        }
+
+        return statistics ? splitter.findBestSplitFromStatistics(trainSet, gradient, hessian, features, *statistics,
+                                                                 arena)
+                          : splitter.findBestSplit(trainSet, gradient, hessian, features, arena);
+    }
+
+    /**
+         * Candidate split features of a node: the features of its level if they are sampled per level, otherwise
+         * all features of its dataset
+         */
+    static const VectorT &candidateFeatures(const BasicDataset<Feature> &trainSet,
+                                            const std::vector<VectorT> &levelFeatures, int depth)
+    {
+        return levelFeatures.empty() ? trainSet.features() : levelFeatures[depth];
+    }
+
+    /**
+         * Statistics of the children of a split node: the ones of the smaller child are computed and the ones of the
+         * larger child are derived from the ones of the parent by subtraction, which halves the work per split
+         *
+         * @param parentStatistics Statistics of the split node, or nullptr if the splitter has none
+         * @param leftSet Train dataset of the left child
+         * @param leftGradient Gradient vector of the left child
+         * @param leftHessian Hessian vector of the left child
+         * @param rightSet Train dataset of the right child
+         * @param rightGradient Gradient vector of the right child
+         * @param rightHessian Hessian vector of the right child
+         * @param splitter Split finding strategy
+         * @param leftStatistics Output: statistics of the left child, nullptr if not available
+         * @param rightStatistics Output: statistics of the right child, nullptr if not available
+         * @param stats Construction counters of the tree, if any
+         * @param arena Arena whose released statistics are reused, if any
+         */
+    static void childStatistics(const NodeStatistics *parentStatistics,
+                                const BasicDataset<Feature> &leftSet, const Vector &leftGradient,
+                                const Vector &leftHessian,
+                                const BasicDataset<Feature> &rightSet, const Vector &rightGradient,
+                                const Vector &rightHessian,
+                                const BasicSplitter<Feature> &splitter,
+                                std::unique_ptr<NodeStatistics> &leftStatistics,
+                                std::unique_ptr<NodeStatistics> &rightStatistics,
+                                BuildStats *stats,
+                                ScratchArena *arena)
+    {
+        if (parentStatistics == nullptr)
+        {
+            return;
+        }
+
+        PhaseTimer timer(stats ? &stats->splitMillis : nullptr);
+        if (leftSet.nRows() <= rightSet.nRows())
+        {
+            leftStatistics = splitter.statistics(leftSet, leftGradient, leftHessian, arena);
+            rightStatistics = leftStatistics ? splitter.subtract(*parentStatistics, *leftStatistics, arena) : nullptr;
+        }
+        else
+        {
+            rightStatistics = splitter.statistics(rightSet, rightGradient, rightHessian, arena);
+            leftStatistics = rightStatistics ? splitter.subtract(*parentStatistics, *rightStatistics, arena) : nullptr;
+        }
+
+        if (stats != nullptr)
+        {
+            stats->rowsTouched += std::min(leftSet.nRows(), rightSet.nRows());
+            stats->bytesAllocated += (leftStatistics ? leftStatistics->bytes() : 0) +
+                                     (rightStatistics ? rightStatistics->bytes() : 0);
+        }
+    }
+
+    /**
+         * Count the split of a node into two children: its rows are scanned, and the datasets and vectors of the
+         * children are allocated
+         */
+    static void countSplit(BuildStats *stats, const BasicDataset<Feature> &trainSet,
+                           const BasicDataset<Feature> &leftSet, const BasicDataset<Feature> &rightSet)
+    {
+        if (stats != nullptr)
+        {
+            stats->numNodes++;
+            stats->rowsTouched += trainSet.nRows();
+            stats->bytesAllocated += leftSet.indexBytes() + rightSet.indexBytes() +
+                                     3 * sizeof(double) * static_cast<size_t>(trainSet.nRows());
+        }
+    }
+
+    /**
+         * Create a child node with the parameters of this node, in the pool of an arena if any
+         */
+    Ptr newChild(BasicTreeArena<Feature> *arena) const
+    {
+        return create(arena, _lambda, _minSplitGain, _minTreeSize, _maxDepth);
     }
 
 public:
-    explicit TreeNode(double lambda, double minSplitGain, double minTreeSize, int maxDepth)
+    /**
+         * Create a node, in the pool of an arena if any
+         *
+         * @param arena Arena of tree construction, if any; it must outlive the node
+         */
+    static Ptr create(BasicTreeArena<Feature> *arena, double lambda, double minSplitGain, double minTreeSize,
+                      int maxDepth)
+    {
+        if (arena == nullptr)
+        {
+            return Ptr(new BasicTreeNode(lambda, minSplitGain, minTreeSize, maxDepth));
+        }
+        return Ptr(arena->nodes.create(lambda, minSplitGain, minTreeSize, maxDepth), Deleter(&arena->nodes));
+    }
+
+    explicit BasicTreeNode(double lambda, double minSplitGain, double minTreeSize, int maxDepth)
     {
         _lambda = lambda;
         _minSplitGain = minSplitGain;
@@ -74,13 +379,47 @@ public:
         return -std::accumulate(gradient.begin(), gradient.end(), 0.0) / (std::accumulate(hessian.begin(), hessian.end(), 0.0) + _lambda);
     }
 
+    /**
+          * Turn the node into a leaf and add its weight to the raw scores of the training samples reaching it
+          *
+          * @param trainSet Train dataset of the node
+          * @param gradient Gradient vector
+          * @param hessian Hessian vector
+          * @param shrinkage Current shrinkage parameter
+          * @param trainScores Raw scores of all training samples, indexed by global row index
+          * @param stats Construction counters of the tree, if any
+          */
+    void makeLeaf(const BasicDataset<Feature> &trainSet,
+                  const Vector &gradient,
+                  const Vector &hessian,
+                  double shrinkage,
+                  Vector &trainScores,
+                  BuildStats *stats = nullptr)
+    {
+        PhaseTimer timer(stats ? &stats->leafMillis : nullptr);
+        if (stats != nullptr)
+        {
+            stats->numNodes++;
+            stats->numLeaves++;
+        }
+
+        this->_isLeaf = true;
+        this->_weight = this->calc_leaf_weight(gradient, hessian) * shrinkage;
+
+        for (size_t rowIndex : trainSet.rowIter())
+        {
+            trainScores[rowIndex] += this->_weight;
+        }
+    }
+
     /**
          * Recursively (and greedily) split a TreeNode based on
          *
          * Exact Greedy Algorithm for Split Finding:
          * 1) For each tree node, enumerate over all features:
          * 2) For each feature, sorted the instances by feature numeric value
-         * 3) Use a linear scan to decide the best split along that feature (if categorical perform Mean Target Encoding)
+         * 3) Use a linear scan to decide the best split along that feature (if categorical, over its categories
+         *    sorted by gradient / Hessian ratio)
          * 4) Take the best split solution (that maximises gain reduction) over all features
          * 5) Recurse on the left and right side of the best split
          *
@@ -92,66 +431,232 @@ public:
          * @param hessian Hessian vector
          * @param shrinkage Current shrinkage parameter
          * @param depth Current depth on building process
+         * @param splitter Split finding strategy (exact greedy or histogram based)
+         * @param levelFeatures Candidate split features per depth (a subset of the features of trainSet), or
+         *                      empty if all features of trainSet are candidates
+         * @param trainScores Raw scores of all training samples (indexed by global row index), incremented by
+         *                    the weight of the leaf that each sample reaches
+         * @param statistics Statistics of the splitter for trainSet, if derived from the parent node
+         * @param stats Construction counters of the tree, if any
+         * @param arena Arena of the nodes and buffers of the subtree, if any
          */
-    void build(const Dataset &trainSet,
+    void build(const BasicDataset<Feature> &trainSet,
                const Vector &previousPreds,
                const Vector &gradient,
                const Vector &hessian,
                double shrinkage,
-               int depth)
+               int depth,
+               const BasicSplitter<Feature> &splitter,
+               const std::vector<VectorT> &levelFeatures,
+               Vector &trainScores,
+               std::unique_ptr<NodeStatistics> statistics = nullptr,
+               BuildStats *stats = nullptr,
+               BasicTreeArena<Feature> *arena = nullptr)
     {
 
         // Check if depth is reached
         if (depth > _maxDepth)
         {
-            this->_isLeaf = true;
-            this->_weight = this->calc_leaf_weight(gradient, hessian) * shrinkage;
+            this->makeLeaf(trainSet, gradient, hessian, shrinkage, trainScores, stats);
             return;
         }
 
         // Check if # of sample is too small
         if (trainSet.nRows() <= _minTreeSize)
         {
-            this->_isLeaf = true;
-            this->_weight = this->calc_leaf_weight(gradient, hessian) * shrinkage;
+            releaseStatistics(statistics, arena);
+            this->makeLeaf(trainSet, gradient, hessian, shrinkage, trainScores, stats);
             return;
         }
 
-        // Initialize a numeric splitter and find best split
-        std::unique_ptr<microgbt::Splitter> splitter = make_unique<microgbt::NumericalSplitter>(_lambda);
-        SplitInfo bestGain = splitter->findBestSplit(trainSet, gradient, hessian);
+        // Find best split
+        SplitInfo bestGain = findBestSplit(trainSet, gradient, hessian, splitter,
+                                           candidateFeatures(trainSet, levelFeatures, depth), statistics, stats,
+                                           arena);
 
         // Check if best gain is less than minimum split gain (threshold)
         if (bestGain.bestGain() < this->_minSplitGain)
         {
-            this->_isLeaf = true;
-            this->_weight = this->calc_leaf_weight(gradient, hessian) * shrinkage;
+            releaseStatistics(statistics, arena);
+            this->makeLeaf(trainSet, gradient, hessian, shrinkage, trainScores, stats);
             return;
         }
 
         // Update feature index and numeric value of optimal greedy split
         this->_splitFeatureIndex = bestGain.getBestFeatureId();
         this->_splitNumericValue = bestGain.splitValue();
+        this->_defaultLeft = bestGain.defaultLeft();
+        this->_categories = bestGain.categories();
 
-        // Recurse on left and right subtree
-        Dataset leftDataset(trainSet, bestGain, SplitInfo::Side::Left);
-        Vector leftGradient = bestGain.split(gradient, SplitInfo::Side::Left);
-        Vector leftHessian = bestGain.split(hessian, SplitInfo::Side::Left);
-        Vector leftPreviousPreds = bestGain.split(previousPreds, SplitInfo::Side::Left);
-        this->leftSubTree = std::unique_ptr<TreeNode>(
-            new TreeNode(_lambda, _minSplitGain, _minTreeSize, _maxDepth));
-        leftSubTree->build(leftDataset, leftPreviousPreds, leftGradient, leftHessian, shrinkage, depth + 1);
+        // Recurse on left and right subtree; their datasets and vectors are buffers of the arena, if any
+        PhaseTimer partitionTimer(stats ? &stats->partitionMillis : nullptr);
+        BufferPool<Vector> *pool = arena ? &arena->values : nullptr;
+        BasicDataset<Feature> leftDataset(trainSet, bestGain, SplitInfo::Side::Left, arena);
+        size_t leftRows = bestGain.numLocalIds(SplitInfo::Side::Left);
+        PooledBuffer<Vector> leftGradientBuffer(pool, leftRows), leftHessianBuffer(pool, leftRows);
+        PooledBuffer<Vector> leftPredsBuffer(pool, leftRows);
+        Vector &leftGradient = *leftGradientBuffer, &leftHessian = *leftHessianBuffer;
+        Vector &leftPreviousPreds = *leftPredsBuffer;
+        bestGain.split(gradient, SplitInfo::Side::Left, leftGradient);
+        bestGain.split(hessian, SplitInfo::Side::Left, leftHessian);
+        bestGain.split(previousPreds, SplitInfo::Side::Left, leftPreviousPreds);
 
-        Dataset rightDataset(trainSet, bestGain, SplitInfo::Side::Right);
-        Vector rightGradient = bestGain.split(gradient, SplitInfo::Side::Right);
-        Vector rightHessian = bestGain.split(hessian, SplitInfo::Side::Right);
-        Vector rightPreviousPreds = bestGain.split(previousPreds, SplitInfo::Side::Right);
+        BasicDataset<Feature> rightDataset(trainSet, bestGain, SplitInfo::Side::Right, arena);
+        size_t rightRows = bestGain.numLocalIds(SplitInfo::Side::Right);
+        PooledBuffer<Vector> rightGradientBuffer(pool, rightRows), rightHessianBuffer(pool, rightRows);
+        PooledBuffer<Vector> rightPredsBuffer(pool, rightRows);
+        Vector &rightGradient = *rightGradientBuffer, &rightHessian = *rightHessianBuffer;
+        Vector &rightPreviousPreds = *rightPredsBuffer;
+        bestGain.split(gradient, SplitInfo::Side::Right, rightGradient);
+        bestGain.split(hessian, SplitInfo::Side::Right, rightHessian);
+        bestGain.split(previousPreds, SplitInfo::Side::Right, rightPreviousPreds);
+        partitionTimer.stop();
+        countSplit(stats, trainSet, leftDataset, rightDataset);
 
-        this->rightSubTree = std::unique_ptr<TreeNode>(
-            new TreeNode(_lambda, _minSplitGain, _minTreeSize, _maxDepth));
-        rightSubTree->build(rightDataset, rightPreviousPreds, rightGradient, rightHessian, shrinkage, depth + 1);
+        // Children are split only below the maximum depth, hence their statistics are needed only then
+        std::unique_ptr<NodeStatistics> leftStatistics, rightStatistics;
+        if (depth + 1 <= _maxDepth)
+        {
+            childStatistics(statistics.get(), leftDataset, leftGradient, leftHessian,
+                            rightDataset, rightGradient, rightHessian, splitter, leftStatistics, rightStatistics,
+                            stats, arena);
+        }
+        releaseStatistics(statistics, arena);
+
+        this->leftSubTree = newChild(arena);
+        leftSubTree->build(leftDataset, leftPreviousPreds, leftGradient, leftHessian, shrinkage, depth + 1, splitter,
+                           levelFeatures, trainScores, std::move(leftStatistics), stats, arena);
+
+        this->rightSubTree = newChild(arena);
+        rightSubTree->build(rightDataset, rightPreviousPreds, rightGradient, rightHessian, shrinkage, depth + 1,
+                            splitter, levelFeatures, trainScores, std::move(rightStatistics), stats, arena);
+    }
+
+    /**
+         * Grow the tree rooted at this node leaf-wise (best-first), i.e., keep a priority queue of the leaves keyed
+         * by the gain of their best split and always split the leaf with the largest gain, until the tree has
+         * maxLeaves leaves or no leaf can be split.
+         *
+         * Each split satisfies the same constraints as in build (maximum depth, minimum tree size and minimum split
+         * gain); hence, if maxLeaves is large enough, the tree is identical to the one of build.
+         *
+         * @param trainSet Train dataset
+         * @param previousPreds
+         * @param gradient Gradient vector
+         * @param hessian Hessian vector
+         * @param shrinkage Current shrinkage parameter
+         * @param maxLeaves Maximum number of leaves
+         * @param splitter Split finding strategy (exact greedy or histogram based)
+         * @param levelFeatures Candidate split features per depth (a subset of the features of trainSet), or
+         *                      empty if all features of trainSet are candidates
+         * @param trainScores Raw scores of all training samples (indexed by global row index), incremented by
+         *                    the weight of the leaf that each sample reaches
+         * @param stats Construction counters of the tree, if any
+         * @param arena Arena of the nodes and buffers of the tree, if any
+         */
+    void buildLeafWise(const BasicDataset<Feature> &trainSet,
+                       const Vector &previousPreds,
+                       const Vector &gradient,
+                       const Vector &hessian,
+                       double shrinkage,
+                       int maxLeaves,
+                       const BasicSplitter<Feature> &splitter,
+                       const std::vector<VectorT> &levelFeatures,
+                       Vector &trainScores,
+                       BuildStats *stats = nullptr,
+                       BasicTreeArena<Feature> *arena = nullptr)
+    {
+        // Max-heap of the leaves that may be split, at most one per leaf
+        std::vector<CandidatePtr> heap;
+        heap.reserve(static_cast<size_t>(std::max(maxLeaves, 1)));
+        size_t numCandidates = 0;
+        int numLeaves = 1;
+
+        // Find the best split of a new leaf, and either push it into the heap or finalize it as a leaf
+        auto addLeaf = [&](CandidatePtr candidate) {
+            candidate->order = numCandidates++;
+            if (candidate->depth <= _maxDepth && candidate->trainSet->nRows() > _minTreeSize)
+            {
+                candidate->split = findBestSplit(*candidate->trainSet, *candidate->gradient, *candidate->hessian,
+                                                 splitter,
+                                                 candidateFeatures(*candidate->trainSet, levelFeatures,
+                                                                   candidate->depth),
+                                                 candidate->statistics, stats, arena);
+            }
+
+            if (canSplit(*candidate))
+            {
+                heap.push_back(std::move(candidate));
+                std::push_heap(heap.begin(), heap.end(), lowerPriority);
+            }
+            else
+            {
+                candidate->node->makeLeaf(*candidate->trainSet, *candidate->gradient, *candidate->hessian, shrinkage,
+                                          trainScores, stats);
+            }
+        };
+
+        addLeaf(newCandidate(arena, this, trainSet, previousPreds, gradient, hessian));
+
+        while (!heap.empty())
+        {
+            std::pop_heap(heap.begin(), heap.end(), lowerPriority);
+            CandidatePtr best = std::move(heap.back());
+            heap.pop_back();
+
+            // The leaf budget is exhausted, hence the remaining leaves are finalized
+            if (numLeaves >= maxLeaves)
+            {
+                best->node->makeLeaf(*best->trainSet, *best->gradient, *best->hessian, shrinkage, trainScores, stats);
+                continue;
+            }
+
+            BasicTreeNode *node = best->node;
+            const SplitInfo &split = best->split;
+            node->_splitFeatureIndex = split.getBestFeatureId();
+            node->_splitNumericValue = split.splitValue();
+            node->_defaultLeft = split.defaultLeft();
+            node->_categories = split.categories();
+            node->leftSubTree = newChild(arena);
+            node->rightSubTree = newChild(arena);
+            numLeaves++;
+
+            PhaseTimer partitionTimer(stats ? &stats->partitionMillis : nullptr);
+            CandidatePtr left = newCandidate(arena, node->leftSubTree.get(), *best, SplitInfo::Side::Left);
+            CandidatePtr right = newCandidate(arena, node->rightSubTree.get(), *best, SplitInfo::Side::Right);
+            partitionTimer.stop();
+            countSplit(stats, *best->trainSet, *left->trainSet, *right->trainSet);
+            if (best->depth + 1 <= _maxDepth)
+            {
+                childStatistics(best->statistics.get(), *left->trainSet, *left->gradient, *left->hessian,
+                                *right->trainSet, *right->gradient, *right->hessian, splitter,
+                                left->statistics, right->statistics, stats, arena);
+            }
+            best.reset();
+
+            addLeaf(std::move(left));
+            addLeaf(std::move(right));
+        }
     }
 
+    inline bool isLeaf() const { return _isLeaf; }
+
+    inline double weight() const { return _weight; }
+
+    inline long splitFeatureIndex() const { return _splitFeatureIndex; }
+
+    inline double splitValue() const { return _splitNumericValue; }
+
+    inline bool defaultLeft() const { return _defaultLeft; }
+
+    inline bool isCategorical() const { return !_categories.empty(); }
+
+    inline const std::vector<uint32_t> &categories() const { return _categories; }
+
+    inline const BasicTreeNode *left() const { return leftSubTree.get(); }
+
+    inline const BasicTreeNode *right() const { return rightSubTree.get(); }
+
     /**
          * Return the score for a given sample, i.e. set of features
          *
@@ -164,7 +669,10 @@ public:
         {
             return this->_weight;
         }
-        else if (sample[this->_splitFeatureIndex] < this->_splitNumericValue)
+        else if (this->isCategorical()
+                     ? CategorySet::contains(_categories.data(), _categories.size(), sample[this->_splitFeatureIndex])
+                     : (sample[this->_splitFeatureIndex] < this->_splitNumericValue ||
+                        (this->_defaultLeft && std::isnan(sample[this->_splitFeatureIndex]))))
         {
             return this->leftSubTree->score(sample);
         }
@@ -174,4 +682,23 @@ public:
         }
     }
 };
+
+/**
+     * Arena of tree construction: the nodes and leaf-wise candidates of trees (see ObjectPool) and the buffers of
+     * their datasets and gradient / Hessian vectors (see ScratchArena). If the arena is kept across boosting rounds,
+     * the nodes and buffers of a destroyed tree are reused by the trees built next, i.e., steady-state training
+     * barely allocates per node.
+     */
+template <typename Feature>
+class BasicTreeArena : public ScratchArena
+{
+public:
+    ObjectPool<BasicTreeNode<Feature>> nodes;
+
+    // Leaves of trees grown leaf-wise, see BasicTreeNode::buildLeafWise
+    ObjectPool<typename BasicTreeNode<Feature>::Candidate> candidates;
+};
+
+using TreeNode = BasicTreeNode<double>;
+using TreeArena = BasicTreeArena<double>;
 } // namespace microgbt
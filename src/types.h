@@ -2,12 +2,31 @@
 #include <vector>
 #include <Eigen/Dense>
 
+#include "utils/aligned_allocator.h"
+
 namespace microgbt
 {
 
-using Vector = std::vector<double>;
-using VectorD = std::vector<double>;
+// Vectors of doubles are cache-line aligned, see utils/aligned_allocator.h
+using Vector = std::vector<double, AlignedAllocator<double>>;
+using VectorD = Vector;
 using VectorT = std::vector<size_t>;
 using MatrixType = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor>;
 using SortedMatrixType = Eigen::Matrix<int, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor>;
+
+// Read-only view of a double matrix of any memory layout (e.g., a row-major or column-major numpy array)
+using ConstMatrixRef = Eigen::Ref<const MatrixType, 0, Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>>;
+
+// Read-only view of a column-major double matrix with contiguous columns (e.g., a Fortran-ordered numpy array)
+using ColMajorMatrixRef = Eigen::Ref<const MatrixType>;
+
+// Column-major matrix of stored feature values, see BasicDataset
+template <typename Feature>
+using FeatureMatrix = Eigen::Matrix<Feature, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor>;
+
+// Read-only map of a caller-owned column-major buffer with contiguous columns, see BasicDataset
+template <typename Feature>
+using FeatureMatrixView = Eigen::Map<const FeatureMatrix<Feature>, 0, Eigen::OuterStride<>>;
+
+using MatrixView = FeatureMatrixView<double>;
 } // namespace microgbt
\ No newline at end of file
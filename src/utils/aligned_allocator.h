@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace microgbt
+{
+
+/**
+     * Standard allocator whose allocations are aligned to Alignment bytes (a cache line by default).
+     *
+     * The objective kernels (see metrics/kernels.h) use unaligned loads and stores, since they also process
+     * sub-ranges of buffers. On a buffer that starts at a cache line, their 32-byte (AVX2) and 64-byte (AVX-512)
+     * accesses from the start of the buffer never straddle two cache lines.
+     */
+template <typename T, size_t Alignment = 64>
+class AlignedAllocator
+{
+public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &) {}
+
+    T *allocate(size_t n)
+    {
+        void *data = nullptr;
+        if (n > 0 && posix_memalign(&data, Alignment, n * sizeof(T)) != 0)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T *>(data);
+    }
+
+    void deallocate(T *data, size_t) { std::free(data); }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment> &) const { return true; }
+
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment> &) const { return false; }
+};
+} // namespace microgbt
@@ -0,0 +1,243 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <utility>
+#include <cstddef>
+#include <type_traits>
+
+#include "../types.h"
+#include "../trees/node_statistics.h"
+
+namespace microgbt
+{
+
+/**
+     * Pool of objects of type T, allocated in chunks of ChunkSize objects. The storage of destroyed objects is reused
+     * by the objects created next, i.e., once the pool has grown to the number of live objects, creating and
+     * destroying objects does not allocate.
+     */
+template <typename T>
+class ObjectPool
+{
+    static constexpr size_t ChunkSize = 64;
+
+    using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+    std::vector<std::unique_ptr<Storage[]>> _chunks;
+
+    // Storage that holds no object
+    std::vector<Storage *> _free;
+
+public:
+    ObjectPool() = default;
+
+    ObjectPool(const ObjectPool &) = delete;
+    ObjectPool &operator=(const ObjectPool &) = delete;
+
+    /**
+         * Construct an object in the pool; it must be destroyed by destroy before the pool is
+         */
+    template <typename... Args>
+    T *create(Args &&... args)
+    {
+        if (_free.empty())
+        {
+            _chunks.emplace_back(new Storage[ChunkSize]);
+            _free.reserve(_chunks.size() * ChunkSize);
+            for (size_t i = ChunkSize; i > 0; i--)
+            {
+                _free.push_back(&_chunks.back()[i - 1]);
+            }
+        }
+
+        Storage *storage = _free.back();
+        T *object = new (storage) T(std::forward<Args>(args)...);
+        _free.pop_back();
+        return object;
+    }
+
+    void destroy(T *object)
+    {
+        object->~T();
+        _free.push_back(reinterpret_cast<Storage *>(object));
+    }
+
+    /**
+         * Number of objects the pool holds storage for
+         */
+    inline size_t capacity() const { return _chunks.size() * ChunkSize; }
+};
+
+/**
+     * Pool of released buffers (vectors) that are handed out again instead of allocating new ones
+     */
+template <typename Buffer>
+class BufferPool
+{
+    std::vector<Buffer> _free;
+
+public:
+    /**
+         * Return a buffer of size elements (with unspecified values): the smallest released buffer that holds them
+         * without reallocation, otherwise the largest released buffer (grown) or a new one
+         */
+    Buffer acquire(size_t size)
+    {
+        size_t none = _free.size(), best = none;
+        for (size_t i = 0; i < _free.size(); i++)
+        {
+            if (_free[i].capacity() >= size && (best == none || _free[i].capacity() < _free[best].capacity()))
+            {
+                best = i;
+            }
+        }
+        bool fits = best != none;
+        for (size_t i = 0; i < _free.size() && !fits; i++)
+        {
+            if (best == none || _free[i].capacity() > _free[best].capacity())
+            {
+                best = i;
+            }
+        }
+
+        Buffer buffer;
+        if (best < _free.size())
+        {
+            buffer = std::move(_free[best]);
+            std::swap(_free[best], _free.back());
+            _free.pop_back();
+        }
+        buffer.resize(size);
+        return buffer;
+    }
+
+    /**
+         * Return a buffer to the pool; buffers without capacity (e.g., moved from) are dropped
+         */
+    void release(Buffer &&buffer)
+    {
+        if (buffer.capacity() > 0)
+        {
+            _free.push_back(std::move(buffer));
+        }
+    }
+
+    inline size_t size() const { return _free.size(); }
+};
+
+/**
+     * Buffer of a pool that is released to the pool on destruction, or a plain buffer if there is no pool
+     */
+template <typename Buffer>
+class PooledBuffer
+{
+    BufferPool<Buffer> *_pool;
+    Buffer _buffer;
+
+    void release()
+    {
+        if (_pool)
+        {
+            _pool->release(std::move(_buffer));
+        }
+        _buffer = Buffer();
+    }
+
+public:
+    /**
+         * Empty buffer without pool
+         */
+    PooledBuffer() : _pool(nullptr) {}
+
+    /**
+         * @param pool Pool of the buffer, if any; it must outlive the buffer
+         * @param size Number of elements (with unspecified values)
+         */
+    PooledBuffer(BufferPool<Buffer> *pool, size_t size)
+        : _pool(pool), _buffer(pool ? pool->acquire(size) : Buffer(size)) {}
+
+    PooledBuffer(const PooledBuffer &) = delete;
+    PooledBuffer &operator=(const PooledBuffer &) = delete;
+
+    PooledBuffer(PooledBuffer &&other) noexcept : _pool(other._pool), _buffer(std::move(other._buffer)) {}
+
+    /**
+         * Release the buffer to its pool and take over the one of other
+         */
+    PooledBuffer &operator=(PooledBuffer &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            _pool = other._pool;
+            _buffer = std::move(other._buffer);
+        }
+        return *this;
+    }
+
+    ~PooledBuffer() { release(); }
+
+    inline Buffer &operator*() { return _buffer; }
+
+    inline const Buffer &operator*() const { return _buffer; }
+
+    inline Buffer *operator->() { return &_buffer; }
+
+    inline const Buffer *operator->() const { return &_buffer; }
+};
+
+/**
+     * Pool of released node statistics (see NodeStatistics) that are handed out again instead of allocating new ones
+     */
+class StatisticsPool
+{
+    std::vector<std::unique_ptr<NodeStatistics>> _free;
+
+public:
+    /**
+         * Return the last released statistics if they are of type Statistics, otherwise nullptr
+         */
+    template <typename Statistics>
+    std::unique_ptr<Statistics> acquire()
+    {
+        if (_free.empty() || dynamic_cast<Statistics *>(_free.back().get()) == nullptr)
+        {
+            return nullptr;
+        }
+
+        std::unique_ptr<Statistics> statistics(static_cast<Statistics *>(_free.back().release()));
+        _free.pop_back();
+        return statistics;
+    }
+
+    /**
+         * Return statistics to the pool, if any
+         */
+    void release(std::unique_ptr<NodeStatistics> &&statistics)
+    {
+        if (statistics)
+        {
+            _free.push_back(std::move(statistics));
+        }
+    }
+
+    inline size_t size() const { return _free.size(); }
+};
+
+/**
+     * Buffers of the datasets and gradient / Hessian vectors of tree nodes, see BasicDataset and BasicTreeNode, and
+     * the statistics of the splitter per node.
+     *
+     * The buffers of a node are released when its subtree is built, and reused by the nodes built next (and by the
+     * trees of the next boosting rounds, if the arena is kept), so that tree construction stops allocating once
+     * the pools cover the nodes that are alive at the same time. The arena is not thread-safe.
+     */
+class ScratchArena
+{
+public:
+    BufferPool<std::vector<int>> ints;
+    BufferPool<VectorT> indices;
+    BufferPool<Vector> values;
+    StatisticsPool statistics;
+};
+} // namespace microgbt
@@ -0,0 +1,148 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+
+namespace microgbt
+{
+
+/**
+     * A fixed-size pool of worker threads that executes "parallel for" loops.
+     *
+     * The threads are created once and reused by every loop, so that short loops (e.g., over the features of a
+     * single tree node) do not pay for thread creation. The calling thread takes part in every loop.
+     */
+class ThreadPool
+{
+
+    // Worker threads, i.e., all threads except the calling one
+    std::vector<std::thread> _workers;
+
+    // Serializes concurrent loops of different callers
+    std::mutex _loopMutex;
+
+    // Protects the state of the current loop below
+    std::mutex _mutex;
+    std::condition_variable _wakeUp, _done;
+
+    // Current loop: task, number of iterations, next iteration to run
+    const std::function<void(size_t)> *_task = nullptr;
+    size_t _numTasks = 0;
+    std::atomic<size_t> _nextTask;
+
+    // Number of workers still running the current loop, loop counter and shutdown flag
+    size_t _activeWorkers = 0;
+    unsigned long _generation = 0;
+    bool _stop = false;
+
+    void runTasks()
+    {
+        for (size_t i = _nextTask.fetch_add(1); i < _numTasks; i = _nextTask.fetch_add(1))
+        {
+            (*_task)(i);
+        }
+    }
+
+    void workerLoop()
+    {
+        unsigned long seenGeneration = 0;
+        while (true)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wakeUp.wait(lock, [&] { return _stop || _generation != seenGeneration; });
+            if (_stop)
+            {
+                return;
+            }
+            seenGeneration = _generation;
+            lock.unlock();
+
+            runTasks();
+
+            lock.lock();
+            if (--_activeWorkers == 0)
+            {
+                _done.notify_all();
+            }
+        }
+    }
+
+public:
+    /**
+         * Create a pool that runs loops on numThreads threads (including the calling thread)
+         *
+         * @param numThreads Number of threads; if non-positive, the number of hardware threads is used
+         */
+    explicit ThreadPool(int numThreads) : _nextTask(0)
+    {
+        if (numThreads <= 0)
+        {
+            numThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        }
+
+        for (int i = 1; i < numThreads; i++)
+        {
+            _workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _wakeUp.notify_all();
+        for (std::thread &worker : _workers)
+        {
+            worker.join();
+        }
+    }
+
+    inline int numThreads() const { return static_cast<int>(_workers.size()) + 1; }
+
+    /**
+         * Run task(0), ..., task(numTasks - 1) on the pool threads and wait until all of them are done.
+         *
+         * Tasks must be independent of each other; the order in which they run is unspecified.
+         *
+         * @param numTasks Number of iterations
+         * @param task Loop body, invoked with the iteration index
+         */
+    void parallelFor(size_t numTasks, const std::function<void(size_t)> &task)
+    {
+        if (_workers.empty() || numTasks <= 1)
+        {
+            for (size_t i = 0; i < numTasks; i++)
+            {
+                task(i);
+            }
+            return;
+        }
+
+        std::lock_guard<std::mutex> loopLock(_loopMutex);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _task = &task;
+            _numTasks = numTasks;
+            _nextTask = 0;
+            _activeWorkers = _workers.size();
+            _generation++;
+        }
+        _wakeUp.notify_all();
+
+        runTasks();
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait(lock, [&] { return _activeWorkers == 0; });
+        _task = nullptr;
+    }
+};
+} // namespace microgbt
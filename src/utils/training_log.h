@@ -0,0 +1,181 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <chrono>
+#include <utility>
+#include <cstddef>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+namespace microgbt
+{
+
+/**
+     * Verbosity of training
+     *
+     * Silent: nothing is written
+     * Info: one line per iteration (losses and duration) and the early stopping message
+     * Debug: the iteration lines include the phase durations and the tree construction counters
+     */
+enum class LogLevel
+{
+    Silent = 0,
+    Info = 1,
+    Debug = 2
+};
+
+/**
+     * Counters of the construction of a tree
+     */
+struct BuildStats
+{
+    // Duration of split finding (including the statistics of the splitter, e.g., histograms), of partitioning
+    // nodes into their children, and of adding leaf weights to the scores of the training samples
+    double splitMillis = 0.0, partitionMillis = 0.0, leafMillis = 0.0;
+
+    long numNodes = 0, numLeaves = 0;
+
+    // Rows scanned by split finding and by partitioning
+    long rowsTouched = 0;
+
+    // Bytes allocated for the datasets, gradient / Hessian vectors and splitter statistics of the nodes
+    size_t bytesAllocated = 0;
+};
+
+/**
+     * Metrics of a boosting iteration, see TrainingLog
+     */
+struct IterationStats
+{
+    long iteration = 0;
+
+    // Wall time of the iteration and of its phases: gradients and Hessians (and sampling), split finding,
+    // partitioning, prediction (score updates of the training and validation samples) and loss evaluation
+    double totalMillis = 0.0, gradientMillis = 0.0, predictionMillis = 0.0, evaluationMillis = 0.0;
+
+    // Counters of the tree of the iteration; its split finding and partitioning durations are phases
+    BuildStats tree;
+
+    double trainLoss = 0.0, validLoss = 0.0;
+
+    /**
+         * Named values of the metrics, in a fixed order
+         */
+    std::vector<std::pair<std::string, double>> fields() const
+    {
+        return {{"iteration", static_cast<double>(iteration)},
+                {"total_ms", totalMillis},
+                {"gradient_ms", gradientMillis},
+                {"split_ms", tree.splitMillis},
+                {"partition_ms", tree.partitionMillis},
+                {"prediction_ms", predictionMillis},
+                {"evaluation_ms", evaluationMillis},
+                {"num_nodes", static_cast<double>(tree.numNodes)},
+                {"num_leaves", static_cast<double>(tree.numLeaves)},
+                {"rows_touched", static_cast<double>(tree.rowsTouched)},
+                {"bytes_allocated", static_cast<double>(tree.bytesAllocated)},
+                {"train_loss", trainLoss},
+                {"valid_loss", validLoss}};
+    }
+};
+
+/**
+     * Accumulates the wall time from its construction to stop() (or its destruction) into a counter, if any
+     */
+class PhaseTimer
+{
+
+    double *_millis;
+    std::chrono::steady_clock::time_point _start;
+
+public:
+    /**
+         * @param millis Counter in milliseconds; if nullptr, nothing is timed
+         */
+    explicit PhaseTimer(double *millis) : _millis(millis)
+    {
+        if (_millis != nullptr)
+        {
+            _start = std::chrono::steady_clock::now();
+        }
+    }
+
+    PhaseTimer(const PhaseTimer &) = delete;
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+    ~PhaseTimer() { stop(); }
+
+    void stop()
+    {
+        if (_millis != nullptr)
+        {
+            *_millis += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+            _millis = nullptr;
+        }
+    }
+};
+
+/**
+     * History of the metrics of the iterations of a training run, written to a stream according to a log level
+     */
+class TrainingLog
+{
+
+    LogLevel _level = LogLevel::Info;
+
+    std::ostream *_out = &std::cout;
+
+    std::vector<IterationStats> _history;
+
+public:
+    inline LogLevel level() const { return _level; }
+
+    inline void setLevel(LogLevel level) { _level = level; }
+
+    /**
+         * @param out Output stream, which must outlive the log
+         */
+    inline void setStream(std::ostream &out) { _out = &out; }
+
+    inline const std::vector<IterationStats> &history() const { return _history; }
+
+    inline void clear() { _history.clear(); }
+
+    /**
+         * Write a message if the log level is at least level
+         */
+    void message(LogLevel level, const std::string &text) const
+    {
+        if (_level >= level)
+        {
+            *_out << text << '\n';
+        }
+    }
+
+    /**
+         * Append the metrics of an iteration to the history and write them
+         */
+    void record(const IterationStats &stats)
+    {
+        _history.push_back(stats);
+        if (_level == LogLevel::Silent)
+        {
+            return;
+        }
+
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(3) << "[Iteration " << stats.iteration << "] train loss "
+             << stats.trainLoss << " | valid loss " << stats.validLoss << " | " << stats.totalMillis << " ms";
+        if (_level >= LogLevel::Debug)
+        {
+            line << " (gradient " << stats.gradientMillis << ", split " << stats.tree.splitMillis << ", partition "
+                 << stats.tree.partitionMillis << ", prediction " << stats.predictionMillis << ", evaluation "
+                 << stats.evaluationMillis << ") | " << stats.tree.numNodes << " nodes, " << stats.tree.numLeaves
+                 << " leaves, " << stats.tree.rowsTouched << " rows touched, " << stats.tree.bytesAllocated
+                 << " bytes allocated";
+        }
+        message(LogLevel::Info, line.str());
+    }
+};
+} // namespace microgbt
@@ -0,0 +1,227 @@
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+#include <binned_matrix.h>
+#include <trees/tree.h>
+#include <trees/histogram_splitter.h>
+#include "gtest/gtest.h"
+
+using namespace microgbt;
+
+namespace
+{
+// Number of allocations of the test binary
+long numAllocations = 0;
+
+long numNodes(const TreeNode *node)
+{
+    return node->isLeaf() ? 1 : 1 + numNodes(node->left()) + numNodes(node->right());
+}
+
+Eigen::MatrixXd trainMatrix(long m)
+{
+    Eigen::MatrixXd X(m, 4);
+    for (long i = 0; i < m; i++)
+    {
+        X(i, 0) = static_cast<double>(i % 17);
+        X(i, 1) = static_cast<double>((i * 13) % 101);
+        X(i, 2) = static_cast<double>(i) / m;
+        X(i, 3) = static_cast<double>((i * 7) % 5);
+    }
+    return X;
+}
+
+Vector trainTarget(long m)
+{
+    Vector y(m);
+    for (long i = 0; i < m; i++)
+    {
+        y[i] = (i % 17 < 6 || (i * 13) % 101 > 70) ? 1.0 : 0.0;
+    }
+    return y;
+}
+
+/**
+     * Build a tree on gradients of a round, and return the number of allocations during the build
+     */
+long buildAllocations(Tree &tree, const Dataset &dataset, const Vector &preds, long round)
+{
+    long m = dataset.nRows();
+    Vector gradient(m), hessian(m, 1.0), trainScores(dataset.numGlobalRows(), 0.0);
+    for (long i = 0; i < m; i++)
+    {
+        gradient[i] = preds[i] - dataset.y()[i] + 0.01 * static_cast<double>((i * round) % 7);
+    }
+
+    long before = numAllocations;
+    tree.build(dataset, preds, gradient, hessian, 1.0, trainScores);
+    return numAllocations - before;
+}
+} // namespace
+
+#if defined(__GLIBC__)
+// Every allocation is counted: operator new, Eigen buffers and aligned buffers (see AlignedAllocator) call malloc
+// or posix_memalign, which are replaced by wrappers of the ones of glibc
+extern "C"
+{
+    void *__libc_malloc(std::size_t size);
+    void *__libc_memalign(std::size_t alignment, std::size_t size);
+
+    void *malloc(std::size_t size) noexcept
+    {
+        numAllocations++;
+        return __libc_malloc(size);
+    }
+
+    int posix_memalign(void **data, std::size_t alignment, std::size_t size) noexcept
+    {
+        numAllocations++;
+        *data = __libc_memalign(alignment, size);
+        return (*data == nullptr) ? ENOMEM : 0;
+    }
+}
+#else
+// Only allocations of operator new are counted
+void *operator new(std::size_t size)
+{
+    numAllocations++;
+    void *data = std::malloc(size > 0 ? size : 1);
+    if (data == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return data;
+}
+
+// GCC flags free of memory of operator new once the replaced operators are inlined
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *data) noexcept
+{
+    std::free(data);
+}
+#endif
+
+TEST(Arena, ObjectPoolReusesStorage)
+{
+    ObjectPool<TreeNode> pool;
+    TreeNode *node = pool.create(1.0, 0.0, 2.0, 3);
+    pool.destroy(node);
+    ASSERT_EQ(pool.capacity(), 64u);
+
+    long before = numAllocations;
+    TreeNode *reused = pool.create(1.0, 0.0, 2.0, 3);
+    ASSERT_EQ(reused, node);
+    ASSERT_EQ(numAllocations, before);
+    pool.destroy(reused);
+}
+
+TEST(Arena, BufferPoolHandsOutSmallestFittingBuffer)
+{
+    BufferPool<VectorT> pool;
+    pool.release(VectorT(100));
+    pool.release(VectorT(10));
+    pool.release(VectorT());
+    ASSERT_EQ(pool.size(), 2u);
+
+    long before = numAllocations;
+    VectorT buffer = pool.acquire(8);
+    ASSERT_EQ(buffer.size(), 8u);
+    ASSERT_EQ(buffer.capacity(), 10u);
+    ASSERT_EQ(numAllocations, before);
+
+    // No released buffer fits, i.e., the largest one grows
+    VectorT grown = pool.acquire(200);
+    ASSERT_EQ(grown.size(), 200u);
+    ASSERT_EQ(pool.size(), 0u);
+}
+
+TEST(Arena, SteadyStateTreeBuildBarelyAllocates)
+{
+    long m = 2000;
+    Eigen::MatrixXd X = trainMatrix(m);
+    Vector y = trainTarget(m), preds(m, 0.5);
+    Dataset dataset(X, y);
+    std::shared_ptr<const Splitter> numerical = std::make_shared<NumericalSplitter>(1.0);
+    std::shared_ptr<const Splitter> histogram =
+        std::make_shared<HistogramSplitter>(1.0, std::make_shared<BinnedMatrix>(X, 255));
+
+    // Depth-wise and leaf-wise growth (the latter also allocates its heap of leaves), by both splitters
+    for (const std::shared_ptr<const Splitter> &splitter : {numerical, histogram})
+    {
+        for (int maxLeaves : {0, 16})
+        {
+            SCOPED_TRACE(maxLeaves);
+            auto arena = std::make_shared<TreeArena>();
+
+            // With a new arena, every node allocates its node, index buffers, vectors, partition and statistics
+            Tree plain(1.0, 0.0, 2.0, 5, splitter, maxLeaves);
+            long plainAllocations = buildAllocations(plain, dataset, preds, 1);
+            ASSERT_GT(numNodes(plain.root()), 15);
+
+            // The first round fills the pools of the arena, the next rounds reuse them
+            for (long round = 1; round <= 3; round++)
+            {
+                size_t numValues = arena->values.size(), numInts = arena->ints.size();
+                size_t numIndices = arena->indices.size(), numStatistics = arena->statistics.size();
+                Tree tree(1.0, 0.0, 2.0, 5, splitter, maxLeaves, arena);
+                long allocations = buildAllocations(tree, dataset, preds, round);
+                if (round > 1)
+                {
+                    // The only allocations are the shared owner of the root and the heap of leaves
+                    ASSERT_LE(allocations, maxLeaves > 0 ? 2 : 1);
+                    ASSERT_LT(10 * allocations, plainAllocations);
+                    ASSERT_EQ(arena->values.size(), numValues);
+                    ASSERT_EQ(arena->ints.size(), numInts);
+                    ASSERT_EQ(arena->indices.size(), numIndices);
+                    ASSERT_EQ(arena->statistics.size(), numStatistics);
+                    ASSERT_EQ(arena->nodes.capacity(), 64u);
+                    ASSERT_LE(arena->candidates.capacity(), 64u);
+                }
+            }
+        }
+    }
+}
+
+TEST(Arena, SampledLeafWiseTreeBuildKeepsPoolsFlat)
+{
+    long m = 2000;
+    Eigen::MatrixXd X = trainMatrix(m);
+    Vector y = trainTarget(m);
+    Dataset dataset(X, y);
+    auto splitter = std::make_shared<NumericalSplitter>(1.0);
+    auto arena = std::make_shared<TreeArena>();
+    VectorT features = {0, 1, 3};
+
+    // Every round samples rows and features into a dataset of the arena, as GBT does, and grows a tree leaf-wise
+    for (long round = 1; round <= 8; round++)
+    {
+        VectorT rows;
+        for (long i = 0; i < m; i++)
+        {
+            if (i % 4 != round % 4)
+            {
+                rows.push_back(static_cast<size_t>(i));
+            }
+        }
+        Dataset sample(dataset, rows, features, arena.get());
+        Vector preds(rows.size(), 0.5);
+
+        size_t numValues = arena->values.size(), numInts = arena->ints.size();
+        {
+            // The buffers of a copy are its own, i.e., they are not released to the arena
+            Dataset copy(sample);
+            ASSERT_EQ(copy.nRows(), sample.nRows());
+        }
+        ASSERT_EQ(arena->ints.size(), numInts);
+
+        Tree tree(1.0, 0.0, 2.0, 5, splitter, 16, arena);
+        buildAllocations(tree, sample, preds, round);
+        if (round > 2)
+        {
+            ASSERT_EQ(arena->values.size(), numValues);
+            ASSERT_EQ(arena->ints.size(), numInts);
+        }
+    }
+}
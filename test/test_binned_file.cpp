@@ -0,0 +1,154 @@
+#include <GBT.h>
+#include <io/binned_file.h>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <cmath>
+#include "gtest/gtest.h"
+
+using namespace microgbt;
+
+namespace
+{
+MatrixType regressionData(long m, long n, Vector &y)
+{
+    MatrixType X(m, n);
+    y.resize(m);
+    for (long i = 0; i < m; i++)
+    {
+        for (long j = 0; j < n; j++)
+        {
+            X(i, j) = static_cast<double>((i * (j + 3)) % 41) / 41.0;
+        }
+        X(i, 1) = (i % 13 == 0) ? std::nan("") : X(i, 1);
+        y[i] = X(i, 0) + 2.0 * X(i, 2) * X(i, 3);
+    }
+    return X;
+}
+} // namespace
+
+TEST(BinnedFile, ChunkedWriteAndMappedRead)
+{
+    long m = 1000, n = 4;
+    Vector y;
+    MatrixType X = regressionData(m, n, y);
+    std::string path = testing::TempDir() + "microgbt_bins.bin";
+
+    // Thresholds are fitted to all rows, then rows are appended in chunks
+    BinnedFileWriter writer(path, static_cast<uint64_t>(m), BinnedFileWriter::fitThresholds(X, 32));
+    for (long begin = 0; begin < m; begin += 300)
+    {
+        long rows = std::min(300L, m - begin);
+        writer.append(X.middleRows(begin, rows), y.data() + begin);
+    }
+    writer.close();
+
+    BinnedFile file(path);
+    BinnedMatrix bins(X, 32);
+    ASSERT_EQ(file.rows(), m);
+    ASSERT_EQ(file.numFeatures(), n);
+    ASSERT_TRUE(file.bins()->isMapped());
+    for (long j = 0; j < n; j++)
+    {
+        ASSERT_EQ(file.bins()->thresholds(j), bins.thresholds(j));
+        for (long i = 0; i < m; i++)
+        {
+            ASSERT_EQ(file.bins()->column(j)[i], bins.column(j)[i]);
+        }
+    }
+    for (long i = 0; i < m; i++)
+    {
+        ASSERT_EQ(file.targets()[i], y[i]);
+    }
+    std::remove(path.c_str());
+}
+
+TEST(BinnedFile, IncompleteFileIsRejected)
+{
+    std::string path = testing::TempDir() + "microgbt_incomplete_bins.bin";
+    {
+        BinnedFileWriter writer(path, 10, std::vector<Vector>(2));
+        ASSERT_THROW(writer.close(), std::runtime_error);
+    }
+
+    ASSERT_THROW(BinnedFile file(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(BinnedFile, CorruptedLayoutIsRejected)
+{
+    long m = 100, n = 4;
+    Vector y;
+    MatrixType X = regressionData(m, n, y);
+    std::string path = testing::TempDir() + "microgbt_corrupted_bins.bin";
+    BinnedFileWriter writer(path, static_cast<uint64_t>(m), BinnedFileWriter::fitThresholds(X, 16));
+    writer.append(X, y.data());
+    writer.close();
+
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    BinnedFile::Header header;
+    std::memcpy(&header, bytes.data(), sizeof(BinnedFile::Header));
+
+    // Write the file with a 64-bit value at an offset, and check that mapping it fails
+    auto assertRejected = [&](uint64_t offset, uint64_t value) {
+        std::string corrupted = bytes;
+        std::memcpy(&corrupted[offset], &value, sizeof(value));
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out.write(corrupted.data(), static_cast<std::streamsize>(corrupted.size()));
+        }
+        ASSERT_THROW(BinnedFile file(path), std::runtime_error);
+    };
+
+    assertRejected(offsetof(BinnedFile::Header, targetsOffset), header.fileSize);
+    assertRejected(offsetof(BinnedFile::Header, thresholdOffsetsOffset), header.fileSize - 8);
+    assertRejected(offsetof(BinnedFile::Header, cols), uint64_t(1) << 62);
+
+    // Threshold offsets beyond the file, and decreasing ones
+    uint64_t offsets[3];
+    std::memcpy(offsets, bytes.data() + header.thresholdOffsetsOffset, sizeof(offsets));
+    assertRejected(header.thresholdOffsetsOffset + 8, header.fileSize);
+    assertRejected(header.thresholdOffsetsOffset + 8, offsets[2] + 1);
+    std::remove(path.c_str());
+}
+
+TEST(BinnedFile, OutOfCoreTrainingMatchesInMemoryTraining)
+{
+    long m = 2000, n = 4;
+    Vector y;
+    MatrixType X = regressionData(m, n, y);
+    std::string path = testing::TempDir() + "microgbt_train_bins.bin";
+    BinnedFileWriter::write(path, X, y.data(), 64);
+
+    for (double goss : {0.0, 1.0})
+    {
+        std::map<std::string, double> params{
+            {"lambda", 1.0},
+            {"gamma", 0.1},
+            {"shrinkage_rate", 1.0},
+            {"min_split_gain", 0.0},
+            {"min_tree_size", 2},
+            {"learning_rate", 0.9},
+            {"max_depth", 4.0},
+            {"metric", 1.0},
+            {"tree_method", 1.0},
+            {"max_bin", 64.0},
+            {"goss", goss}};
+        GBT inMemory(params), outOfCore(params);
+        inMemory.trainPython(X, y, X, y, 6, 6);
+        outOfCore.trainOutOfCore(path, Dataset(X, y), 6, 6);
+
+        ASSERT_EQ(outOfCore.forest().numNodes(), inMemory.forest().numNodes());
+        for (long i = 0; i < m; i++)
+        {
+            ASSERT_EQ(outOfCore.predict(X.row(i), 0), inMemory.predict(X.row(i), 0));
+        }
+    }
+    std::remove(path.c_str());
+}
@@ -0,0 +1,123 @@
+#include <GBT.h>
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace microgbt;
+
+namespace
+{
+std::map<std::string, double> params()
+{
+    return {{"lambda", 1.0},
+            {"gamma", 0.0},
+            {"shrinkage_rate", 1.0},
+            {"min_split_gain", 0.0},
+            {"min_tree_size", 2},
+            {"learning_rate", 0.5},
+            {"max_depth", 3.0},
+            {"metric", 0.0},
+            {"verbosity", 0.0}};
+}
+
+bool isPrime(long c)
+{
+    return c == 2 || c == 3 || c == 5 || c == 7 || c == 11 || c == 13 || c == 17 || c == 19;
+}
+} // namespace
+
+TEST(Categorical, CategorySetContainsItsCategories)
+{
+    std::vector<uint32_t> set = CategorySet::bitset({1, 4, 40});
+    ASSERT_EQ(set.size(), 2u);
+    ASSERT_TRUE(CategorySet::contains(set.data(), set.size(), 4.0));
+    ASSERT_TRUE(CategorySet::contains(set.data(), set.size(), 40.0));
+    ASSERT_FALSE(CategorySet::contains(set.data(), set.size(), 5.0));
+    ASSERT_FALSE(CategorySet::contains(set.data(), set.size(), 100.0));
+    ASSERT_FALSE(CategorySet::contains(set.data(), set.size(), -1.0));
+    ASSERT_FALSE(CategorySet::contains(set.data(), set.size(), std::nan("")));
+}
+
+TEST(Categorical, SplitSendsCategorySetLeft)
+{
+    // The target is 1 on categories {1, 3, 4}, which no single threshold separates
+    long m = 60;
+    MatrixType X(m, 1);
+    Vector y(m), gradient(m), hessian(m, 1.0);
+    for (long i = 0; i < m; i++)
+    {
+        X(i, 0) = static_cast<double>(i % 6);
+        y[i] = (i % 6 == 1 || i % 6 == 3 || i % 6 == 4) ? 1.0 : 0.0;
+        gradient[i] = 0.5 - y[i];
+    }
+    Dataset dataset(X, y);
+
+    SplitInfo split = NumericalSplitter(1.0, nullptr, {true}).findBestSplit(dataset, gradient, hessian);
+    ASSERT_TRUE(split.isCategorical());
+    ASSERT_EQ(split.getBestFeatureId(), 0);
+    ASSERT_EQ(split.categories(), CategorySet::bitset({1, 3, 4}));
+    ASSERT_EQ(split.getLeftLocalIds().size(), 30u);
+    for (size_t i : split.getLeftLocalIds())
+    {
+        ASSERT_EQ(y[i], 1.0);
+    }
+    ASSERT_EQ(split.getRightLocalIds().size(), 30u);
+
+    SplitInfo numericalSplit = NumericalSplitter(1.0).findBestSplit(dataset, gradient, hessian);
+    ASSERT_FALSE(numericalSplit.isCategorical());
+    ASSERT_GT(split.bestGain(), numericalSplit.bestGain());
+}
+
+TEST(Categorical, TrainAndPredictAgreeAcrossEngines)
+{
+    long m = 400;
+    MatrixType X(m, 2);
+    Eigen::VectorXd y(m);
+    for (long i = 0; i < m; i++)
+    {
+        long c = (i * 7) % 20;
+        X(i, 0) = (i % 25 == 0) ? std::nan("") : static_cast<double>(c);
+        X(i, 1) = static_cast<double>((i * 3) % 11) / 11.0;
+        y[i] = (isPrime(c) && i % 25 != 0) ? 1.0 : 0.0;
+    }
+
+    GBT gbt(params());
+    gbt.setCategoricalFeatures({0});
+    gbt.trainPython(X, y, X, y, 5, 5);
+
+    const FlatForest &forest = gbt.forest();
+    ASSERT_TRUE(forest.isCategorical(forest.treeOffset(0)));
+    ASSERT_EQ(forest.featureIndex(forest.treeOffset(0)), 0);
+
+    // The first tree separates the prime categories
+    Eigen::VectorXd predictions = gbt.predictBatch(X, 0, 1, false);
+    for (long i = 0; i < m; i++)
+    {
+        ASSERT_EQ(predictions[i] > 0.5, y[i] == 1.0);
+    }
+
+    // Every inference engine and the serialized model follow the same branches
+    Eigen::VectorXd quickScorerPredictions = gbt.predictBatch(X, 0, 1, false, PredictionEngine::QuickScorer);
+    GBT copy = GBT::deserialize(gbt.serialize());
+    for (long i = 0; i < m; i++)
+    {
+        ASSERT_EQ(quickScorerPredictions[i], predictions[i]);
+        ASSERT_EQ(copy.predict(X.row(i), 0), predictions[i]);
+        ASSERT_EQ(gbt.predict(X.row(i), 0), predictions[i]);
+    }
+
+    // Categories unseen in training follow the branches of missing values
+    Eigen::RowVectorXd unseen(2), missing(2);
+    unseen << 50.0, 0.5;
+    missing << std::nan(""), 0.5;
+    ASSERT_EQ(gbt.predict(unseen, 0), gbt.predict(missing, 0));
+
+    // Categorical features require exact split finding
+    std::map<std::string, double> histogramParams = params();
+    histogramParams["tree_method"] = 1.0;
+    GBT histogramGBT(histogramParams);
+    histogramGBT.setCategoricalFeatures({0});
+    ASSERT_THROW(histogramGBT.trainPython(X, y, X, y, 1, 1), std::invalid_argument);
+    gbt.setCategoricalFeatures({2});
+    ASSERT_THROW(gbt.trainPython(X, y, X, y, 1, 1), std::invalid_argument);
+}
@@ -0,0 +1,106 @@
+#include <codegen/code_generator.h>
+#include <fstream>
+#include <cstdlib>
+#include "gtest/gtest.h"
+
+#ifndef MICROGBT_CXX_COMPILER
+#define MICROGBT_CXX_COMPILER "c++"
+#endif
+
+using namespace microgbt;
+
+namespace
+{
+/**
+ * Train a small model, export it as C++ source, compile the source together with a driver program, and
+ * compare the output of the compiled model with GBT::predict
+ *
+ * If categorical, the first feature holds category codes and is declared categorical
+ */
+void checkGeneratedModel(double metric, const std::string &name, bool categorical = false)
+{
+    long m = 300, n = 4;
+    MatrixType X(m, n);
+    Vector y(m);
+    for (long i = 0; i < m; i++)
+    {
+        for (long j = 0; j < n; j++)
+        {
+            X(i, j) = static_cast<double>((i * (j + 3)) % 31) / 7.0 - 2.0;
+        }
+        if (categorical)
+        {
+            X(i, 0) = static_cast<double>((i * 5) % 41);
+        }
+        y[i] = (metric == 0.0) ? ((X(i, 1) > X(i, 3)) ? 1.0 : 0.0) : X(i, 0) * X(i, 2);
+    }
+
+    std::map<std::string, double> params{
+        {"lambda", 1.0},
+        {"gamma", 0.1},
+        {"shrinkage_rate", 1.0},
+        {"min_split_gain", 0.1},
+        {"min_tree_size", 5},
+        {"learning_rate", 0.9},
+        {"max_depth", 3.0},
+        {"metric", metric}};
+    GBT gbt(params);
+    if (categorical)
+    {
+        gbt.setCategoricalFeatures({0});
+    }
+    gbt.trainPython(X, y, X, y, 8, 8);
+
+    std::string dir = testing::TempDir();
+    std::string header = dir + name + ".h", source = dir + name + ".cpp";
+    std::string binary = dir + name, output = dir + name + ".txt";
+
+    std::ofstream(header) << CodeGenerator::generate(gbt, 0, "generated_model");
+
+    std::ofstream driver(source);
+    driver << "#include \"" << header << "\"\n#include <cstdio>\n";
+    driver << "static const double X[" << m << "][" << n << "] = {\n";
+    for (long i = 0; i < m; i++)
+    {
+        driver << "{";
+        for (long j = 0; j < n; j++)
+        {
+            char value[32];
+            snprintf(value, sizeof(value), "%.17g", X(i, j));
+            driver << value << (j + 1 < n ? ", " : "},\n");
+        }
+    }
+    driver << "};\nint main()\n{\n";
+    driver << "    for (int i = 0; i < " << m << "; i++)\n";
+    driver << "        printf(\"%.17g\\n\", generated_model::predict(X[i]));\n";
+    driver << "    return 0;\n}\n";
+    driver.close();
+
+    std::string compile = std::string(MICROGBT_CXX_COMPILER) + " -std=c++11 -O2 -o " + binary + " " + source;
+    ASSERT_EQ(std::system(compile.c_str()), 0) << compile;
+    ASSERT_EQ(std::system((binary + " > " + output).c_str()), 0);
+
+    std::ifstream predictions(output);
+    for (long i = 0; i < m; i++)
+    {
+        double prediction;
+        ASSERT_TRUE(predictions >> prediction);
+        ASSERT_EQ(prediction, gbt.predict(X.row(i), 0));
+    }
+}
+} // namespace
+
+TEST(CodeGenerator, CompiledLogLossModelAgreesWithPredict)
+{
+    checkGeneratedModel(0.0, "microgbt_codegen_logloss");
+}
+
+TEST(CodeGenerator, CompiledRMSEModelAgreesWithPredict)
+{
+    checkGeneratedModel(1.0, "microgbt_codegen_rmse");
+}
+
+TEST(CodeGenerator, CompiledCategoricalModelAgreesWithPredict)
+{
+    checkGeneratedModel(1.0, "microgbt_codegen_categorical", true);
+}
@@ -1,4 +1,5 @@
 #include <dataset.h>
+#include <cmath>
 #include "gtest/gtest.h"
 
 TEST(Dataset, DefaultConstructor)
@@ -30,3 +31,136 @@ TEST(Dataset, Constructor)
     ASSERT_EQ(leftDS.nRows(), left.size());
     ASSERT_EQ(leftDS.numFeatures(), n);
 }
+
+TEST(Dataset, ChildSortedColumnIndices)
+{
+
+    long m = 6, n = 2;
+    Eigen::MatrixXd A(m, n);
+    A << 6.0, 1.0,
+        5.0, 2.0,
+        4.0, 3.0,
+        3.0, 4.0,
+        2.0, 5.0,
+        1.0, 6.0;
+    microgbt::Vector y(m, 0.0);
+    microgbt::Dataset dataset(A, y);
+
+    // Left side contains the three samples with the smallest values of the first feature
+    microgbt::SplitInfo splitInfo(dataset.sortedColumnIndices(0), 0.0, 4.0, 3);
+    microgbt::Dataset leftDS(dataset, splitInfo, microgbt::SplitInfo::Left);
+
+    ASSERT_EQ(leftDS.nRows(), 3);
+    for (long j = 0; j < n; j++)
+    {
+        Eigen::RowVectorXi sorted = leftDS.sortedColumnIndices(j);
+        for (long i = 1; i < leftDS.nRows(); i++)
+        {
+            ASSERT_LE(leftDS.row(sorted[i - 1])[j], leftDS.row(sorted[i])[j]);
+        }
+    }
+}
+
+TEST(Dataset, ViewOfCallerOwnedBuffers)
+{
+
+    long m = 4, n = 2;
+    Eigen::MatrixXd A(m + 1, n);
+    A << 4.0, 1.0,
+        3.0, 2.0,
+        2.0, 3.0,
+        1.0, 4.0,
+        0.0, 0.0;
+    microgbt::Vector y = {1.0, 0.0, 1.0, 0.0};
+
+    // View of the first m rows, i.e., columns are not adjacent in memory
+    microgbt::MatrixView X(A.data(), m, n, Eigen::OuterStride<>(A.outerStride()));
+    microgbt::Dataset dataset(X, y.data());
+
+    ASSERT_EQ(dataset.nRows(), m);
+    ASSERT_EQ(dataset.numFeatures(), n);
+    ASSERT_EQ(dataset.X().data(), A.data());
+    ASSERT_EQ(dataset.y(), y);
+    ASSERT_EQ(dataset.sortedColumnIndices(0)[0], 3);
+
+    // Derived datasets share the same buffers
+    microgbt::SplitInfo splitInfo(dataset.sortedColumnIndices(0), 0.0, 3.0, 2);
+    microgbt::Dataset rightDS(dataset, splitInfo, microgbt::SplitInfo::Right);
+    ASSERT_EQ(rightDS.X().data(), A.data());
+    ASSERT_EQ(rightDS.nRows(), 2);
+    ASSERT_EQ(rightDS.value(0, 1), 2.0);
+}
+
+TEST(Dataset, QuantizedStorage)
+{
+
+    long m = 5, n = 2;
+    Eigen::MatrixXd A(m, n);
+    A << -1.0, 10.0,
+        0.5, 50.0,
+        std::nan(""), 30.0,
+        2.0, 40.0,
+        0.25, 20.0;
+    microgbt::Vector y(m, 0.0);
+    microgbt::BasicDataset<uint8_t> dataset(A, y);
+
+    const microgbt::FeatureScale<uint8_t> &scale = *dataset.scale();
+    ASSERT_EQ(dataset.X()(2, 0), microgbt::FeatureScale<uint8_t>::MissingCode);
+    ASSERT_TRUE(std::isnan(dataset.value(2, 0)));
+    for (long j = 0; j < n; j++)
+    {
+        for (long i = 0; i < m; i++)
+        {
+            if (!std::isnan(A(i, j)))
+            {
+                ASSERT_NEAR(dataset.value(i, j), A(i, j), scale.scale(j) / 2.0);
+                ASSERT_LT(dataset.splitValue(i, j), dataset.value(i, j));
+            }
+        }
+    }
+
+    // Sorted column indices follow the order of the feature values
+    Eigen::RowVectorXi sorted = dataset.sortedColumnIndices(1);
+    ASSERT_EQ(sorted[0], 0);
+    ASSERT_EQ(sorted[1], 4);
+    ASSERT_EQ(sorted[2], 2);
+    ASSERT_EQ(sorted[3], 3);
+    ASSERT_EQ(sorted[4], 1);
+}
+
+TEST(Dataset, RowAndColumnSample)
+{
+
+    long m = 6, n = 3;
+    Eigen::MatrixXd A(m, n);
+    A << 6.0, 1.0, 0.5,
+        5.0, 2.0, 0.4,
+        4.0, 3.0, 0.3,
+        3.0, 4.0, 0.2,
+        2.0, 5.0, 0.1,
+        1.0, 6.0, 0.0;
+    microgbt::Vector y = {0.0, 1.0, 2.0, 3.0, 4.0, 5.0};
+    microgbt::Dataset dataset(A, y);
+    ASSERT_EQ(dataset.features(), microgbt::VectorT({0, 1, 2}));
+
+    microgbt::Dataset sample(dataset, microgbt::VectorT({1, 3, 4}), microgbt::VectorT({0, 2}));
+
+    ASSERT_EQ(sample.nRows(), 3);
+    ASSERT_EQ(sample.numFeatures(), n);
+    ASSERT_EQ(sample.features(), microgbt::VectorT({0, 2}));
+    ASSERT_EQ(sample.y(), microgbt::Vector({1.0, 3.0, 4.0}));
+    ASSERT_EQ(sample.value(2, 1), 5.0);
+
+    // Sorted column indices of the sampled features are local row indices of the sample
+    ASSERT_EQ(sample.sortedColumnIndices(0), Eigen::RowVectorXi::LinSpaced(3, 2, 0));
+    ASSERT_EQ(sample.sortedColumnIndices(2), Eigen::RowVectorXi::LinSpaced(3, 2, 0));
+
+    // Only the sampled features have sorted column indices
+    ASSERT_EQ(sample.indexBytes(), 3 * sizeof(size_t) + 3 * 2 * sizeof(int));
+
+    // Datasets derived from the sample keep its features
+    microgbt::SplitInfo splitInfo(sample.sortedColumnIndices(0), 0.0, 3.0, 1);
+    microgbt::Dataset leftDS(sample, splitInfo, microgbt::SplitInfo::Left);
+    ASSERT_EQ(leftDS.features(), sample.features());
+    ASSERT_EQ(leftDS.y(), microgbt::Vector({4.0}));
+}
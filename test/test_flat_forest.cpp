@@ -0,0 +1,52 @@
+#include <trees/flat_forest.h>
+#include "gtest/gtest.h"
+
+using namespace microgbt;
+
+TEST(FlatForest, Empty)
+{
+    FlatForest forest;
+    ASSERT_EQ(forest.numTrees(), 0);
+    ASSERT_EQ(forest.numNodes(), 0);
+}
+
+TEST(FlatForest, ScoreAgreesWithTree)
+{
+    long m = 60, n = 3;
+    MatrixType X(m, n);
+    Vector y(m), preds(m, 0.5), gradient(m), hessian(m, 1.0);
+    for (long i = 0; i < m; i++)
+    {
+        X(i, 0) = static_cast<double>(i % 7);
+        X(i, 1) = static_cast<double>((i * 5) % 11);
+        X(i, 2) = static_cast<double>(i) / m;
+        y[i] = (i % 7 < 3) ? 1.0 : 0.0;
+        gradient[i] = preds[i] - y[i];
+    }
+    Dataset dataset(X, y);
+
+    FlatForest forest;
+    std::vector<Tree> trees;
+    for (int depth = 0; depth < 4; depth++)
+    {
+        Tree tree(1.0, 0.0, 2.0, depth);
+        Vector trainScores(m, 0.0);
+        tree.build(dataset, preds, gradient, hessian, 1.0, trainScores);
+        forest.addTree(tree);
+        trees.push_back(tree);
+    }
+
+    ASSERT_EQ(forest.numTrees(), trees.size());
+    for (long i = 0; i < m; i++)
+    {
+        Eigen::RowVectorXd x = X.row(i);
+        double sum = 0.0;
+        for (size_t t = 0; t < trees.size(); t++)
+        {
+            ASSERT_EQ(forest.scoreTree(t, x), trees[t].score(x));
+            sum += trees[t].score(x);
+        }
+        ASSERT_NEAR(forest.score(x, 0), sum, 1.0e-11);
+        ASSERT_EQ(forest.score(x, 1), trees[0].score(x));
+    }
+}
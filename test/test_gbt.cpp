@@ -1,4 +1,5 @@
 #include <GBT.h>
+#include <sstream>
 #include "gtest/gtest.h"
 
 TEST(GBT, LAMBDA)
@@ -76,3 +77,435 @@ TEST(GBT, MAXDEPTH)
 
         ASSERT_EQ(gbt.maxDepth(), 18.0);
 }
+
+TEST(GBT, MultithreadedTrainingIsIdentical)
+{
+        long m = 200, n = 6;
+        microgbt::MatrixType X(m, n);
+        microgbt::Vector y(m);
+        for (long i = 0; i < m; i++)
+        {
+                for (long j = 0; j < n; j++)
+                {
+                        X(i, j) = static_cast<double>((i * (j + 3)) % 17) / 17.0;
+                }
+                y[i] = (X(i, 0) + X(i, 3) > 1.0) ? 1.0 : 0.0;
+        }
+
+        for (double treeMethod : {0.0, 1.0})
+        {
+                std::map<std::string, double> params{
+                    {"lambda", 1.0},
+                    {"gamma", 0.1},
+                    {"shrinkage_rate", 1.0},
+                    {"min_split_gain", 0.1},
+                    {"min_tree_size", 5},
+                    {"learning_rate", 0.9},
+                    {"max_depth", 3.0},
+                    {"metric", 0.0},
+                    {"tree_method", treeMethod}};
+
+                microgbt::GBT serial(params);
+                params["num_threads"] = 4.0;
+                microgbt::GBT parallel(params);
+                ASSERT_EQ(parallel.numThreads(), 4);
+
+                serial.trainPython(X, y, X, y, 5, 5);
+                parallel.trainPython(X, y, X, y, 5, 5);
+
+                for (long i = 0; i < m; i++)
+                {
+                        ASSERT_EQ(serial.predict(X.row(i), 0), parallel.predict(X.row(i), 0));
+                }
+        }
+}
+
+TEST(GBT, PredictBatch)
+{
+        long m = 3000, n = 4;
+        microgbt::MatrixType X(m, n);
+        microgbt::Vector y(m);
+        for (long i = 0; i < m; i++)
+        {
+                for (long j = 0; j < n; j++)
+                {
+                        X(i, j) = static_cast<double>((i * (j + 5)) % 23) / 23.0;
+                }
+                y[i] = (X(i, 1) > 0.5) ? 1.0 : 0.0;
+        }
+
+        std::map<std::string, double> params{
+            {"lambda", 1.0},
+            {"gamma", 0.1},
+            {"shrinkage_rate", 1.0},
+            {"min_split_gain", 0.1},
+            {"min_tree_size", 5},
+            {"learning_rate", 0.9},
+            {"max_depth", 3.0},
+            {"metric", 0.0},
+            {"tree_method", 1.0}};
+        microgbt::GBT gbt(params);
+        gbt.trainPython(X, y, X, y, 3, 3);
+
+        // Row-major input is accepted without a copy
+        Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> rowMajorX = X;
+        for (int numThreads : {1, 3})
+        {
+                Eigen::VectorXd predictions = gbt.predictBatch(X, 0, numThreads, false);
+                Eigen::VectorXd rawScores = gbt.predictBatch(rowMajorX, 2, numThreads, true);
+                ASSERT_EQ(predictions.size(), m);
+                for (long i = 0; i < m; i++)
+                {
+                        ASSERT_EQ(predictions[i], gbt.predict(X.row(i), 0));
+                        ASSERT_EQ(rawScores[i], gbt.sumScore(X.row(i), 2));
+                }
+        }
+
+        // Inputs without the training features are rejected, instead of being read out of bounds
+        ASSERT_THROW(gbt.predictBatch(X.leftCols(2), 0, 1, false), std::invalid_argument);
+        microgbt::MatrixType wideX = microgbt::MatrixType::Zero(m, n + 1);
+        ASSERT_THROW(gbt.predictBatch(wideX, 0, 1, false), std::invalid_argument);
+        ASSERT_THROW(gbt.predict(X.row(0).head(2), 0), std::invalid_argument);
+}
+
+TEST(GBT, PredictBatchQuickScorer)
+{
+        long m = 500, n = 5;
+        microgbt::MatrixType X(m, n);
+        microgbt::Vector y(m);
+        for (long i = 0; i < m; i++)
+        {
+                for (long j = 0; j < n; j++)
+                {
+                        X(i, j) = static_cast<double>((i * (j + 2)) % 29) / 29.0;
+                }
+                y[i] = X(i, 0) + 2 * X(i, 2) * X(i, 4);
+        }
+
+        std::map<std::string, double> params{
+            {"lambda", 1.0},
+            {"gamma", 0.1},
+            {"shrinkage_rate", 1.0},
+            {"min_split_gain", 0.0},
+            {"min_tree_size", 2},
+            {"learning_rate", 0.9},
+            {"max_depth", 4.0},
+            {"metric", 1.0}};
+        microgbt::GBT gbt(params);
+        gbt.trainPython(X, y, X, y, 10, 10);
+
+        Eigen::VectorXd traversal = gbt.predictBatch(X, 0, 1, false, microgbt::PredictionEngine::TreeTraversal);
+        Eigen::VectorXd quickScorer = gbt.predictBatch(X, 0, 2, false, microgbt::PredictionEngine::QuickScorer);
+        for (long i = 0; i < m; i++)
+        {
+                ASSERT_EQ(traversal[i], quickScorer[i]);
+        }
+}
+
+TEST(GBT, Float32AndQuantizedStorage)
+{
+        long m = 400, n = 3;
+        microgbt::MatrixType X(m, n);
+        microgbt::Vector y(m);
+        for (long i = 0; i < m; i++)
+        {
+                for (long j = 0; j < n; j++)
+                {
+                        X(i, j) = static_cast<double>((i * (j + 3)) % 17) / 16.0;
+                }
+                y[i] = X(i, 0) + X(i, 1) * X(i, 2);
+        }
+
+        std::map<std::string, double> params{
+            {"lambda", 1.0},
+            {"gamma", 0.1},
+            {"shrinkage_rate", 1.0},
+            {"min_split_gain", 0.0},
+            {"min_tree_size", 2},
+            {"learning_rate", 0.9},
+            {"max_depth", 3.0},
+            {"metric", 1.0}};
+
+        // Features are representable by every storage type, hence all models split the samples identically
+        microgbt::GBT gbt(params);
+        microgbt::GBTFloat32 gbtFloat32(params);
+        microgbt::GBTInt16 gbtInt16(params);
+        microgbt::GBTUInt8 gbtUInt8(params);
+        gbt.trainPython(X, y, X, y, 4, 4);
+        gbtFloat32.trainPython(X, y, X, y, 4, 4);
+        gbtInt16.trainPython(X, y, X, y, 4, 4);
+        gbtUInt8.trainPython(X, y, X, y, 4, 4);
+
+        microgbt::FeatureMatrix<float> floatX = X.cast<float>();
+        Eigen::VectorXd floatPredictions = gbtFloat32.predictBatch(floatX, 0, 1, false);
+        for (long i = 0; i < m; i++)
+        {
+                double prediction = gbt.predict(X.row(i), 0);
+                ASSERT_EQ(floatPredictions[i], prediction);
+                ASSERT_EQ(gbtInt16.predict(X.row(i), 0), prediction);
+                ASSERT_EQ(gbtUInt8.predict(X.row(i), 0), prediction);
+        }
+}
+
+TEST(GBT, QuantizedStorageHistogramSplits)
+{
+        long m = 2000;
+        microgbt::MatrixType X(m, 1);
+        microgbt::Vector y(m);
+        for (long i = 0; i < m; i++)
+        {
+                // Values are not representable by codes, i.e., every code represents an interval of values
+                X(i, 0) = static_cast<double>((i * 7919) % m) / m + 1.0e-4;
+                y[i] = std::sin(10.0 * X(i, 0));
+        }
+
+        std::map<std::string, double> params{
+            {"lambda", 1.0},
+            {"gamma", 0.1},
+            {"shrinkage_rate", 1.0},
+            {"min_split_gain", 0.0},
+            {"min_tree_size", 2},
+            {"learning_rate", 0.9},
+            {"max_depth", 6.0},
+            {"metric", 1.0},
+            {"tree_method", 1.0},
+            {"max_bin", 255.0}};
+
+        // Bin thresholds are lower bounds of codes, hence raw values follow the branches of their codes in training
+        microgbt::GBTUInt8 gbt(params);
+        gbt.trainPython(X, y, X, y, 3, 3);
+        microgbt::FeatureScale<uint8_t> scale(X);
+        for (long i = 0; i < m; i++)
+        {
+                Eigen::RowVectorXd code(1);
+                code[0] = scale.value(0, scale.quantize(0, X(i, 0)));
+                ASSERT_EQ(gbt.predict(X.row(i), 0), gbt.predict(code, 0));
+        }
+}
+
+TEST(GBT, GossTrainingIsReproducible)
+{
+        long m = 2000, n = 4;
+        microgbt::MatrixType X(m, n);
+        microgbt::Vector y(m);
+        for (long i = 0; i < m; i++)
+        {
+                for (long j = 0; j < n; j++)
+                {
+                        X(i, j) = static_cast<double>((i * (j + 7)) % 31) / 31.0;
+                }
+                y[i] = X(i, 0) + 2 * X(i, 1) * X(i, 3);
+        }
+
+        for (double treeMethod : {0.0, 1.0})
+        {
+                std::map<std::string, double> params{
+                    {"lambda", 1.0},
+                    {"gamma", 0.1},
+                    {"shrinkage_rate", 1.0},
+                    {"min_split_gain", 0.0},
+                    {"min_tree_size", 2},
+                    {"learning_rate", 0.9},
+                    {"max_depth", 4.0},
+                    {"metric", 1.0},
+                    {"tree_method", treeMethod},
+                    {"goss", 1.0},
+                    {"top_rate", 0.2},
+                    {"other_rate", 0.1},
+                    {"seed", 42.0}};
+                microgbt::GBT gbt(params), same(params);
+                ASSERT_TRUE(gbt.goss());
+                gbt.trainPython(X, y, X, y, 10, 10);
+                same.trainPython(X, y, X, y, 10, 10);
+
+                // Trees are fitted on samples, yet they reduce the error over all rows
+                double error = 0.0, baseline = 0.0, mean = std::accumulate(y.begin(), y.end(), 0.0) / m;
+                for (long i = 0; i < m; i++)
+                {
+                        double prediction = gbt.predict(X.row(i), 0);
+                        ASSERT_EQ(prediction, same.predict(X.row(i), 0));
+                        error += (prediction - y[i]) * (prediction - y[i]);
+                        baseline += (mean - y[i]) * (mean - y[i]);
+                }
+                ASSERT_LT(error, 0.1 * baseline);
+        }
+}
+
+TEST(GBT, GossRejectsInvalidRates)
+{
+        std::map<std::string, double> params{
+            {"lambda", 1.0},
+            {"gamma", 0.1},
+            {"shrinkage_rate", 1.0},
+            {"min_split_gain", 0.0},
+            {"min_tree_size", 2},
+            {"learning_rate", 0.9},
+            {"max_depth", 4.0},
+            {"metric", 1.0},
+            {"goss", 1.0}};
+
+        params["top_rate"] = -0.1;
+        ASSERT_THROW(microgbt::GBT gbt(params), std::invalid_argument);
+        params["top_rate"] = 0.2;
+        params["other_rate"] = -0.1;
+        ASSERT_THROW(microgbt::GBT gbt(params), std::invalid_argument);
+        params["other_rate"] = 0.0;
+        ASSERT_THROW(microgbt::GBT gbt(params), std::invalid_argument);
+
+        // Without GOSS, other_rate is unused
+        params["goss"] = 0.0;
+        microgbt::GBT gbt(params);
+        ASSERT_FALSE(gbt.goss());
+}
+
+TEST(GBT, RowAndColumnSubsampling)
+{
+        long m = 1000, n = 5;
+        microgbt::MatrixType X(m, n);
+        microgbt::Vector y(m);
+        for (long i = 0; i < m; i++)
+        {
+                for (long j = 0; j < n; j++)
+                {
+                        X(i, j) = static_cast<double>((i * (j + 3)) % 37) / 37.0;
+                }
+                y[i] = X(i, 0) + X(i, 2) - X(i, 4);
+        }
+
+        for (double treeMethod : {0.0, 1.0})
+        {
+                std::map<std::string, double> params{
+                    {"lambda", 1.0},
+                    {"gamma", 0.1},
+                    {"shrinkage_rate", 1.0},
+                    {"min_split_gain", 0.0},
+                    {"min_tree_size", 2},
+                    {"learning_rate", 0.9},
+                    {"max_depth", 3.0},
+                    {"metric", 1.0},
+                    {"tree_method", treeMethod},
+                    {"subsample", 0.5},
+                    {"colsample_bytree", 0.2},
+                    {"seed", 7.0}};
+                microgbt::GBT gbt(params), same(params);
+                gbt.trainPython(X, y, X, y, 8, 8);
+                same.trainPython(X, y, X, y, 8, 8);
+
+                // A single feature is sampled per tree, hence every tree splits on a single feature
+                const microgbt::FlatForest &forest = gbt.forest();
+                for (size_t t = 0; t < forest.numTrees(); t++)
+                {
+                        size_t end = (t + 1 < forest.numTrees()) ? forest.treeOffset(t + 1) : forest.numNodes();
+                        int32_t feature = forest.featureIndex(forest.treeOffset(t));
+                        for (size_t node = forest.treeOffset(t); node < end; node++)
+                        {
+                                ASSERT_TRUE(forest.isLeaf(node) || forest.featureIndex(node) == feature);
+                        }
+                }
+
+                for (long i = 0; i < m; i++)
+                {
+                        ASSERT_EQ(gbt.predict(X.row(i), 0), same.predict(X.row(i), 0));
+                }
+        }
+}
+
+TEST(GBT, TrainingHistory)
+{
+        long m = 500, n = 3;
+        microgbt::MatrixType X(m, n);
+        microgbt::Vector y(m);
+        for (long i = 0; i < m; i++)
+        {
+                for (long j = 0; j < n; j++)
+                {
+                        X(i, j) = static_cast<double>((i * (j + 5)) % 29) / 29.0;
+                }
+                y[i] = X(i, 0) - X(i, 1) * X(i, 2);
+        }
+
+        for (double treeMethod : {0.0, 1.0})
+        {
+                std::map<std::string, double> params{
+                    {"lambda", 1.0},
+                    {"gamma", 0.1},
+                    {"shrinkage_rate", 1.0},
+                    {"min_split_gain", 0.0},
+                    {"min_tree_size", 2},
+                    {"learning_rate", 0.9},
+                    {"max_depth", 3.0},
+                    {"metric", 1.0},
+                    {"tree_method", treeMethod},
+                    {"verbosity", 2.0}};
+                microgbt::GBT gbt(params);
+                std::ostringstream log;
+                gbt.setLogStream(log);
+                gbt.trainPython(X, y, X, y, 4, 4);
+
+                // One record per tree, whose node counts match the trained trees
+                const microgbt::FlatForest &forest = gbt.forest();
+                ASSERT_EQ(gbt.history().size(), forest.numTrees());
+                for (size_t t = 0; t < forest.numTrees(); t++)
+                {
+                        const microgbt::IterationStats &stats = gbt.history()[t];
+                        size_t end = (t + 1 < forest.numTrees()) ? forest.treeOffset(t + 1) : forest.numNodes();
+                        ASSERT_EQ(stats.iteration, static_cast<long>(t));
+                        ASSERT_EQ(static_cast<size_t>(stats.tree.numNodes), end - forest.treeOffset(t));
+                        ASSERT_EQ(stats.tree.numNodes, 2 * stats.tree.numLeaves - 1);
+                        ASSERT_GE(stats.tree.rowsTouched, 2 * m);
+                        ASSERT_GT(stats.tree.bytesAllocated, 0u);
+                        ASSERT_GE(stats.totalMillis, stats.gradientMillis + stats.tree.splitMillis +
+                                                         stats.tree.partitionMillis + stats.evaluationMillis);
+                        ASSERT_EQ(stats.fields().size(), 13u);
+                }
+                ASSERT_NE(log.str().find("[Iteration 3]"), std::string::npos);
+                ASSERT_NE(log.str().find("rows touched"), std::string::npos);
+
+                // Silent training writes nothing, but records the history
+                gbt.setVerbosity(microgbt::LogLevel::Silent);
+                std::ostringstream silent;
+                gbt.setLogStream(silent);
+                gbt.trainPython(X, y, X, y, 2, 2);
+                ASSERT_TRUE(silent.str().empty());
+                ASSERT_EQ(gbt.history().size(), 2u);
+        }
+}
+
+TEST(GBT, FeatureBundlingAgreesWithoutBundling)
+{
+        long m = 400, numCategories = 20;
+        microgbt::MatrixType X = microgbt::MatrixType::Zero(m, numCategories + 1);
+        microgbt::Vector y(m);
+        for (long i = 0; i < m; i++)
+        {
+                long category = (i * 7) % numCategories;
+                X(i, category) = 1.0;
+                X(i, numCategories) = static_cast<double>((i * 13) % 29) / 29.0;
+                y[i] = (category % 3 == 0) ? X(i, numCategories) : 1.0 - X(i, numCategories);
+        }
+
+        std::map<std::string, double> params{
+            {"lambda", 1.0},
+            {"gamma", 0.1},
+            {"shrinkage_rate", 1.0},
+            {"min_split_gain", 0.0},
+            {"min_tree_size", 2},
+            {"learning_rate", 0.5},
+            {"max_depth", 4.0},
+            {"metric", 1.0},
+            {"tree_method", 1.0},
+            {"verbosity", 0.0}};
+        microgbt::GBT gbt(params);
+        params["enable_bundle"] = 1.0;
+        microgbt::GBT bundledGBT(params);
+        ASSERT_TRUE(bundledGBT.enableBundle());
+        ASSERT_EQ(bundledGBT.maxConflictRate(), 0.0);
+
+        gbt.trainPython(X, y, X, y, 5, 5);
+        bundledGBT.trainPython(X, y, X, y, 5, 5);
+        ASSERT_EQ(bundledGBT.numTrees(), gbt.numTrees());
+        for (long i = 0; i < m; i++)
+        {
+                ASSERT_NEAR(bundledGBT.predict(X.row(i), 0), gbt.predict(X.row(i), 0), 1.0e-9);
+        }
+}
@@ -0,0 +1,49 @@
+#include <random>
+#include <sampling/goss.h>
+#include "gtest/gtest.h"
+
+using namespace microgbt;
+
+TEST(GOSS, KeepsLargeGradientsAndReweightsTheRest)
+{
+    size_t n = 100;
+    Vector gradient(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        // Rows 90, ..., 99 have the largest absolute gradients
+        gradient[i] = (i % 2 == 0 ? 1.0 : -1.0) * static_cast<double>(i);
+    }
+
+    GOSS goss(0.1, 0.2);
+    std::mt19937_64 rng(7);
+    Vector weights;
+    VectorT rows = goss.sample(gradient, rng, weights);
+
+    ASSERT_EQ(rows.size(), 30);
+    ASSERT_EQ(weights.size(), rows.size());
+    ASSERT_TRUE(std::is_sorted(rows.begin(), rows.end()));
+    ASSERT_EQ(std::adjacent_find(rows.begin(), rows.end()), rows.end());
+    for (size_t k = 0; k < rows.size(); k++)
+    {
+        ASSERT_EQ(weights[k], rows[k] >= 90 ? 1.0 : 4.5);
+    }
+    for (size_t row = 90; row < n; row++)
+    {
+        ASSERT_TRUE(std::binary_search(rows.begin(), rows.end(), row));
+    }
+
+    // The sample only depends on the seed
+    std::mt19937_64 sameRng(7);
+    Vector sameWeights;
+    ASSERT_EQ(goss.sample(gradient, sameRng, sameWeights), rows);
+}
+
+TEST(GOSS, KeepsAllRowsIfRatesCoverThem)
+{
+    Vector gradient = {0.5, -1.0, 2.0, 0.0}, weights;
+    std::mt19937_64 rng(0);
+    VectorT rows = GOSS(0.5, 0.5).sample(gradient, rng, weights);
+
+    ASSERT_EQ(rows, VectorT({0, 1, 2, 3}));
+    ASSERT_EQ(weights, Vector(4, 1.0));
+}
@@ -0,0 +1,234 @@
+#include <cmath>
+#include <binned_matrix.h>
+#include <feature_bundles.h>
+#include <trees/histogram_splitter.h>
+#include <trees/numerical_splliter.h>
+#include "gtest/gtest.h"
+
+using namespace microgbt;
+
+TEST(BinnedMatrix, OneBinPerDistinctValue)
+{
+    MatrixType X(5, 1);
+    X << 3.0, 1.0, 2.0, 1.0, 3.0;
+    BinnedMatrix bins(X, 255);
+
+    ASSERT_EQ(bins.numBins(0), 3);
+    ASSERT_EQ(bins.column(0)[0], 2);
+    ASSERT_EQ(bins.column(0)[1], 0);
+    ASSERT_EQ(bins.column(0)[2], 1);
+    ASSERT_NEAR(bins.threshold(0, 0), 2.0, 1.0e-11);
+}
+
+TEST(BinnedMatrix, AtMostMaxBins)
+{
+    long n = 1000;
+    MatrixType X(n, 1);
+    for (long i = 0; i < n; i++)
+    {
+        X(i, 0) = static_cast<double>(i);
+    }
+    BinnedMatrix bins(X, 16);
+
+    ASSERT_LE(bins.numBins(0), 16);
+    for (long i = 1; i < n; i++)
+    {
+        // Codes are monotone in the feature value
+        ASSERT_LE(bins.column(0)[i - 1], bins.column(0)[i]);
+    }
+}
+
+TEST(BinnedMatrix, MissingValuesInLastBin)
+{
+    MatrixType X(3, 1);
+    X << 1.0, std::nan(""), 2.0;
+    BinnedMatrix bins(X, 255);
+
+    ASSERT_EQ(bins.numBins(0), 2);
+    ASSERT_EQ(bins.column(0)[1], 1);
+}
+
+TEST(HistogramSplitter, AgreesWithExactSplitter)
+{
+    long n = 8;
+    MatrixType X(n, 2);
+    X << 1.0, 5.0,
+        2.0, 4.0,
+        3.0, 3.0,
+        4.0, 2.0,
+        5.0, 1.0,
+        6.0, 9.0,
+        7.0, 8.0,
+        8.0, 7.0;
+    Vector y(n, 0.0), gradient = {-1.0, -1.0, -1.0, -1.0, 1.0, 1.0, 1.0, 1.0}, hessian(n, 1.0);
+    Dataset dataset(X, y);
+
+    std::shared_ptr<const BinnedMatrix> bins = std::make_shared<BinnedMatrix>(X, 255);
+    HistogramSplitter splitter(1.0, bins);
+    SplitInfo split = splitter.findBestSplit(dataset, gradient, hessian);
+
+    ASSERT_EQ(split.getBestFeatureId(), 0);
+    ASSERT_NEAR(split.splitValue(), 5.0, 1.0e-11);
+    ASSERT_EQ(split.getLeftLocalIds().size(), 4);
+    ASSERT_EQ(split.getRightLocalIds().size(), 4);
+}
+
+TEST(HistogramSplitter, SiblingHistogramBySubtraction)
+{
+    long n = 300;
+    MatrixType X(n, 3);
+    Vector y(n, 0.0), gradient(n), hessian(n);
+    for (long i = 0; i < n; i++)
+    {
+        X(i, 0) = static_cast<double>(i % 17);
+        X(i, 1) = static_cast<double>((i * 31) % 23);
+        X(i, 2) = static_cast<double>(i) / n;
+        gradient[i] = std::sin(static_cast<double>(i)) + X(i, 2);
+        hessian[i] = 1.0 + 0.5 * std::cos(static_cast<double>(i));
+    }
+    Dataset dataset(X, y);
+
+    std::shared_ptr<const BinnedMatrix> bins = std::make_shared<BinnedMatrix>(X, 16);
+    HistogramSplitter splitter(1.0, bins);
+    std::unique_ptr<NodeStatistics> parent = splitter.statistics(dataset, gradient, hessian);
+    SplitInfo split = splitter.findBestSplitFromStatistics(dataset, gradient, hessian, dataset.features(), *parent);
+    ASSERT_GE(split.getBestFeatureId(), 0);
+
+    Dataset left(dataset, split, SplitInfo::Side::Left), right(dataset, split, SplitInfo::Side::Right);
+    Vector leftGradient = split.split(gradient, SplitInfo::Side::Left);
+    Vector leftHessian = split.split(hessian, SplitInfo::Side::Left);
+    Vector rightGradient = split.split(gradient, SplitInfo::Side::Right);
+    Vector rightHessian = split.split(hessian, SplitInfo::Side::Right);
+
+    // The split of the right child is the same, whether its histogram is accumulated or derived
+    std::unique_ptr<NodeStatistics> leftStatistics = splitter.statistics(left, leftGradient, leftHessian);
+    std::unique_ptr<NodeStatistics> derived = splitter.subtract(*parent, *leftStatistics);
+    SplitInfo expected = splitter.findBestSplit(right, rightGradient, rightHessian);
+    SplitInfo actual = splitter.findBestSplitFromStatistics(right, rightGradient, rightHessian, right.features(),
+                                                           *derived);
+
+    ASSERT_EQ(actual.getBestFeatureId(), expected.getBestFeatureId());
+    ASSERT_EQ(actual.splitValue(), expected.splitValue());
+    ASSERT_NEAR(actual.bestGain(), expected.bestGain(), 1.0e-9);
+    ASSERT_EQ(actual.getLeftLocalIds(), expected.getLeftLocalIds());
+}
+
+TEST(HistogramSplitter, OnlyCandidateFeaturesAreConsidered)
+{
+    long n = 8;
+    MatrixType X(n, 2);
+    X << 1.0, 5.0,
+        2.0, 4.0,
+        3.0, 3.0,
+        4.0, 2.0,
+        5.0, 1.0,
+        6.0, 9.0,
+        7.0, 8.0,
+        8.0, 7.0;
+    Vector y(n, 0.0), gradient = {-1.0, -1.0, -1.0, -1.0, 1.0, 1.0, 1.0, 1.0}, hessian(n, 1.0);
+    Dataset dataset(X, y);
+
+    std::shared_ptr<const BinnedMatrix> bins = std::make_shared<BinnedMatrix>(X, 255);
+    HistogramSplitter histogramSplitter(1.0, bins);
+    NumericalSplitter numericalSplitter(1.0);
+
+    // Feature 0 separates the gradients perfectly, yet only feature 1 is a candidate
+    SplitInfo histogramSplit = histogramSplitter.findBestSplit(dataset, gradient, hessian, VectorT({1}));
+    SplitInfo numericalSplit = numericalSplitter.findBestSplit(dataset, gradient, hessian, VectorT({1}));
+
+    ASSERT_EQ(histogramSplit.getBestFeatureId(), 1);
+    ASSERT_EQ(numericalSplit.getBestFeatureId(), 1);
+    ASSERT_NEAR(histogramSplit.bestGain(), numericalSplit.bestGain(), 1.0e-11);
+}
+
+namespace
+{
+// One-hot encoding of a categorical column of numCategories categories, followed by a numerical column
+MatrixType oneHotMatrix(long n, long numCategories)
+{
+    MatrixType X = MatrixType::Zero(n, numCategories + 1);
+    for (long i = 0; i < n; i++)
+    {
+        X(i, (i * 7) % numCategories) = 1.0;
+        X(i, numCategories) = static_cast<double>((i * 13) % 29);
+    }
+    return X;
+}
+} // namespace
+
+TEST(FeatureBundles, OneHotColumnsAreBundled)
+{
+    long n = 200, numCategories = 12;
+    MatrixType X = oneHotMatrix(n, numCategories);
+    std::shared_ptr<const BinnedMatrix> bins = std::make_shared<BinnedMatrix>(X, 255);
+    FeatureBundles bundles(bins, 0.0);
+
+    // The numerical column stays on its own, the mutually exclusive one-hot columns share a bundle
+    ASSERT_EQ(bundles.numBundles(), 2u);
+    ASSERT_FALSE(bundles.isBundled(numCategories));
+    ASSERT_EQ(bundles.column(bundles.bundle(numCategories)), bins->column(numCategories));
+    ASSERT_EQ(bundles.features(bundles.bundle(0)).size(), static_cast<size_t>(numCategories));
+    ASSERT_EQ(bundles.numBins(bundles.bundle(0)), numCategories + 1);
+
+    // Without conflicts, the bundle codes represent the bins of every feature
+    for (long j = 0; j < numCategories; j++)
+    {
+        ASSERT_TRUE(bundles.isBundled(j));
+        const uint8_t *codes = bundles.column(bundles.bundle(j));
+        for (long i = 0; i < n; i++)
+        {
+            ASSERT_EQ(bundles.featureBin(j, codes[i]), bins->column(j)[i]);
+        }
+    }
+}
+
+TEST(FeatureBundles, MappedBinsAreRejected)
+{
+    std::vector<uint8_t> codes = {0, 1, 0, 0, 0, 0, 1, 0};
+    std::shared_ptr<const BinnedMatrix> bins = std::make_shared<BinnedMatrix>(
+        BinnedMatrix::mappedView(codes.data(), 4, 4, std::vector<Vector>(2, Vector(1, 0.5)), nullptr));
+    ASSERT_THROW(FeatureBundles(bins, 0.0), std::invalid_argument);
+}
+
+TEST(HistogramSplitter, BundledSplitsAgreeWithUnbundledSplits)
+{
+    long n = 300, numCategories = 9;
+    MatrixType X = oneHotMatrix(n, numCategories);
+    Vector y(n, 0.0), gradient(n), hessian(n);
+    for (long i = 0; i < n; i++)
+    {
+        gradient[i] = ((i * 7) % numCategories == 4 ? -2.0 : 0.5) + 0.1 * std::sin(static_cast<double>(i));
+        hessian[i] = 1.0 + 0.5 * std::cos(static_cast<double>(i));
+    }
+    Dataset dataset(X, y);
+
+    std::shared_ptr<const BinnedMatrix> bins = std::make_shared<BinnedMatrix>(X, 255);
+    std::shared_ptr<const FeatureBundles> bundles = std::make_shared<FeatureBundles>(bins, 0.0);
+    HistogramSplitter splitter(1.0, bins), bundledSplitter(1.0, bins, nullptr, bundles);
+
+    SplitInfo expected = splitter.findBestSplit(dataset, gradient, hessian);
+    SplitInfo actual = bundledSplitter.findBestSplit(dataset, gradient, hessian);
+    ASSERT_EQ(actual.getBestFeatureId(), 4);
+    ASSERT_EQ(actual.getBestFeatureId(), expected.getBestFeatureId());
+    ASSERT_EQ(actual.splitValue(), expected.splitValue());
+    ASSERT_NEAR(actual.bestGain(), expected.bestGain(), 1.0e-9);
+    ASSERT_EQ(actual.getLeftLocalIds(), expected.getLeftLocalIds());
+
+    // Histograms of bundles are smaller, and derived by subtraction as well
+    std::unique_ptr<NodeStatistics> parent = bundledSplitter.statistics(dataset, gradient, hessian);
+    ASSERT_LT(parent->bytes(), splitter.statistics(dataset, gradient, hessian)->bytes());
+
+    Dataset left(dataset, actual, SplitInfo::Side::Left), right(dataset, actual, SplitInfo::Side::Right);
+    Vector leftGradient = actual.split(gradient, SplitInfo::Side::Left);
+    Vector leftHessian = actual.split(hessian, SplitInfo::Side::Left);
+    Vector rightGradient = actual.split(gradient, SplitInfo::Side::Right);
+    Vector rightHessian = actual.split(hessian, SplitInfo::Side::Right);
+    std::unique_ptr<NodeStatistics> derived =
+        bundledSplitter.subtract(*parent, *bundledSplitter.statistics(left, leftGradient, leftHessian));
+    SplitInfo rightExpected = splitter.findBestSplit(right, rightGradient, rightHessian);
+    SplitInfo rightActual = bundledSplitter.findBestSplitFromStatistics(right, rightGradient, rightHessian,
+                                                                        right.features(), *derived);
+    ASSERT_EQ(rightActual.getBestFeatureId(), rightExpected.getBestFeatureId());
+    ASSERT_EQ(rightActual.splitValue(), rightExpected.splitValue());
+    ASSERT_NEAR(rightActual.bestGain(), rightExpected.bestGain(), 1.0e-9);
+}
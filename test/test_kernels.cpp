@@ -0,0 +1,70 @@
+#include <cmath>
+#include <metrics/kernels.h>
+#include <types.h>
+#include "gtest/gtest.h"
+
+using namespace microgbt;
+
+TEST(Kernels, Exp)
+{
+    for (double x = -700.0; x <= 700.0; x += 0.37)
+    {
+        ASSERT_NEAR(kernels::detail::exp(x) / std::exp(x), 1.0, 1.0e-15);
+    }
+    ASSERT_EQ(kernels::detail::exp(0.0), 1.0);
+}
+
+TEST(Kernels, Sigmoid)
+{
+    double eps = 10e-8;
+    for (double score = -50.0; score <= 50.0; score += 0.01)
+    {
+        double expected = std::min(std::max(1.0 / (1 + std::exp(-score)), eps), 1 - eps);
+        ASSERT_NEAR(kernels::sigmoid(score, eps), expected, 1.0e-15);
+    }
+}
+
+TEST(Kernels, VectorKernelsAreIdenticalToScalar)
+{
+    std::vector<kernels::InstructionSet> instructionSets;
+    if (kernels::hostInstructionSet() >= kernels::InstructionSet::AVX2)
+    {
+        instructionSets.push_back(kernels::InstructionSet::AVX2);
+    }
+    if (kernels::hostInstructionSet() >= kernels::InstructionSet::AVX512)
+    {
+        instructionSets.push_back(kernels::InstructionSet::AVX512);
+    }
+
+    // Sizes that are not multiples of the vector widths exercise the padded / masked tails
+    for (size_t n : {0, 1, 3, 4, 7, 8, 13, 100})
+    {
+        Vector scores(n), targets(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            scores[i] = std::sin(static_cast<double>(i)) * 40.0;
+            targets[i] = static_cast<double>(i % 2);
+        }
+
+        Vector expectedG(n), expectedH(n);
+        kernels::logLossGradientsAndHessians(scores.data(), targets.data(), n, 10e-8, expectedG.data(),
+                                             expectedH.data(), kernels::InstructionSet::Scalar);
+        Vector expectedRmseG(n), expectedRmseH(n);
+        kernels::squaredErrorGradientsAndHessians(scores.data(), targets.data(), n, expectedRmseG.data(),
+                                                  expectedRmseH.data(), kernels::InstructionSet::Scalar);
+
+        for (kernels::InstructionSet instructionSet : instructionSets)
+        {
+            Vector g(n), h(n);
+            kernels::logLossGradientsAndHessians(scores.data(), targets.data(), n, 10e-8, g.data(), h.data(),
+                                                 instructionSet);
+            ASSERT_EQ(g, expectedG);
+            ASSERT_EQ(h, expectedH);
+
+            kernels::squaredErrorGradientsAndHessians(scores.data(), targets.data(), n, g.data(), h.data(),
+                                                      instructionSet);
+            ASSERT_EQ(g, expectedRmseG);
+            ASSERT_EQ(h, expectedRmseH);
+        }
+    }
+}
@@ -77,4 +77,35 @@ TEST(LogLoss, LogLossLossMustBeZero)
 
     double loss = logloss.lossAt(preds, targets);
     ASSERT_NEAR(loss, 0.0, 1.0e-3);
-}
\ No newline at end of file
+}
+
+TEST(LogLoss, LogLossGradientsAndHessians)
+{
+    LogLoss logloss;
+    size_t n = 2 * Metric::BlockSize + 5;
+    Vector scores(n), targets(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        scores[i] = std::cos(static_cast<double>(i)) * 5.0;
+        targets[i] = static_cast<double>(i % 3 == 0);
+    }
+
+    Vector preds(n);
+    std::transform(scores.begin(), scores.end(), preds.begin(), [&logloss](double s) { return logloss.logit(s); });
+    Vector expectedGrads = logloss.gradients(preds, targets), expectedHessian = logloss.hessian(preds);
+
+    ThreadPool threadPool(3);
+    Vector grads(n), hessian(n), parallelGrads(n), parallelHessian(n);
+    logloss.gradientsAndHessians(scores.data(), targets.data(), n, grads.data(), hessian.data());
+    logloss.gradientsAndHessians(scores.data(), targets.data(), n, parallelGrads.data(), parallelHessian.data(),
+                                 &threadPool);
+
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(grads.data()) % 64, 0u);
+    for (size_t i = 0; i < n; i++)
+    {
+        ASSERT_NEAR(grads[i], expectedGrads[i], 1.0e-15);
+        ASSERT_NEAR(hessian[i], expectedHessian[i], 1.0e-15);
+    }
+    ASSERT_EQ(parallelGrads, grads);
+    ASSERT_EQ(parallelHessian, hessian);
+}
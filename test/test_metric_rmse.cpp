@@ -48,3 +48,21 @@ TEST(microgbt, RMSELossAtMustBeZero)
     double loss = rmse.lossAt(preds, targets);
     ASSERT_NEAR(loss, 0, 1.0e-7);
 }
+
+TEST(microgbt, RMSEGradientsAndHessians)
+{
+    RMSE rmse;
+    size_t n = 11;
+    Vector scores(n), targets(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        scores[i] = 0.5 * i;
+        targets[i] = 10.0 - i;
+    }
+
+    Vector grads(n), hessian(n);
+    rmse.gradientsAndHessians(scores.data(), targets.data(), n, grads.data(), hessian.data());
+
+    ASSERT_EQ(grads, rmse.gradients(scores, targets));
+    ASSERT_EQ(hessian, rmse.hessian(scores));
+}
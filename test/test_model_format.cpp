@@ -0,0 +1,168 @@
+#include <GBT.h>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include "gtest/gtest.h"
+
+using namespace microgbt;
+
+namespace
+{
+GBT trainModel(const MatrixType &X, const Vector &y)
+{
+    const std::map<std::string, double> params{
+        {"lambda", 1.0},
+        {"gamma", 0.1},
+        {"shrinkage_rate", 1.0},
+        {"min_split_gain", 0.1},
+        {"min_tree_size", 5},
+        {"learning_rate", 0.9},
+        {"max_depth", 3.0},
+        {"metric", 0.0}};
+    GBT gbt(params);
+    gbt.trainPython(X, y, X, y, 6, 6);
+    return gbt;
+}
+
+MatrixType syntheticX(long m, long n)
+{
+    MatrixType X(m, n);
+    for (long i = 0; i < m; i++)
+    {
+        for (long j = 0; j < n; j++)
+        {
+            X(i, j) = static_cast<double>((i * (j + 7)) % 19) / 19.0;
+        }
+    }
+    return X;
+}
+} // namespace
+
+TEST(ModelFormat, SaveAndLoad)
+{
+    MatrixType X = syntheticX(200, 4);
+    Vector y(200);
+    for (long i = 0; i < 200; i++)
+    {
+        y[i] = (X(i, 0) > X(i, 2)) ? 1.0 : 0.0;
+    }
+    GBT gbt = trainModel(X, y);
+
+    std::string path = testing::TempDir() + "microgbt_model.bin";
+    gbt.saveModel(path);
+    GBT loaded = GBT::loadModel(path);
+    std::remove(path.c_str());
+
+    ASSERT_EQ(loaded.numTrees(), gbt.numTrees());
+    ASSERT_EQ(loaded.getBestIteration(), gbt.getBestIteration());
+    ASSERT_EQ(loaded.lambda(), gbt.lambda());
+    ASSERT_EQ(loaded.maxDepth(), gbt.maxDepth());
+    ASSERT_EQ(loaded.metricName(), gbt.metricName());
+    ASSERT_EQ(loaded.forest().numFeatures(), 4u);
+    for (long i = 0; i < X.rows(); i++)
+    {
+        ASSERT_EQ(loaded.predict(X.row(i), 0), gbt.predict(X.row(i), 0));
+    }
+
+    // The memory mapping outlives the loaded model's file and serves every inference engine
+    Eigen::VectorXd predictions = loaded.predictBatch(X, 0, 1, false, PredictionEngine::QuickScorer);
+    ASSERT_EQ(predictions[7], gbt.predict(X.row(7), 0));
+}
+
+TEST(ModelFormat, SerializeAndDeserialize)
+{
+    MatrixType X = syntheticX(100, 3);
+    Vector y(100);
+    for (long i = 0; i < 100; i++)
+    {
+        y[i] = (X(i, 1) > 0.5) ? 1.0 : 0.0;
+    }
+    GBT gbt = trainModel(X, y);
+
+    std::string bytes = gbt.serialize();
+    GBT copy = GBT::deserialize(bytes);
+    ASSERT_EQ(copy.serialize(), bytes);
+    for (long i = 0; i < X.rows(); i++)
+    {
+        ASSERT_EQ(copy.predict(X.row(i), 0), gbt.predict(X.row(i), 0));
+    }
+}
+
+TEST(ModelFormat, RejectsInvalidBytes)
+{
+    ASSERT_THROW(GBT::deserialize("not a model"), std::runtime_error);
+
+    std::string bytes = trainModel(syntheticX(50, 2), Vector(50, 1.0)).serialize();
+    bytes[8] = 99; // version
+    ASSERT_THROW(GBT::deserialize(bytes), std::runtime_error);
+}
+
+TEST(ModelFormat, RejectsCorruptedNodeTable)
+{
+    MatrixType X = syntheticX(100, 3);
+    Vector y(100);
+    for (long i = 0; i < 100; i++)
+    {
+        y[i] = (X(i, 1) > 0.5) ? 1.0 : 0.0;
+    }
+    std::string bytes = trainModel(X, y).serialize();
+    ModelFormat::Header header = ModelFormat::readHeader(reinterpret_cast<const uint8_t *>(bytes.data()), bytes.size());
+    ASSERT_FALSE(GBT::deserialize(bytes).forest().isLeaf(0));
+
+    auto corrupt = [&bytes](size_t offset, int64_t value, size_t size) {
+        std::string corrupted = bytes;
+        std::memcpy(&corrupted[offset], &value, size);
+        return corrupted;
+    };
+
+    // Arrays beyond the end of the file, including by an overflowing number of nodes
+    ASSERT_THROW(GBT::deserialize(corrupt(offsetof(ModelFormat::Header, numNodes), int64_t(1) << 61, 8)),
+                 std::runtime_error);
+    ASSERT_THROW(GBT::deserialize(corrupt(offsetof(ModelFormat::Header, numTrees), 1000, 8)), std::runtime_error);
+
+    // Tree offset, right child and split feature of the root of the first tree
+    ASSERT_THROW(GBT::deserialize(corrupt(header.treeOffsetsOffset, static_cast<int64_t>(header.numNodes), 4)),
+                 std::runtime_error);
+    ASSERT_THROW(GBT::deserialize(corrupt(header.rightChildOffset, static_cast<int64_t>(header.numNodes), 4)),
+                 std::runtime_error);
+    ASSERT_THROW(GBT::deserialize(corrupt(header.rightChildOffset, 0, 4)), std::runtime_error);
+    ASSERT_THROW(GBT::deserialize(corrupt(header.featureIndexOffset, 3, 4)), std::runtime_error);
+
+    // A categorical split whose set of categories is outside of the (empty) pool
+    ASSERT_THROW(GBT::deserialize(corrupt(header.featureIndexOffset, -3, 4)), std::runtime_error);
+}
+
+TEST(ModelFormat, SerializeTrainingParameters)
+{
+    std::map<std::string, double> params{
+        {"lambda", 1.0},
+        {"gamma", 0.1},
+        {"shrinkage_rate", 1.0},
+        {"min_split_gain", 0.1},
+        {"min_tree_size", 5},
+        {"learning_rate", 0.9},
+        {"max_depth", 3.0},
+        {"metric", 0.0},
+        {"subsample", 0.5},
+        {"colsample_bytree", 0.5},
+        {"colsample_bylevel", 0.75},
+        {"seed", 42.0},
+        {"max_leaves", 6.0},
+        {"goss", 1.0},
+        {"top_rate", 0.3},
+        {"other_rate", 0.2}};
+    GBT gbt(params);
+    gbt.setCategoricalFeatures({0, 2});
+
+    // A deserialized model retrains with the same parameters
+    GBT copy = GBT::deserialize(gbt.serialize());
+    ASSERT_EQ(copy.subsample(), 0.5);
+    ASSERT_EQ(copy.colsampleByTree(), 0.5);
+    ASSERT_EQ(copy.colsampleByLevel(), 0.75);
+    ASSERT_EQ(copy.seed(), 42u);
+    ASSERT_EQ(copy.maxLeaves(), 6);
+    ASSERT_TRUE(copy.goss());
+    ASSERT_EQ(copy.topRate(), 0.3);
+    ASSERT_EQ(copy.otherRate(), 0.2);
+    ASSERT_EQ(copy.categoricalFeatures(), VectorT({0, 2}));
+}
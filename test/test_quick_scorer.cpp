@@ -0,0 +1,46 @@
+#include <trees/quick_scorer.h>
+#include "gtest/gtest.h"
+
+using namespace microgbt;
+
+TEST(QuickScorer, ScoreAgreesWithFlatForest)
+{
+    long m = 80, n = 4;
+    MatrixType X(m, n);
+    Vector y(m), preds(m, 0.5), gradient(m), hessian(m, 1.0);
+    for (long i = 0; i < m; i++)
+    {
+        X(i, 0) = static_cast<double>(i % 7);
+        X(i, 1) = static_cast<double>((i * 5) % 11);
+        X(i, 2) = static_cast<double>(i) / m;
+        X(i, 3) = static_cast<double>((i * 3) % 13);
+        y[i] = (i % 7 < 3 || i % 13 == 1) ? 1.0 : 0.0;
+        gradient[i] = preds[i] - y[i];
+    }
+    Dataset dataset(X, y);
+
+    FlatForest forest;
+    for (int depth = 0; depth < 6; depth++)
+    {
+        Tree tree(1.0, 0.0, 1.0, depth);
+        Vector trainScores(m, 0.0);
+        tree.build(dataset, preds, gradient, hessian, 1.0, trainScores);
+        forest.addTree(tree);
+    }
+
+    ASSERT_TRUE(QuickScorer::supports(forest));
+    QuickScorer quickScorer(forest);
+    ASSERT_EQ(quickScorer.numTrees(), forest.numTrees());
+
+    std::vector<uint64_t> bitvectors;
+    for (long i = 0; i < m; i++)
+    {
+        Eigen::RowVectorXd x = X.row(i);
+        ASSERT_EQ(quickScorer.score(x, 0, bitvectors), forest.score(x, 0));
+        ASSERT_EQ(quickScorer.score(x, 2, bitvectors), forest.score(x, 2));
+
+        // Missing values follow the right branch in both engines
+        x[i % n] = std::nan("");
+        ASSERT_EQ(quickScorer.score(x, 0, bitvectors), forest.score(x, 0));
+    }
+}
@@ -0,0 +1,30 @@
+#include <random>
+#include <sampling/random_subset.h>
+#include "gtest/gtest.h"
+
+using namespace microgbt;
+
+TEST(RandomSubset, DistinctSortedIndices)
+{
+    std::mt19937_64 rng(1);
+    VectorT subset = randomSubset(50, 20, rng);
+
+    ASSERT_EQ(subset.size(), 20);
+    ASSERT_TRUE(std::is_sorted(subset.begin(), subset.end()));
+    ASSERT_EQ(std::adjacent_find(subset.begin(), subset.end()), subset.end());
+    ASSERT_LT(subset.back(), 50);
+}
+
+TEST(RandomSubset, RandomFraction)
+{
+    std::mt19937_64 rng(3);
+    VectorT features = {2, 5, 7, 11};
+
+    ASSERT_EQ(randomFraction(features, 1.0, rng), features);
+    ASSERT_EQ(randomFraction(features, 0.5, rng).size(), 2);
+
+    // At least one index is kept
+    VectorT single = randomFraction(features, 0.01, rng);
+    ASSERT_EQ(single.size(), 1);
+    ASSERT_NE(std::find(features.begin(), features.end(), single[0]), features.end());
+}
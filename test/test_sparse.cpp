@@ -0,0 +1,165 @@
+#include <GBT.h>
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace microgbt;
+
+namespace
+{
+// Sparse matrix with the non-zero entries of a dense matrix, i.e., its zeros become missing values
+SparseMatrixType sparseView(const MatrixType &X)
+{
+    std::vector<Eigen::Triplet<double>> entries;
+    for (long j = 0; j < X.cols(); j++)
+    {
+        for (long i = 0; i < X.rows(); i++)
+        {
+            if (X(i, j) != 0.0)
+            {
+                entries.emplace_back(static_cast<int>(i), static_cast<int>(j), X(i, j));
+            }
+        }
+    }
+    SparseMatrixType sparse(X.rows(), X.cols());
+    sparse.setFromTriplets(entries.begin(), entries.end());
+    return sparse;
+}
+
+std::map<std::string, double> params()
+{
+    return {{"lambda", 1.0},
+            {"gamma", 0.0},
+            {"shrinkage_rate", 1.0},
+            {"min_split_gain", 0.0},
+            {"min_tree_size", 2},
+            {"learning_rate", 0.5},
+            {"max_depth", 3.0},
+            {"metric", 1.0},
+            {"verbosity", 0.0}};
+}
+} // namespace
+
+TEST(Sparse, DatasetSortsStoredValues)
+{
+    MatrixType X(5, 2);
+    X << 3.0, 0.0,
+         0.0, 1.0,
+         1.0, 0.0,
+         2.0, std::nan(""),
+         0.0, -1.0;
+    Vector y{1.0, 2.0, 3.0, 4.0, 5.0};
+    Dataset dataset(sparseView(X), y);
+
+    ASSERT_TRUE(dataset.isSparse());
+    ASSERT_EQ(dataset.nRows(), 5);
+    ASSERT_EQ(dataset.numFeatures(), 2);
+    ASSERT_EQ(dataset.numGlobalRows(), 5);
+
+    // Stored NaN values are missing values as well
+    ASSERT_EQ(dataset.numStoredValues(0), 3u);
+    ASSERT_EQ(dataset.numStoredValues(1), 2u);
+    ASSERT_EQ(dataset.storedRows(0)[0], 2);
+    ASSERT_EQ(dataset.storedRows(0)[2], 0);
+    ASSERT_EQ(dataset.storedValue(1, 0), -1.0);
+    ASSERT_EQ(dataset.value(0, 0), 3.0);
+    ASSERT_TRUE(std::isnan(dataset.value(0, 1)));
+    ASSERT_TRUE(std::isnan(dataset.sample(3)[1]));
+
+    // Rows 0, 3 and 4 of the dataset become local rows 0, 1 and 2
+    Dataset subset(dataset, VectorT{4, 0, 3});
+    ASSERT_EQ(subset.numStoredValues(0), 2u);
+    ASSERT_EQ(subset.storedRows(0)[0], 2);
+    ASSERT_EQ(subset.storedRows(0)[1], 1);
+    ASSERT_EQ(subset.numStoredValues(1), 1u);
+    ASSERT_EQ(subset.storedRows(1)[0], 0);
+    ASSERT_EQ(subset.y()[0], 5.0);
+}
+
+TEST(Sparse, SplitLearnsDefaultDirection)
+{
+    // Missing values have the target of the samples with small values
+    long m = 40;
+    MatrixType X(m, 1);
+    Vector y(m), gradient(m), hessian(m, 1.0);
+    for (long i = 0; i < m; i++)
+    {
+        X(i, 0) = (i % 4 == 0) ? 0.0 : static_cast<double>(i);
+        y[i] = (X(i, 0) < 20.0) ? 1.0 : 0.0;
+        gradient[i] = 0.5 - y[i];
+    }
+
+    Dataset sparse(sparseView(X), y);
+    SplitInfo split = NumericalSplitter(1.0).findBestSplit(sparse, gradient, hessian, sparse.features());
+    ASSERT_EQ(split.splitValue(), 21.0);
+    ASSERT_TRUE(split.defaultLeft());
+    for (size_t i : split.getLeftLocalIds())
+    {
+        ASSERT_EQ(y[i], 1.0);
+    }
+    ASSERT_EQ(split.getLeftLocalIds().size() + split.getRightLocalIds().size(), static_cast<size_t>(m));
+
+    // Dense datasets learn the same direction for NaN values
+    MatrixType denseX = X;
+    for (long i = 0; i < m; i += 4)
+    {
+        denseX(i, 0) = std::nan("");
+    }
+    Dataset dense(denseX, y);
+    SplitInfo denseSplit = NumericalSplitter(1.0).findBestSplit(dense, gradient, hessian, dense.features());
+    ASSERT_EQ(denseSplit.splitValue(), split.splitValue());
+    ASSERT_TRUE(denseSplit.defaultLeft());
+    ASSERT_EQ(denseSplit.getLeftLocalIds().size(), split.getLeftLocalIds().size());
+}
+
+TEST(Sparse, TrainAndPredictAgreeWithDenseMissingValues)
+{
+    long m = 300, n = 5;
+    MatrixType X(m, n);
+    for (long i = 0; i < m; i++)
+    {
+        for (long j = 0; j < n; j++)
+        {
+            // Most entries are zero, i.e., missing in the sparse matrix
+            X(i, j) = ((i * (j + 3)) % 7 < 2) ? static_cast<double>((i * (j + 1)) % 17) / 17.0 + 0.5 : 0.0;
+        }
+    }
+    Eigen::VectorXd y(m);
+    for (long i = 0; i < m; i++)
+    {
+        y[i] = (X(i, 0) > 0.9 || (X(i, 1) == 0.0 && X(i, 2) > 0.0)) ? 1.0 : 0.0;
+    }
+    MatrixType denseX = X.unaryExpr([](double x) { return (x == 0.0) ? std::nan("") : x; });
+
+    GBT sparseGBT(params()), denseGBT(params());
+    SparseMatrixType sparseX = sparseView(X);
+    sparseGBT.trainPython(sparseX, y, sparseX, y, 5, 5);
+    denseGBT.trainPython(denseX, y, denseX, y, 5, 5);
+    ASSERT_EQ(sparseGBT.numTrees(), denseGBT.numTrees());
+
+    // Some nodes send missing values to the left
+    const FlatForest &forest = sparseGBT.forest();
+    bool hasDefaultLeft = false;
+    for (size_t node = 0; node < forest.numNodes(); node++)
+    {
+        hasDefaultLeft = hasDefaultLeft || (!forest.isLeaf(node) && forest.defaultLeft(node));
+    }
+    ASSERT_TRUE(hasDefaultLeft);
+
+    SparseRowMatrixType rowX = sparseX;
+    Eigen::VectorXd sparsePreds = sparseGBT.predictSparse(rowX, 0, 1, false);
+    Eigen::VectorXd quickScorerPreds = sparseGBT.predictSparse(rowX, 0, 1, false, PredictionEngine::QuickScorer);
+    Eigen::VectorXd densePreds = denseGBT.predictBatch(denseX, 0, 1, false);
+    for (long i = 0; i < m; i++)
+    {
+        ASSERT_NEAR(sparsePreds[i], densePreds[i], 1e-9);
+        ASSERT_EQ(quickScorerPreds[i], sparsePreds[i]);
+        ASSERT_EQ(sparseGBT.predict(denseX.row(i), 0), sparsePreds[i]);
+    }
+
+    // Histogram-based split finding does not support sparse matrices
+    std::map<std::string, double> histogramParams = params();
+    histogramParams["tree_method"] = 1.0;
+    GBT histogramGBT(histogramParams);
+    ASSERT_THROW(histogramGBT.trainPython(sparseX, y, sparseX, y, 1, 1), std::invalid_argument);
+}
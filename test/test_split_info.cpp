@@ -1,4 +1,6 @@
+#include <cmath>
 #include <trees/split_info.h>
+#include <trees/numerical_splliter.h>
 #include "gtest/gtest.h"
 
 TEST(microgbt, SplitInfo)
@@ -12,3 +14,39 @@ TEST(microgbt, SplitInfoSplitValue)
     microgbt::SplitInfo gain(0.0, 1.0);
     ASSERT_NEAR(gain.splitValue(), 1.0, 1.0e-11);
 }
+
+TEST(microgbt, SplitInfoSidesAgreeWithPartition)
+{
+    long m = 40;
+    Eigen::MatrixXd X(m, 2);
+    microgbt::Vector y(m), gradient(m), hessian(m);
+    for (long i = 0; i < m; i++)
+    {
+        X(i, 0) = static_cast<double>(i % 9);
+        X(i, 1) = (i % 4 == 0) ? std::nan("") : static_cast<double>(i % 5);
+        y[i] = (i % 4 == 0 || i % 5 < 2) ? 1.0 : 0.0;
+        gradient[i] = 0.5 - y[i];
+        hessian[i] = 0.25 + 0.01 * static_cast<double>(i % 3);
+    }
+    microgbt::Dataset dataset(X, y);
+
+    // Candidate splits are compact records; the one of the best feature carries the partition
+    for (const microgbt::VectorT &features : {microgbt::VectorT({0}), microgbt::VectorT({1})})
+    {
+        microgbt::SplitInfo split = microgbt::NumericalSplitter(1.0).findBestSplit(dataset, gradient, hessian, features);
+        ASSERT_TRUE(split.hasPartition());
+        ASSERT_EQ(split.getBestFeatureId(), static_cast<long>(features[0]));
+        for (microgbt::SplitInfo::Side side : {microgbt::SplitInfo::Left, microgbt::SplitInfo::Right})
+        {
+            ASSERT_EQ(split.count(side), split.numLocalIds(side));
+            double sumG = 0.0, sumH = 0.0;
+            for (size_t i = 0; i < split.numLocalIds(side); i++)
+            {
+                sumG += gradient[split.localIds(side)[i]];
+                sumH += hessian[split.localIds(side)[i]];
+            }
+            ASSERT_NEAR(split.gradientSum(side), sumG, 1.0e-11);
+            ASSERT_NEAR(split.hessianSum(side), sumH, 1.0e-11);
+        }
+    }
+}
@@ -0,0 +1,182 @@
+#include <io/text_loader.h>
+#include <cstdio>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include "gtest/gtest.h"
+
+using namespace microgbt;
+
+namespace
+{
+std::string writeFile(const std::string &name, const std::string &contents)
+{
+    std::string path = testing::TempDir() + name;
+    std::ofstream file(path, std::ios::binary);
+    file << contents;
+    return path;
+}
+} // namespace
+
+TEST(TextLoader, ParseValue)
+{
+    double value;
+    for (const char *number : {"0", "-1.5", "+2.25e3", "0.1", "3.0000000000000004", "1e-300", "123456789012345678901",
+                               ".5", "5.", "-0.000123", "6.02214076E23", "inf"})
+    {
+        ASSERT_TRUE(TextLoader::parseValue(number, number + std::strlen(number), value));
+        ASSERT_EQ(value, std::strtod(number, nullptr));
+    }
+    for (const char *missing : {"", " ", "NA", "nan", "NULL", "?", "\"\""})
+    {
+        ASSERT_TRUE(TextLoader::parseValue(missing, missing + std::strlen(missing), value));
+        ASSERT_TRUE(std::isnan(value));
+    }
+    for (const char *invalid : {"male", "1.2.3", "1e", "-", "12a"})
+    {
+        ASSERT_FALSE(TextLoader::parseValue(invalid, invalid + std::strlen(invalid), value));
+    }
+}
+
+TEST(TextLoader, CSVWithHeaderLabelColumnAndColumnSelection)
+{
+    std::string path = writeFile("microgbt_loader.csv", "id,label,name,a,b\r\n"
+                                                        "1,0,\"Doe, John\",0.5,NA\r\n"
+                                                        "\r\n"
+                                                        "2,1,\"Roe, Jane\",,-2\r\n");
+
+    TextLoader::Options options;
+    options.header = true;
+    options.labelColumn = 1;
+    options.columns = {4, 3};
+    TextData data = TextLoader::load(path, options);
+
+    ASSERT_EQ(data.X.rows(), 2);
+    ASSERT_EQ(data.X.cols(), 2);
+    ASSERT_EQ(data.y[0], 0.0);
+    ASSERT_EQ(data.y[1], 1.0);
+    ASSERT_TRUE(std::isnan(data.X(0, 0)));
+    ASSERT_EQ(data.X(0, 1), 0.5);
+    ASSERT_EQ(data.X(1, 0), -2.0);
+    ASSERT_TRUE(std::isnan(data.X(1, 1)));
+
+    // Text columns are only parsed if they are selected
+    options.columns = {2};
+    ASSERT_THROW(TextLoader::load(path, options), std::runtime_error);
+    options.columns = {1};
+    ASSERT_THROW(TextLoader::load(path, options), std::invalid_argument);
+    std::remove(path.c_str());
+}
+
+TEST(TextLoader, ParallelParsingMatchesSequentialParsing)
+{
+    // Large enough to be split in several chunks
+    long m = 20000, n = 5;
+    std::ostringstream contents;
+    contents << std::setprecision(17);
+    for (long i = 0; i < m; i++)
+    {
+        contents << (i % 7) << '\t';
+        for (long j = 0; j < n; j++)
+        {
+            contents << std::sin(static_cast<double>(i * n + j)) * std::pow(10.0, static_cast<double>(j) - 2.0)
+                     << ((j + 1 < n) ? "\t" : "\n");
+        }
+    }
+    std::string path = writeFile("microgbt_loader.tsv", contents.str());
+
+    TextLoader::Options options;
+    options.numThreads = 1;
+    TextData sequential = TextLoader::load(path, options);
+    options.numThreads = 4;
+    TextData parallel = TextLoader::load(path, options);
+
+    ASSERT_EQ(sequential.X.rows(), m);
+    ASSERT_EQ(sequential.X.cols(), n);
+    ASSERT_TRUE(sequential.X == parallel.X);
+    ASSERT_TRUE(sequential.y == parallel.y);
+    for (long i = 0; i < m; i += 997)
+    {
+        ASSERT_EQ(parallel.y[i], static_cast<double>(i % 7));
+        ASSERT_EQ(parallel.X(i, 2), std::sin(static_cast<double>(i * n + 2)));
+    }
+    std::remove(path.c_str());
+}
+
+TEST(TextLoader, LibSVM)
+{
+    std::string path = writeFile("microgbt_loader.svm", "1 qid:3 1:0.5 4:2\n"
+                                                        "0 2:-1\n"
+                                                        "-1.5 1:nan 3:7 \n");
+
+    TextLoader::Options options;
+    options.format = TextFormat::LibSVM;
+    TextData data = TextLoader::load(path, options);
+
+    ASSERT_EQ(data.X.rows(), 3);
+    ASSERT_EQ(data.X.cols(), 4);
+    ASSERT_EQ(data.y[0], 1.0);
+    ASSERT_EQ(data.y[2], -1.5);
+    ASSERT_EQ(data.X(0, 0), 0.5);
+    ASSERT_EQ(data.X(0, 1), 0.0);
+    ASSERT_EQ(data.X(0, 3), 2.0);
+    ASSERT_EQ(data.X(1, 1), -1.0);
+    ASSERT_TRUE(std::isnan(data.X(2, 0)));
+    ASSERT_EQ(data.X(2, 2), 7.0);
+
+    options.columns = {3, 0};
+    data = TextLoader::load(path, options);
+    ASSERT_EQ(data.X.cols(), 2);
+    ASSERT_EQ(data.X(0, 0), 2.0);
+    ASSERT_EQ(data.X(0, 1), 0.5);
+
+    options.columns.clear();
+    options.numFeatures = 3;
+    ASSERT_THROW(TextLoader::load(path, options), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(TextLoader, LibSVMErrorsReportFileRows)
+{
+    // Large enough to be split in several chunks, with an invalid token in a row of a later chunk
+    long m = 30000, invalidRow = 25000;
+    std::ostringstream contents;
+    for (long i = 0; i < m; i++)
+    {
+        contents << (i % 2) << " 1:0.5 " << ((i == invalidRow) ? "invalid" : "2:0.25") << '\n';
+    }
+    std::string path = writeFile("microgbt_loader_invalid.svm", contents.str());
+
+    TextLoader::Options options;
+    options.format = TextFormat::LibSVM;
+    options.numThreads = 4;
+    try
+    {
+        TextLoader::load(path, options);
+        FAIL() << "Invalid token is not reported";
+    }
+    catch (const std::runtime_error &e)
+    {
+        ASSERT_EQ(std::string(e.what()).find("Cannot parse data row " + std::to_string(invalidRow + 1) + ":"), 0u);
+    }
+    std::remove(path.c_str());
+}
+
+TEST(TextLoader, DoubleDatasetViewsLoadedData)
+{
+    std::string path = writeFile("microgbt_loader_dataset.csv", "1 0.5 2\n0 1.5 3\n");
+
+    TextLoader::Options options;
+    std::shared_ptr<const TextData> data = std::make_shared<const TextData>(TextLoader::load(path, options));
+    Dataset dataset = TextLoader::dataset<double>(data);
+    ASSERT_EQ(dataset.X().data(), data->X.data());
+    ASSERT_EQ(dataset.y()[0], 1.0);
+    ASSERT_EQ(dataset.row(1)[1], 3.0);
+
+    BasicDataset<float> quantized = TextLoader::loadDataset<float>(path, options);
+    ASSERT_EQ(quantized.nRows(), 2);
+    ASSERT_EQ(quantized.row(0)[0], 0.5);
+    std::remove(path.c_str());
+}
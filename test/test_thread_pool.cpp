@@ -0,0 +1,27 @@
+#include <utils/thread_pool.h>
+#include "gtest/gtest.h"
+
+using namespace microgbt;
+
+TEST(ThreadPool, NumThreads)
+{
+    ThreadPool pool(4);
+    ASSERT_EQ(pool.numThreads(), 4);
+}
+
+TEST(ThreadPool, ParallelForRunsEveryTaskOnce)
+{
+    ThreadPool pool(4);
+    std::vector<int> counts(1000, 0);
+
+    // The pool is reused across loops
+    for (int loop = 0; loop < 10; loop++)
+    {
+        pool.parallelFor(counts.size(), [&](size_t i) { counts[i]++; });
+    }
+
+    for (int count : counts)
+    {
+        ASSERT_EQ(count, 10);
+    }
+}
@@ -1,3 +1,4 @@
+#include <cmath>
 #include <trees/tree.h>
 #include "gtest/gtest.h"
 
@@ -6,3 +7,74 @@ TEST(microgbt, Tree)
     microgbt::Tree tree(0.0, 0.0, 0.0, 10);
     ASSERT_TRUE(true);
 }
+
+TEST(microgbt, TreeBuildTrainScoresAgreeWithScore)
+{
+    long m = 50, n = 3;
+    Eigen::MatrixXd X(m, n);
+    microgbt::Vector y(m), preds(m, 0.5), gradient(m), hessian(m, 1.0);
+    for (long i = 0; i < m; i++)
+    {
+        // Few distinct values per feature, so that ties occur at split boundaries
+        X(i, 0) = static_cast<double>(i % 5);
+        X(i, 1) = static_cast<double>((i * 7) % 3);
+        X(i, 2) = static_cast<double>(i) / m;
+        y[i] = (i % 5 < 2) ? 1.0 : 0.0;
+        gradient[i] = preds[i] - y[i];
+    }
+    microgbt::Dataset dataset(X, y);
+
+    microgbt::Tree tree(1.0, 0.0, 2.0, 3);
+    microgbt::Vector trainScores(m, 0.0);
+    tree.build(dataset, preds, gradient, hessian, 1.0, trainScores);
+
+    for (long i = 0; i < m; i++)
+    {
+        ASSERT_NEAR(trainScores[i], tree.score(X.row(i)), 1.0e-11);
+    }
+}
+
+static long numLeaves(const microgbt::TreeNode *node)
+{
+    return node->isLeaf() ? 1 : numLeaves(node->left()) + numLeaves(node->right());
+}
+
+TEST(microgbt, TreeBuildLeafWise)
+{
+    long m = 200, n = 3;
+    Eigen::MatrixXd X(m, n);
+    microgbt::Vector y(m), preds(m, 0.5), gradient(m), hessian(m, 1.0);
+    for (long i = 0; i < m; i++)
+    {
+        X(i, 0) = static_cast<double>(i % 7);
+        X(i, 1) = static_cast<double>((i * 13) % 11);
+        X(i, 2) = static_cast<double>(i) / m;
+        y[i] = std::sin(X(i, 0)) + 0.1 * X(i, 1) + X(i, 2);
+        gradient[i] = preds[i] - y[i];
+    }
+    microgbt::Dataset dataset(X, y);
+    auto splitter = std::make_shared<microgbt::NumericalSplitter>(1.0);
+
+    // The leaf budget is reached and each sample is scored by the leaf that it reaches
+    microgbt::Tree leafWise(1.0, 0.0, 2.0, 10, splitter, 5);
+    microgbt::Vector trainScores(m, 0.0);
+    leafWise.build(dataset, preds, gradient, hessian, 1.0, trainScores);
+    ASSERT_EQ(numLeaves(leafWise.root()), 5);
+    for (long i = 0; i < m; i++)
+    {
+        ASSERT_NEAR(trainScores[i], leafWise.score(X.row(i)), 1.0e-11);
+    }
+
+    // With an unbounded leaf budget, the tree is the depth-wise one
+    microgbt::Tree depthWise(1.0, 0.0, 2.0, 3, splitter);
+    microgbt::Tree unbounded(1.0, 0.0, 2.0, 3, splitter, 1 << 20);
+    microgbt::Vector depthWiseScores(m, 0.0), unboundedScores(m, 0.0);
+    depthWise.build(dataset, preds, gradient, hessian, 1.0, depthWiseScores);
+    unbounded.build(dataset, preds, gradient, hessian, 1.0, unboundedScores);
+    ASSERT_EQ(numLeaves(unbounded.root()), numLeaves(depthWise.root()));
+    for (long i = 0; i < m; i++)
+    {
+        ASSERT_EQ(unbounded.score(X.row(i)), depthWise.score(X.row(i)));
+        ASSERT_EQ(unboundedScores[i], depthWiseScores[i]);
+    }
+}